@@ -0,0 +1,478 @@
+// sit_bench.cpp microbenchmarks and end-to-end runs for hashing, manifests and /proc collectors
+#include "integrity.h"
+#include "integrityDetail.h"
+#include "procfs.h"
+#include "systemInfo.h"
+#include "diskStats.h"
+#include "netStats.h"
+#include "pressure.h"
+#include "memory.h"
+#include "schedStats.h"
+#include "snapshot.h"
+#include "health.h"
+#include "scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every heap allocation in the process is counted so each benchmark can
+// report allocations per operation alongside its timings
+namespace {
+    std::atomic<uint64_t> allocations{ 0 };
+}
+
+// The replacements below pair malloc with free by design
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    namespace fs = std::filesystem;
+
+    struct Options {
+        std::string filter;
+        std::string jsonPath;
+        std::string label;
+        std::string fixtures = "bench/fixtures/linux-vm";
+        fs::path tree = fs::temp_directory_path();     // Parent of the scratch directory
+        std::string distribution = "mixed";
+        uint64_t files = 10000;
+        bool keepTree = false;
+        bool quick = false;
+    };
+
+    struct Result {
+        std::string name;
+        uint64_t operations = 0;
+        double nsPerOp = 0.0;
+        double p50Ns = 0.0;
+        double p99Ns = 0.0;
+        double opsPerSec = 0.0;
+        double gbPerSec = 0.0;
+        double itemsPerSec = 0.0;
+        double allocsPerOp = 0.0;
+    };
+
+    Options options;
+    std::vector<Result> results;
+    fs::path scratch;       // Created fresh under options.tree; the only directory the bench removes
+
+    bool selected(const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // Runs fn in `samples` timed batches of `batch` calls each. Latency
+    // percentiles are per call, averaged within a batch so tiny operations are
+    // not dominated by clock overhead.
+    template <typename Fn>
+    void measure(const std::string& name, int samples, int batch, double bytesPerOp, double itemsPerOp, Fn&& fn) {
+        if (!selected(name)) {
+            return;
+        }
+        if (options.quick) {
+            samples = std::max(3, samples / 4);
+        }
+        std::vector<double> latencies(static_cast<size_t>(samples));
+        for (int i = 0; i < std::min(batch, 10); ++i) {
+            fn();
+        }
+
+        uint64_t allocsBefore = allocations.load(std::memory_order_relaxed);
+        auto began = Clock::now();
+        for (int s = 0; s < samples; ++s) {
+            auto start = Clock::now();
+            for (int i = 0; i < batch; ++i) {
+                fn();
+            }
+            latencies[s] = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / batch;
+        }
+        double totalSec = std::chrono::duration<double>(Clock::now() - began).count();
+        uint64_t allocs = allocations.load(std::memory_order_relaxed) - allocsBefore;
+
+        Result result;
+        result.name = name;
+        result.operations = static_cast<uint64_t>(samples) * batch;
+        result.nsPerOp = totalSec * 1e9 / result.operations;
+        std::sort(latencies.begin(), latencies.end());
+        result.p50Ns = latencies[latencies.size() / 2];
+        result.p99Ns = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.opsPerSec = result.operations / totalSec;
+        result.gbPerSec = bytesPerOp * result.opsPerSec / 1e9;
+        result.itemsPerSec = itemsPerOp * result.opsPerSec;
+        result.allocsPerOp = static_cast<double>(allocs) / result.operations;
+        results.push_back(result);
+
+        std::cerr << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.nsPerOp << " ns/op" << std::setw(12) << result.p99Ns << " p99"
+                  << std::setprecision(3) << std::setw(10) << result.gbPerSec << " GB/s"
+                  << std::setprecision(0) << std::setw(12) << result.itemsPerSec << " items/s"
+                  << std::setprecision(2) << std::setw(9) << result.allocsPerOp << " allocs/op" << std::endl;
+    }
+
+    // Deterministic incompressible bytes shared by every generated file
+    const std::vector<char>& noise() {
+        static std::vector<char> bytes = [] {
+            std::vector<char> data(1 << 20);
+            std::mt19937_64 rng(42);
+            for (auto& byte : data) {
+                byte = static_cast<char>(rng());
+            }
+            return data;
+        }();
+        return bytes;
+    }
+
+    void writeFile(const fs::path& path, uint64_t size, uint64_t salt) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        const std::vector<char>& bytes = noise();
+        // The salt makes every file's content, and so its hash, distinct
+        out.write(reinterpret_cast<const char*>(&salt), static_cast<std::streamsize>(std::min<uint64_t>(size, sizeof(salt))));
+        uint64_t written = std::min<uint64_t>(size, sizeof(salt));
+        size_t offset = static_cast<size_t>(salt % bytes.size());
+        while (written < size) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(size - written, bytes.size() - offset));
+            out.write(bytes.data() + offset, static_cast<std::streamsize>(chunk));
+            written += chunk;
+            offset = 0;
+        }
+    }
+
+    // File sizes for the synthetic tree. "small": up to 4 KiB. "mixed": 80% up
+    // to 4 KiB, 19% up to 64 KiB, 1% up to 1 MiB. "large": 1-8 MiB.
+    // "fixed:N": every file N bytes.
+    uint64_t drawSize(std::mt19937_64& rng, const std::string& distribution) {
+        auto uniform = [&rng](uint64_t low, uint64_t high) {
+            return std::uniform_int_distribution<uint64_t>(low, high)(rng);
+        };
+        if (distribution == "small") {
+            return uniform(0, 4096);
+        }
+        if (distribution == "large") {
+            return uniform(1 << 20, 8 << 20);
+        }
+        if (distribution.compare(0, 6, "fixed:") == 0) {
+            return std::stoull(distribution.substr(6));
+        }
+        uint64_t bucket = uniform(0, 99);
+        if (bucket < 80) {
+            return uniform(0, 4096);
+        }
+        return bucket < 99 ? uniform(4096, 64 << 10) : uniform(64 << 10, 1 << 20);
+    }
+
+    // A new directory under --tree, so cleanup never touches anything that was there before
+    bool makeScratch() {
+        std::error_code ec;
+        fs::create_directories(options.tree, ec);
+        uint64_t stamp = static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            fs::path candidate = options.tree / ("sit_bench-" + std::to_string(stamp + attempt));
+            if (fs::create_directory(candidate, ec)) {
+                scratch = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Lays files out 1000 to a directory, 100 directories per level, so even
+    // millions of files keep directory sizes realistic. Returns total bytes.
+    uint64_t generateTree(const fs::path& root, uint64_t files, const std::string& distribution) {
+        fs::remove_all(root);
+        fs::create_directories(root);
+        std::mt19937_64 rng(7);
+        uint64_t totalBytes = 0;
+        char name[64];
+        for (uint64_t i = 0; i < files; ++i) {
+            uint64_t leaf = i / 1000;
+            std::snprintf(name, sizeof(name), "d%03llu/d%03llu", static_cast<unsigned long long>(leaf / 100),
+                static_cast<unsigned long long>(leaf % 100));
+            fs::path dir = root / name;
+            if (i % 1000 == 0) {
+                fs::create_directories(dir);
+            }
+            std::snprintf(name, sizeof(name), "f%07llu.dat", static_cast<unsigned long long>(i));
+            uint64_t size = drawSize(rng, distribution);
+            writeFile(dir / name, size, i);
+            totalBytes += size;
+        }
+        return totalBytes;
+    }
+
+    void benchHashing() {
+        std::vector<uint8_t> buffer(noise().begin(), noise().end());
+        measure("sha256/update_1MiB", 64, 1, buffer.size(), 0, [&] {
+            Integrity::detail::Sha256 hasher;
+            hasher.update(buffer.data(), buffer.size());
+            hasher.finalHex();
+        });
+        measure("sha256/update_64B", 200, 1000, 64, 0, [&] {
+            Integrity::detail::Sha256 hasher;
+            hasher.update(buffer.data(), 64);
+            hasher.finalHex();
+        });
+
+        fs::path file = scratch / "hash_16MiB.dat";
+        const uint64_t size = 16 << 20;
+        writeFile(file, size, 1);
+        measure("hash_file/16MiB_cached", 16, 1, size, 1, [&] {
+            Integrity::detail::hashFileSha256(file, nullptr);
+        });
+        std::string fingerprint;
+        const uint64_t seed = Integrity::detail::fileSeed(file.filename().string(), size);
+        measure("hash_file/16MiB_cached_fingerprint", 16, 1, size, 1, [&] {
+            Integrity::detail::hashFileSha256(file, nullptr, nullptr, &fingerprint, size, seed);
+        });
+        uint64_t sampledBytes = Integrity::detail::sampleBlocks(size, seed).size() * Integrity::detail::kSampleBlockSize;
+        measure("sample_file/16MiB_cached", 64, 1, sampledBytes, 1, [&] {
+            Integrity::detail::sampleFingerprint(file, size, seed, nullptr);
+        });
+        fs::remove(file);
+    }
+
+    void benchManifest() {
+        const std::string line = "src/module/component/file_0001234.cpp\t48213\t1718000000\t"
+            "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08";
+        std::string path;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::string hash;
+        measure("manifest/parse_line", 200, 1000, line.size(), 1, [&] {
+            Integrity::detail::parseManifestLine(line, path, size, mtime, hash);
+        });
+
+        const int entries = 100000;
+        fs::path manifestPath = scratch / "bench.manifest";
+        uint64_t manifestBytes = 0;
+        {
+            std::ofstream out(manifestPath, std::ios::binary | std::ios::trunc);
+            out << Integrity::detail::kManifestHeader << "\n";
+            for (int i = 0; i < entries; ++i) {
+                out << "dir" << i / 1000 << "/file_" << i << ".dat\t" << i * 37 << "\t" << 1718000000 + i
+                    << "\t9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08\n";
+            }
+            manifestBytes = static_cast<uint64_t>(out.tellp());
+        }
+        std::unordered_map<std::string, Integrity::detail::ManifestEntry> loaded;
+        measure("manifest/load_100k", 10, 1, manifestBytes, entries, [&] {
+            loaded.clear();
+            Integrity::detail::loadManifest(manifestPath, loaded, nullptr);
+        });
+        fs::remove(manifestPath);
+    }
+
+#ifndef _WIN32
+    // Collectors parse recorded files so results do not depend on the machine's live state
+    void benchCollectors() {
+        if (!fs::exists(fs::path(options.fixtures) / "proc" / "stat")) {
+            std::cerr << "Skipping collectors: no fixtures at " << options.fixtures << std::endl;
+            return;
+        }
+        ProcFS::setRoot(options.fixtures);
+        SystemInfo::CpuSampler cpu;
+        measure("collector/cpu_times", 100, 100, 0, 1, [&] { cpu.sample(); });
+        measure("collector/ram_usage", 100, 100, 0, 1, [] { SystemInfo::getRamUsage(); });
+        measure("collector/uptime", 100, 100, 0, 1, [] { SystemInfo::getUptime(); });
+        double load1 = 0.0;
+        double load5 = 0.0;
+        double load15 = 0.0;
+        measure("collector/load_average", 100, 100, 0, 1, [&] { SystemInfo::getLoadAverage(load1, load5, load15); });
+        DiskStats::Sampler disk;
+        measure("collector/diskstats", 100, 100, 0, 1, [&] { disk.sample(); });
+        NetStats::Sampler net;
+        measure("collector/netstats", 100, 100, 0, 1, [&] { net.sample(); });
+        Memory::Sampler memory;
+        measure("collector/meminfo_vmstat", 100, 100, 0, 1, [&] { memory.sample(); });
+        std::string meminfo;
+        ProcFS::readFile("/proc/meminfo", meminfo);
+        Memory::Info info;
+        measure("collector/meminfo_parse", 100, 1000, meminfo.size(), 1, [&] {
+            Memory::parseInfo(meminfo.data(), meminfo.size(), info);
+        });
+        measure("collector/pressure_cpu", 100, 100, 0, 1, [] { Pressure::read("cpu"); });
+        SchedStats::Sampler sched;
+        measure("collector/schedstat", 100, 100, 0, 1, [&] { sched.sample(); });
+        ProcFS::setRoot("");
+    }
+#endif
+
+    // Scoring and scanning a snapshot where most rules fire; both should not allocate
+    void benchReports() {
+        auto snapshot = std::make_unique<Metrics::Snapshot>();
+        snapshot->ratesReady = Metrics::RatesReady{ 1, 1, 1, 1, 1, 1, 1 };
+        snapshot->threads = 4;
+        snapshot->cpuUsage = snapshot->cpuUsageSmoothed = 92.0;
+        snapshot->ramUsage = snapshot->ramUsageSmoothed = 88.0;
+        snapshot->uptimeSeconds = 40 * 24 * 3600;
+        snapshot->cpuTempC = 90.0;
+        snapshot->mountCount = Metrics::kMaxMounts;
+        for (int i = 0; i < snapshot->mountCount; ++i) {
+            Metrics::MountEntry& mount = snapshot->mounts[i];
+            std::snprintf(mount.mountPoint, sizeof(mount.mountPoint), "/srv/volume%02d", i);
+            mount.usagePercent = 91.0 + i % 5;
+            mount.inodeUsagePercent = 82.0;
+        }
+        snapshot->diskCount = Metrics::kMaxDisks;
+        for (int i = 0; i < snapshot->diskCount; ++i) {
+            std::snprintf(snapshot->disks[i].name, sizeof(snapshot->disks[i].name), "sd%c", 'a' + i);
+            snapshot->disks[i].utilization = 95.0;
+        }
+        Health::Inputs inputs = Metrics::healthInputs(*snapshot);
+        measure("report/health_evaluate", 100, 1000, 0, 1, [&] { Health::evaluate(inputs); });
+        Scan::Result findings;
+        measure("report/scan", 100, 1000, 0, 1, [&] { Scan::scan(*snapshot, findings); });
+    }
+
+    void benchEndToEnd() {
+        if (!selected("integrity/")) {
+            return;
+        }
+        std::cerr << "Generating " << options.files << " files (" << options.distribution << ") in "
+                  << scratch.string() << "..." << std::endl;
+        fs::path root = scratch / "tree";
+        uint64_t bytes = generateTree(root, options.files, options.distribution);
+        double files = static_cast<double>(options.files);
+        std::string error;
+
+        measure("integrity/init", 3, 1, bytes, files, [&] {
+            fs::remove(root / Integrity::kManifestFileName);
+            Integrity::createManifest(root, &error);
+        });
+        Integrity::CheckResult result;
+        measure("integrity/check_unchanged", 5, 1, 0, files, [&] {
+            Integrity::checkManifest(root, result, &error);
+        });
+        measure("integrity/update", 3, 1, bytes, files, [&] {
+            Integrity::updateManifest(root, &error);
+        });
+    }
+
+    void writeJson(std::ostream& out) {
+        out << "{\n  \"suite\": \"sit_bench\",\n  \"version\": 1,\n  \"label\": \"" << options.label << "\",\n"
+            << "  \"files\": " << options.files << ",\n  \"distribution\": \"" << options.distribution << "\",\n"
+            << "  \"results\": [";
+        out << std::setprecision(6);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"operations\": " << r.operations
+                << ", \"ns_per_op\": " << r.nsPerOp << ", \"p50_ns\": " << r.p50Ns << ", \"p99_ns\": " << r.p99Ns
+                << ", \"ops_per_sec\": " << r.opsPerSec << ", \"gb_per_sec\": " << r.gbPerSec
+                << ", \"items_per_sec\": " << r.itemsPerSec << ", \"allocs_per_op\": " << r.allocsPerOp << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void printUsage() {
+        std::cout << "Usage: sit_bench [options]\n"
+                  << "  --filter <text>      Run only benchmarks whose name contains text\n"
+                  << "  --json <file>        Write results as JSON to file (default: stdout)\n"
+                  << "  --label <text>       Free-form label stored in the JSON, e.g. a commit id\n"
+                  << "  --fixtures <dir>     Recorded /proc and /sys root (default bench/fixtures/linux-vm)\n"
+                  << "  --files <n>          Files in the synthetic tree (default 10000)\n"
+                  << "  --dist <name>        small | mixed | large | fixed:<bytes> (default mixed)\n"
+                  << "  --tree <dir>         Where to create the scratch directory for generated data\n"
+                  << "                       (default: the system temp directory)\n"
+                  << "  --keep-tree          Leave the scratch directory in place\n"
+                  << "  --quick              Fewer samples, for CI smoke runs\n";
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            return i + 1 < argc ? argv[++i] : std::string();
+        };
+        if (arg == "--filter") {
+            options.filter = value();
+        } else if (arg == "--json") {
+            options.jsonPath = value();
+        } else if (arg == "--label") {
+            options.label = value();
+        } else if (arg == "--fixtures") {
+            options.fixtures = value();
+        } else if (arg == "--files") {
+            options.files = std::stoull(value());
+        } else if (arg == "--dist") {
+            options.distribution = value();
+        } else if (arg == "--tree") {
+            options.tree = value();
+        } else if (arg == "--keep-tree") {
+            options.keepTree = true;
+        } else if (arg == "--quick") {
+            options.quick = true;
+        } else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    if (!makeScratch()) {
+        std::cerr << "Cannot create a scratch directory under " << options.tree.string() << std::endl;
+        return 1;
+    }
+    benchHashing();
+    benchManifest();
+#ifndef _WIN32
+    benchCollectors();
+#endif
+    benchReports();
+    benchEndToEnd();
+
+    if (options.keepTree) {
+        std::cerr << "Kept generated data in " << scratch.string() << std::endl;
+    } else {
+        std::error_code ec;
+        fs::remove_all(scratch, ec);
+    }
+    if (options.jsonPath.empty()) {
+        writeJson(std::cout);
+    } else {
+        std::ofstream out(options.jsonPath);
+        writeJson(out);
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// cgroup.cpp cgroup v2 accounting implementation
+#include "cgroup.h"
+#include "procfs.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <filesystem>     // For locating the unified hierarchy
+#endif
+
+namespace Cgroup {
+namespace {
+    constexpr const char kMountPoint[] = "/sys/fs/cgroup";
+
+    std::string resolvePath() {
+#ifdef _WIN32
+        return std::string();
+#else
+        std::error_code ec;
+        // Probed under the ProcFS root; the returned path stays unprefixed like every ProcFS path
+        if (!std::filesystem::exists(ProcFS::path(kMountPoint) + "/cgroup.controllers", ec)) {
+            return std::string();
+        }
+        // The unified hierarchy is the "0::<path>" entry
+        std::string buffer;
+        if (!ProcFS::readFile("/proc/self/cgroup", buffer)) {
+            return std::string();
+        }
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (eol - p >= 3 && std::strncmp(p, "0::", 3) == 0) {
+                std::string relative(p + 3, eol);
+                std::string full = std::string(kMountPoint) + (relative == "/" ? "" : relative);
+                // Inside a cgroup namespace the listed path may not exist under our mount
+                if (std::filesystem::exists(ProcFS::path(full.c_str()) + "/cgroup.procs", ec)) {
+                    return full;
+                }
+                return kMountPoint;
+            }
+            p = eol + 1;
+        }
+        return std::string();
+#endif
+    }
+
+    // Reads a single-value control file; "max" reads as 0 and sets unlimited
+    bool readValue(const std::string& file, std::string& buffer, uint64_t& value, bool* unlimited = nullptr) {
+        if (!ProcFS::readSource((path() + "/" + file).c_str(), buffer) || buffer.empty()) {
+            return false;
+        }
+        if (buffer.compare(0, 3, "max") == 0) {
+            value = 0;
+            if (unlimited) {
+                *unlimited = true;
+            }
+            return true;
+        }
+        const char* p = buffer.data();
+        value = ProcFS::parseU64(p, p + buffer.size());
+        return true;
+    }
+
+    // Returns the value of "key value" in a flat keyed file such as cpu.stat
+    uint64_t keyedValue(const std::string& text, const char* key) {
+        size_t keyLen = std::strlen(key);
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (static_cast<size_t>(eol - p) > keyLen && std::strncmp(p, key, keyLen) == 0 && p[keyLen] == ' ') {
+                const char* value = p + keyLen;
+                return ProcFS::parseU64(value, eol);
+            }
+            p = eol + 1;
+        }
+        return 0;
+    }
+
+    // Sums a field such as "rbytes=" over every device line of io.stat
+    uint64_t sumIoField(const std::string& text, const char* key) {
+        size_t keyLen = std::strlen(key);
+        uint64_t total = 0;
+        const char* p = text.data();
+        const char* end = p + text.size();
+        for (; p + keyLen < end; ++p) {
+            if (std::strncmp(p, key, keyLen) == 0 && (p == text.data() || p[-1] == ' ')) {
+                const char* value = p + keyLen;
+                total += ProcFS::parseU64(value, end);
+            }
+        }
+        return total;
+    }
+} // namespace
+
+    const std::string& path() {
+        static const std::string resolved = resolvePath();
+        return resolved;
+    }
+
+    Memory readMemory() {
+        Memory memory;
+        if (!available()) {
+            return memory;
+        }
+        std::string buffer;
+        bool unlimited = false;
+        if (!readValue("memory.current", buffer, memory.current)) {
+            return memory;
+        }
+        memory.available = true;
+        if (!readValue("memory.max", buffer, memory.max, &unlimited) || unlimited) {
+            memory.max = 0;
+        }
+        uint64_t inactiveFile = 0;
+        if (ProcFS::readSource((path() + "/memory.stat").c_str(), buffer)) {
+            inactiveFile = keyedValue(buffer, "inactive_file");
+        }
+        memory.workingSet = memory.current > inactiveFile ? memory.current - inactiveFile : 0;
+        return memory;
+    }
+
+    CpuLimit readCpuLimit() {
+        CpuLimit limit;
+        if (!available()) {
+            return limit;
+        }
+        std::string buffer;
+        if (!ProcFS::readSource((path() + "/cpu.max").c_str(), buffer) || buffer.empty()) {
+            return limit;
+        }
+        // Format: "<quota|max> <period>"
+        if (buffer.compare(0, 3, "max") == 0) {
+            return limit;
+        }
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        uint64_t quota = ProcFS::parseU64(p, end);
+        uint64_t period = ProcFS::parseU64(p, end);
+        if (quota > 0 && period > 0) {
+            limit.limited = true;
+            limit.quotaCores = static_cast<double>(quota) / static_cast<double>(period);
+        }
+        return limit;
+    }
+
+    Pressure::Stall readMemoryPressure() {
+        if (!available()) {
+            return Pressure::Stall{};
+        }
+        return Pressure::readFile(path() + "/memory.pressure");
+    }
+
+    bool Sampler::sample() {
+        if (!available()) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (samples == 0) {
+            limit = readCpuLimit();
+        }
+
+        Counters c;
+        if (ProcFS::readSource((path() + "/cpu.stat").c_str(), buffer)) {
+            c.usageUsec = keyedValue(buffer, "usage_usec");
+            c.periods = keyedValue(buffer, "nr_periods");
+            c.throttled = keyedValue(buffer, "nr_throttled");
+            c.throttledUsec = keyedValue(buffer, "throttled_usec");
+        }
+        if (ProcFS::readSource((path() + "/io.stat").c_str(), buffer)) {
+            c.readBytes = sumIoField(buffer, "rbytes=");
+            c.writeBytes = sumIoField(buffer, "wbytes=");
+            c.readIos = sumIoField(buffer, "rios=");
+            c.writeIos = sumIoField(buffer, "wios=");
+        }
+        current.totalPeriods = c.periods;
+        current.totalThrottled = c.throttled;
+
+        if (samples > 0) {
+            double seconds = std::chrono::duration<double>(now - lastSample).count();
+            if (seconds > 0.0) {
+                using ProcFS::delta;
+                current.cpuCores = static_cast<double>(delta(c.usageUsec, previous.usageUsec)) / 1e6 / seconds;
+                current.cpuQuotaPercent = limit.limited ? current.cpuCores / limit.quotaCores * 100.0 : 0.0;
+                uint64_t periods = delta(c.periods, previous.periods);
+                current.throttledPercent = periods
+                    ? static_cast<double>(delta(c.throttled, previous.throttled)) / periods * 100.0
+                    : 0.0;
+                current.throttledMsPerSec = static_cast<double>(delta(c.throttledUsec, previous.throttledUsec)) / 1000.0 / seconds;
+                current.readBytesPerSec = static_cast<double>(delta(c.readBytes, previous.readBytes)) / seconds;
+                current.writeBytesPerSec = static_cast<double>(delta(c.writeBytes, previous.writeBytes)) / seconds;
+                current.readIops = static_cast<double>(delta(c.readIos, previous.readIos)) / seconds;
+                current.writeIops = static_cast<double>(delta(c.writeIos, previous.writeIos)) / seconds;
+            }
+        }
+        previous = c;
+        lastSample = now;
+        ++samples;
+        return true;
+    }
+}
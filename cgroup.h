@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include "pressure.h"
+
+// Cgroup namespace encapsulating cgroup v2 resource accounting for the
+// cgroup this process runs in (the container, on containerised hosts)
+namespace Cgroup {
+
+    // Returns the cgroup v2 directory of this process, or an empty string when
+    // the host does not use the unified hierarchy. Resolved once per process.
+    const std::string& path();
+
+    inline bool available() { return !path().empty(); }
+
+    struct Memory {
+        bool available = false;
+        uint64_t current = 0;       // memory.current in bytes
+        uint64_t workingSet = 0;    // current minus inactive file cache
+        uint64_t max = 0;           // memory.max in bytes, 0 when unlimited
+    };
+
+    struct CpuLimit {
+        bool limited = false;
+        double quotaCores = 0.0;    // cpu.max quota / period
+    };
+
+    // Reads memory.current, memory.max and memory.stat
+    Memory readMemory();
+
+    // Reads the cpu.max quota
+    CpuLimit readCpuLimit();
+
+    // Reads memory.pressure (PSI format)
+    Pressure::Stall readMemoryPressure();
+
+    // Rates derived from cpu.stat and io.stat between two samples
+    struct Rates {
+        double cpuCores = 0.0;          // CPU time consumed, in cores
+        double cpuQuotaPercent = 0.0;   // cpuCores as a share of the cpu.max quota
+        double throttledPercent = 0.0;  // Share of enforcement periods that were throttled
+        double throttledMsPerSec = 0.0;
+        double readBytesPerSec = 0.0;
+        double writeBytesPerSec = 0.0;
+        double readIops = 0.0;
+        double writeIops = 0.0;
+        uint64_t totalPeriods = 0;      // Lifetime counters from cpu.stat
+        uint64_t totalThrottled = 0;
+    };
+
+    class Sampler {
+    public:
+        // Returns false when not running under cgroup v2
+        bool sample();
+        bool ready() const { return samples >= 2; }
+        const Rates& rates() const { return current; }
+        const CpuLimit& cpuLimit() const { return limit; }
+
+    private:
+        struct Counters {
+            uint64_t usageUsec = 0;
+            uint64_t periods = 0;
+            uint64_t throttled = 0;
+            uint64_t throttledUsec = 0;
+            uint64_t readBytes = 0;
+            uint64_t writeBytes = 0;
+            uint64_t readIos = 0;
+            uint64_t writeIos = 0;
+        };
+
+        Counters previous;
+        Rates current;
+        CpuLimit limit;
+        std::string buffer;
+        std::chrono::steady_clock::time_point lastSample;
+        int samples = 0;
+    };
+}
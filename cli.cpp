@@ -1,12 +1,25 @@
 #include "systemInfo.h"
 #include "health.h"
 #include "integrity.h"
+#include "sensors.h"
 #include "cli.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "fleet.h"
+#include "scan.h"
 #include <string>
 #include <vector>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <cstdlib>
 
 // ANSI color codes
 #define RESET       "\033[0m"
@@ -22,10 +35,44 @@
 #define ORANGE      "\033[38;5;208m"
 #define COFFEE     "\033[38;5;94m"
 
+namespace {
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void requestStop(int) {
+        stopRequested = 1;
+    }
+
+    // Sends std::cout to another buffer until the end of the scope, also when a command throws
+    class CoutRedirect {
+    public:
+        explicit CoutRedirect(std::streambuf* target) : console(std::cout.rdbuf(target)) {}
+        ~CoutRedirect() { std::cout.rdbuf(console); }
+
+        CoutRedirect(const CoutRedirect&) = delete;
+        CoutRedirect& operator=(const CoutRedirect&) = delete;
+
+    private:
+        std::streambuf* console;
+    };
+}
+
 // CLI class constructor
 CLI::CLI(int argc, char* argv[]) {
     for (int i = 1; i < argc; ++i) {
-        args.push_back(argv[i]);
+        std::string arg = argv[i];
+        if (arg == "--from-shm") {
+            fromShm = true;
+        } else if (arg == "--shm-name" && i + 1 < argc) {
+            shmName = argv[++i];
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--top-memory" && i + 1 < argc) {
+            collector.setTopProcesses(std::atoi(argv[++i]));
+        } else {
+            args.push_back(arg);
+        }
     }
     if (!args.empty()) {
         interactive = false;
@@ -34,29 +81,191 @@ CLI::CLI(int argc, char* argv[]) {
 
 // Run the CLI based on provided arguments or enter interactive mode
 void CLI::run() {
+    if (profile || !tracePath.empty()) {
+        Profile::enable(!tracePath.empty());
+    }
     if (interactive) {
         interactiveMode();
-    } else {
-        if (args[0] == "--help" || args[0] == "-h" || args[0] == "help") {
-            showHelp();
-        } else if (args[0] == "--version" || args[0] == "-v" || args[0] == "version") {
-            showVersion();
-        } else if (args[0] == "info") {
-            showInfo();
-        } else if (args[0] == "usage") {
-            showUsage();
-        } else if (args[0] == "health") {
-            showHealth();
-        } else if (args[0] == "scan") {
-            showScan();
-        } else if (args[0] == "all") {
-            showAll();
-        } else if (args[0] == "integrity") {
-            showIntegrity(args);
+    } else if (!runCommand(args)) {
+        std::cout << RED << "Unknown command. Use --help for usage." << RESET << std::endl;
+    }
+    // Profile output goes to stderr so it never mixes with report output
+    if (profile) {
+        Profile::report(std::cerr);
+    }
+    if (!tracePath.empty()) {
+        std::string error;
+        if (Profile::writeTrace(tracePath, &error)) {
+            std::cerr << "Trace written to " << tracePath << std::endl;
         } else {
-            std::cout << RED << "Unknown command. Use --help for usage." << RESET << std::endl;
+            std::cerr << RED << error << RESET << std::endl;
+        }
+    }
+}
+
+// Fills snapshot from shared memory when --from-shm is set, otherwise collects it
+bool CLI::takeSnapshot(Metrics::Snapshot& snapshot, bool quiet) {
+    if (!fromShm) {
+        collector.collect(snapshot);
+        // Sections that missed their deadline are reported with their last good values
+        for (int i = 0; i < Metrics::kSectionCount && !quiet; ++i) {
+            auto state = static_cast<Metrics::SectionState>(snapshot.sectionState[i]);
+            if (state == Metrics::SectionState::Fresh) {
+                continue;
+            }
+            std::cout << YELLOW << "Note: " << Metrics::sectionName(static_cast<Metrics::Section>(i))
+                      << (state == Metrics::SectionState::TimedOut ? " collection timed out"
+                                                                    : " collection is still blocked from an earlier run");
+            if (snapshot.sectionTimestampMs[i] == 0) {
+                std::cout << "; no data yet";
+            } else {
+                std::cout << "; showing values from "
+                          << (snapshot.timestampMs - snapshot.sectionTimestampMs[i]) / 1000 << " s ago";
+            }
+            std::cout << RESET << std::endl;
+        }
+        return true;
+    }
+    std::string error;
+    if (!shmReader) {
+        auto reader = std::make_unique<SharedMetrics::Reader>();
+        if (!reader->open(shmName, &error)) {
+            std::cout << RED << error << RESET << std::endl;
+            return false;
+        }
+        shmReader = std::move(reader);
+    }
+    if (!shmReader->read(snapshot, &error)) {
+        std::cout << RED << error << RESET << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Dispatches a single command shared by command-line and interactive modes
+bool CLI::runCommand(const std::vector<std::string>& tokens) {
+    if (tokens.empty()) {
+        return true;
+    }
+    const std::string& cmd = tokens[0];
+    if (cmd == "--help" || cmd == "-h" || cmd == "help") {
+        showHelp();
+    } else if (cmd == "--version" || cmd == "-v" || cmd == "version") {
+        showVersion();
+    } else if (cmd == "integrity") {
+        showIntegrity(tokens);
+    } else if (cmd == "publish") {
+        runPublisher(tokens);
+    } else if (cmd == "batch") {
+        runBatch(tokens);
+    } else if (cmd == "export") {
+        exportSnapshot(tokens);
+    } else if (cmd == "aggregate") {
+        runAggregate(tokens);
+    } else if (isReport(cmd)) {
+        auto snapshot = std::make_unique<Metrics::Snapshot>();
+        if (takeSnapshot(*snapshot)) {
+            showReport(*snapshot, tokens);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool CLI::isReport(const std::string& cmd) {
+    return cmd == "info" || cmd == "usage" || cmd == "health" || cmd == "scan"
+        || cmd == "sensors" || cmd == "all";
+}
+
+// Renders one report command from an already taken snapshot
+void CLI::showReport(const Metrics::Snapshot& snapshot, const std::vector<std::string>& tokens) {
+    const std::string& cmd = tokens[0];
+    if (cmd == "info") {
+        showInfo(snapshot);
+    } else if (cmd == "usage") {
+        showUsage(snapshot);
+    } else if (cmd == "health") {
+        showHealth(snapshot, tokens);
+    } else if (cmd == "scan") {
+        showScan(snapshot);
+    } else if (cmd == "sensors") {
+        showSensors(snapshot);
+    } else {
+        showAll(snapshot);
+    }
+}
+
+// Runs a list of commands against one snapshot and writes their output in one go.
+// Commands come from stdin ("batch -"), a file ("batch file") or inline
+// ("batch -c 'info; usage; health'"), separated by newlines or semicolons.
+void CLI::runBatch(const std::vector<std::string>& tokens) {
+    std::string script;
+    if (tokens.size() >= 3 && tokens[1] == "-c") {
+        for (size_t i = 2; i < tokens.size(); ++i) {
+            script += tokens[i] + " ";
+        }
+    } else if (tokens.size() == 2 && tokens[1] == "-") {
+        std::ostringstream input;
+        input << std::cin.rdbuf();
+        script = input.str();
+    } else if (tokens.size() == 2) {
+        std::ifstream file(tokens[1]);
+        if (!file) {
+            std::cout << RED << "Cannot open batch file: " << tokens[1] << RESET << std::endl;
+            return;
+        }
+        std::ostringstream input;
+        input << file.rdbuf();
+        script = input.str();
+    } else {
+        std::cout << RED << "Usage: batch - | batch <file> | batch -c \"cmd; cmd\"" << RESET << std::endl;
+        return;
+    }
+
+    // Parse and validate everything before running anything
+    std::vector<std::vector<std::string>> commands;
+    bool needsSnapshot = false;
+    std::istringstream lines(script);
+    for (std::string line; std::getline(lines, line);) {
+        std::istringstream parts(line);
+        for (std::string part; std::getline(parts, part, ';');) {
+            std::vector<std::string> command = tokenize(part.substr(0, part.find('#')));
+            if (command.empty()) {
+                continue;
+            }
+            const std::string& cmd = command[0];
+            if (cmd == "batch" || cmd == "publish") {
+                std::cout << RED << "'" << cmd << "' cannot run inside a batch." << RESET << std::endl;
+                return;
+            }
+            if (!isReport(cmd) && cmd != "integrity" && cmd != "help" && cmd != "version") {
+                std::cout << RED << "Unknown batch command: " << cmd << RESET << std::endl;
+                return;
+            }
+            needsSnapshot = needsSnapshot || isReport(cmd);
+            commands.push_back(std::move(command));
+        }
+    }
+
+    auto snapshot = std::make_unique<Metrics::Snapshot>();
+    if (needsSnapshot && !takeSnapshot(*snapshot)) {
+        return;
+    }
+
+    // Reports render into one buffer that is written once at the end
+    std::ostringstream output;
+    {
+        CoutRedirect redirect(output.rdbuf());
+        for (const auto& command : commands) {
+            if (isReport(command[0])) {
+                showReport(*snapshot, command);
+            } else {
+                runCommand(command);
+            }
         }
     }
+    std::cout << output.str() << std::flush;
 }
 
 // Display help information
@@ -66,14 +275,31 @@ void CLI::showHelp() {
     std::cout << COFFEE << "Commands:" << std::endl;
     std::cout << WHITE << "  info     Show basic system information" << std::endl;
     std::cout << WHITE << "  usage    Show system resource usage" << std::endl;
-    std::cout << WHITE << "  health   Show system health status" << std::endl;
+    std::cout << WHITE << "  health [--config file]  Show system health status and score breakdown" << std::endl;
     std::cout << WHITE << "  scan     Scan for common system problems" << std::endl;
+    std::cout << WHITE << "  sensors  Show temperature sensors and thermal throttling" << std::endl;
     std::cout << WHITE << "  all      Show all information" << std::endl;
     std::cout << WHITE << "  integrity init|check|update [path]  File integrity tools" << std::endl;
+    std::cout << WHITE << "      [--max-read-rate 20M] [--max-iops n] [--idle-only] [--io-pressure-limit pct] [--resume]" << std::endl;
+    std::cout << WHITE << "      [--tier quick|sample|full]  How much unchanged content check reads" << std::endl;
+    std::cout << WHITE << "      [--summary file]  Also write the check counts as JSON for aggregate" << std::endl;
+    std::cout << WHITE << "      check <path> <path>... | --roots file  Check many roots on one shared hashing pool" << std::endl;
+    std::cout << WHITE << "      [--threads n] [--per-device n] [--progress]" << std::endl;
+    std::cout << WHITE << "  publish [--interval ms]  Publish snapshots to shared memory until stopped" << std::endl;
+    std::cout << WHITE << "  batch - | <file> | -c \"info; usage; health\"  Run several commands against one snapshot" << std::endl;
+    std::cout << WHITE << "  export [json|binary] [--output file]  Write one snapshot for fleet aggregation" << std::endl;
+    std::cout << WHITE << "  aggregate <dir|-> [--top n] [--threads n]  Combine many hosts' exports into a fleet report" << std::endl;
     std::cout << GREEN << "  help     Show this help message" << std::endl;
     std::cout << GREEN << "  version  Show version information" << std::endl;
     std::cout << RED << "  << exit >>    Exit the tool" << std::endl;
     std::cout << WHITE << std::endl;
+    std::cout << COFFEE << "Options:" << std::endl;
+    std::cout << WHITE << "  --from-shm         Read the latest published snapshot instead of sampling" << std::endl;
+    std::cout << WHITE << "  --shm-name <name>  Shared memory segment name (default " << SharedMetrics::kDefaultName << ")" << std::endl;
+    std::cout << WHITE << "  --profile          Print a phase timing and counter breakdown to stderr" << std::endl;
+    std::cout << WHITE << "  --trace <file>     Write a Chrome trace (chrome://tracing, Perfetto) of the run" << std::endl;
+    std::cout << WHITE << "  --top-memory <n>   Include the n largest processes (up to " << Metrics::kMaxProcesses << ") in usage and scan" << std::endl;
+    std::cout << WHITE << std::endl;
 }
 
 // Display version information
@@ -82,90 +308,249 @@ void CLI::showVersion() {
 }
 
 // Display basic system information
-void CLI::showInfo() {
+void CLI::showInfo(const Metrics::Snapshot& snapshot) {
     std::cout << YELLOW << BOLD << "---------- System Basic Info ----------" << RESET << std::endl;
-    std::cout << "OS Name: " << SystemInfo::getOSName() << std::endl;
-    std::cout << "CPU Model: " << SystemInfo::getCPUModel() << std::endl;
-    std::cout << "RAM: " << SystemInfo::getRam() << std::endl;
-    std::cout << "Disk Size: " << SystemInfo::getDisk() << " GB" << std::endl;
-    std::cout << "Uptime: " << SystemInfo::getUptime() << " seconds" << std::endl;
-    std::cout << "User Name: " << SystemInfo::getUserName() << std::endl;
+    std::cout << "OS Name: " << snapshot.osName << std::endl;
+    std::cout << "CPU Model: " << snapshot.cpuModel << std::endl;
+    std::cout << "CPU Topology: " << snapshot.sockets << " socket(s), " << snapshot.cores << " core(s), "
+              << snapshot.threads << " thread(s), " << snapshot.numaNodes << " NUMA node(s)" << std::endl;
+    if (snapshot.l1dCacheBytes || snapshot.l2CacheBytes || snapshot.l3CacheBytes) {
+        std::cout << "CPU Cache: L1d " << snapshot.l1dCacheBytes / 1024 << " KB, L1i " << snapshot.l1iCacheBytes / 1024
+                  << " KB, L2 " << snapshot.l2CacheBytes / 1024 << " KB, L3 " << snapshot.l3CacheBytes / 1024 << " KB" << std::endl;
+    }
+    if (snapshot.cpuFlagCount > 0) {
+        std::cout << "CPU Features: " << snapshot.cpuFeatures << " (" << snapshot.cpuFlagCount << " flags)" << std::endl;
+    }
+    std::ostringstream ram;
+    ram << std::fixed << std::setprecision(2) << snapshot.totalRamBytes / (1024.0 * 1024.0 * 1024.0) << " GB";
+    std::cout << "RAM: " << ram.str() << std::endl;
+    std::cout << "Disk Size: " << snapshot.diskTotalGB << " GB" << std::endl;
+    std::cout << "Uptime: " << snapshot.uptimeSeconds << " seconds" << std::endl;
+    std::cout << "User Name: " << snapshot.userName << std::endl;
     std::cout << COFFEE << "==============================================" << RESET << std::endl;
 }
 
 // Display system resource usage
-void CLI::showUsage() {
+void CLI::showUsage(const Metrics::Snapshot& snapshot) {
     std::cout << YELLOW << BOLD << "---------- System Usage Info ----------" << RESET << std::endl;
-    double cpu = SystemInfo::getCPUusage();
-    double ram = SystemInfo::getRamUsage();
-    double disk = SystemInfo::getDiskUsage();
-    std::cout << "CPU Usage: " << cpu << " %" << std::endl;
-    std::cout << "RAM Usage: " << ram << " %" << std::endl;
-    std::cout << "Disk Usage: " << disk << " %" << std::endl;
+    std::cout << "CPU Usage: " << snapshot.cpuUsage << " %" << std::endl;
+    std::cout << "RAM Usage: " << snapshot.ramUsage << " %" << std::endl;
+    std::cout << "Disk Usage: " << snapshot.diskUsage << " %" << std::endl;
+    std::ios oldState(nullptr);
+    oldState.copyfmt(std::cout);
+    std::cout << std::fixed << std::setprecision(1);
+    if (snapshot.ratesReady.sched) {
+        const auto& sched = snapshot.sched;
+        std::cout << "Scheduler: " << sched.runnable << " runnable of " << sched.tasks << " tasks, "
+                  << sched.blocked << " blocked, " << sched.contextSwitchesPerSec << " context switches/s, "
+                  << sched.interruptsPerSec << " interrupts/s" << std::endl;
+        if (sched.schedstatAvailable) {
+            std::cout << "  Run-queue wait: " << sched.runQueueWaitPercent << " % per CPU (worst CPU "
+                      << sched.maxCpuWaitPercent << " %; 100 % = one task always waiting), " << std::setprecision(3) << sched.waitPerSliceMs
+                      << std::setprecision(1) << " ms per timeslice, " << sched.timeslicesPerSec << " timeslices/s"
+                      << std::endl;
+        }
+    }
+    for (int i = 0; i < snapshot.mountCount; ++i) {
+        const Metrics::MountEntry& mount = snapshot.mounts[i];
+        std::cout << "Mount " << mount.mountPoint << " (" << mount.fsType << "): ";
+        if (mount.timedOut) {
+            std::cout << "timed out" << std::endl;
+        } else if (mount.failed) {
+            std::cout << "unavailable" << std::endl;
+        } else {
+            std::cout << mount.usagePercent << " % of " << mount.totalBytes / (1024.0 * 1024.0 * 1024.0) << " GB, "
+                      << "inodes " << mount.inodeUsagePercent << " %" << std::endl;
+        }
+    }
+    const auto& memory = snapshot.memory;
+    if (memory.available) {
+        const double mb = 1024.0 * 1024.0;
+        std::cout << "Memory: " << (memory.memTotal - memory.memAvailable) / mb << " MB used of "
+                  << memory.memTotal / mb << " MB, " << memory.memAvailable / mb << " MB available" << std::endl;
+        std::cout << "  Anonymous " << memory.anonPages / mb << " MB, page cache " << memory.cached / mb
+                  << " MB (dirty " << memory.dirty / mb << ", writeback " << memory.writeback / mb << "), shmem "
+                  << memory.shmem / mb << " MB, buffers " << memory.buffers / mb << " MB" << std::endl;
+        std::cout << "  Kernel: slab " << memory.slab / mb << " MB (" << memory.slabUnreclaimable / mb
+                  << " unreclaimable), stacks " << memory.kernelStack / mb << " MB, page tables "
+                  << memory.pageTables / mb << " MB, vmalloc " << memory.vmallocUsed / mb << " MB" << std::endl;
+        std::cout << "  Committed " << memory.committed / mb << " MB of " << memory.commitLimit / mb
+                  << " MB limit, transparent huge pages " << memory.anonHugePages / mb << " MB" << std::endl;
+        if (memory.hugePagesTotal > 0) {
+            std::cout << "  Huge pages: " << memory.hugePagesTotal << " x " << memory.hugePageSize / 1024 << " KB, "
+                      << memory.hugePagesFree << " free, " << memory.hugePagesReserved << " reserved" << std::endl;
+        }
+        if (memory.swapTotal > 0) {
+            std::cout << "Swap: " << (memory.swapTotal - memory.swapFree) / mb << " MB used of "
+                      << memory.swapTotal / mb << " MB, cached " << memory.swapCached / mb << " MB";
+        } else {
+            std::cout << "Swap: none";
+        }
+        if (snapshot.ratesReady.memory) {
+            const auto& activity = snapshot.memoryActivity;
+            std::cout << ", " << activity.swapInPagesPerSec << " in/" << activity.swapOutPagesPerSec
+                      << " out pages/s, " << activity.majorFaultsPerSec << " major faults/s";
+        }
+        std::cout << std::endl;
+    }
+    for (int i = 0; i < snapshot.processCount; ++i) {
+        const Metrics::ProcessEntry& process = snapshot.processes[i];
+        const double mb = 1024.0 * 1024.0;
+        std::cout << "Process " << process.pid << " " << process.name << ": RSS " << process.rss / mb << " MB";
+        if (process.detailed) {
+            std::cout << ", PSS " << process.pss / mb << " MB (anon " << process.pssAnon / mb
+                      << ", file " << process.pssFile / mb << ", shmem " << process.pssShmem / mb
+                      << "), swap " << process.swap / mb << " MB";
+        }
+        std::cout << std::endl;
+    }
+    if (snapshot.ratesReady.disk) {
+        for (int i = 0; i < snapshot.diskCount; ++i) {
+            const Metrics::DiskEntry& dev = snapshot.disks[i];
+            std::cout << "Disk I/O " << dev.name << ": "
+                      << dev.readIops << " r/s, " << dev.writeIops << " w/s, "
+                      << dev.readBytesPerSec / (1024.0 * 1024.0) << " MB/s read, "
+                      << dev.writeBytesPerSec / (1024.0 * 1024.0) << " MB/s write, "
+                      << "await " << dev.readLatencyMs << "/" << dev.writeLatencyMs << " ms, "
+                      << "util " << dev.utilization << " %" << std::endl;
+        }
+    }
+    if (snapshot.ratesReady.net) {
+        for (int i = 0; i < snapshot.interfaceCount; ++i) {
+            const Metrics::InterfaceEntry& iface = snapshot.interfaces[i];
+            std::cout << "Network " << iface.name << ": "
+                      << iface.rxBytesPerSec / 1024.0 << " KB/s rx, " << iface.txBytesPerSec / 1024.0 << " KB/s tx, "
+                      << iface.rxPacketsPerSec << "/" << iface.txPacketsPerSec << " pkt/s, "
+                      << "drops " << iface.rxDropsPerSec + iface.txDropsPerSec << "/s, "
+                      << "errors " << iface.rxErrorsPerSec + iface.txErrorsPerSec << "/s" << std::endl;
+        }
+        const auto& tcp = snapshot.tcp;
+        std::cout << "TCP: " << tcp.outSegsPerSec << " seg/s out, "
+                  << tcp.retransPerSec << " retrans/s (" << tcp.retransPercent << " %), "
+                  << tcp.listenOverflowsPerSec << " listen overflows/s" << std::endl;
+    }
+    if (snapshot.cgroupAvailable && snapshot.ratesReady.cgroup) {
+        const auto& rates = snapshot.cgroupRates;
+        const auto& memory = snapshot.cgroupMemory;
+        std::cout << "Cgroup: " << snapshot.cgroupPath << std::endl;
+        if (memory.available) {
+            std::cout << "  Memory: " << memory.workingSet / (1024.0 * 1024.0) << " MB working set";
+            if (memory.max > 0) {
+                std::cout << " of " << memory.max / (1024.0 * 1024.0) << " MB limit ("
+                          << (double)memory.workingSet / memory.max * 100.0 << " %)";
+            } else {
+                std::cout << " (no limit)";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "  CPU: " << rates.cpuCores << " cores";
+        if (snapshot.cgroupCpuLimit.limited) {
+            std::cout << " of " << snapshot.cgroupCpuLimit.quotaCores << " quota (" << rates.cpuQuotaPercent << " %)";
+        } else {
+            std::cout << " (no quota)";
+        }
+        std::cout << ", throttled " << rates.throttledPercent << " % of periods, "
+                  << rates.throttledMsPerSec << " ms/s" << std::endl;
+        std::cout << "  I/O: " << rates.readBytesPerSec / (1024.0 * 1024.0) << " MB/s read, "
+                  << rates.writeBytesPerSec / (1024.0 * 1024.0) << " MB/s write, "
+                  << rates.readIops << " r/s, " << rates.writeIops << " w/s" << std::endl;
+        if (snapshot.cgroupMemoryPressure.available) {
+            std::cout << "  Memory pressure: some " << snapshot.cgroupMemoryPressure.someAvg10 << " %, full "
+                      << snapshot.cgroupMemoryPressure.fullAvg10 << " % (avg10)" << std::endl;
+        }
+    }
+    std::cout.copyfmt(oldState);
     std::cout << COFFEE << "==============================================" << RESET << std::endl;
 }
 
 // Display system health status
-void CLI::showHealth() {
+void CLI::showHealth(const Metrics::Snapshot& snapshot, const std::vector<std::string>& tokens) {
     std::cout << YELLOW<< BOLD << "---------- System Health Info ----------" << RESET << std::endl;
-    double cpu = SystemInfo::getCPUusage();
-    double ram = SystemInfo::getRamUsage();
-    double disk = SystemInfo::getDiskUsage();
-    std::cout << "CPU Health: " << Health::CPUhp(cpu) << std::endl;
-    std::cout << "RAM Health: " << Health::RAMhp(ram) << std::endl;
-    std::cout << "Disk Health: " << Health::Diskhp(disk) << std::endl;
-    std::cout << "Overall Health Score: " << Health::overallScore(cpu, ram, disk) << "/100" << std::endl;
-    std::cout << COFFEE << "==============================================" << RESET << std::endl;
-}
-
-// Scan for common system problems
-void CLI::showScan() {
-    struct Issue {
-        std::string severity;
-        std::string message;
-        std::string tip;
-    };
-
-    std::vector<Issue> issues;
-    double cpu = SystemInfo::getCPUusage();
-    double ram = SystemInfo::getRamUsage();
-    int uptimeSeconds = SystemInfo::getUptime();
-    double tempC = SystemInfo::getCpuTemperatureC();
-
-    if (cpu >= 85.0) {
-        issues.push_back({"CRITICAL", "High CPU usage (" + std::to_string((int)cpu) + "%)", "Close heavy apps or check background processes."});
-    } else if (cpu >= 70.0) {
-        issues.push_back({"WARNING", "Elevated CPU usage (" + std::to_string((int)cpu) + "%)", "Check for apps using unusual CPU."});
+    Health::Config config = Health::defaultConfig();
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i] == "--config" && i + 1 < tokens.size()) {
+            std::string error;
+            if (!Health::loadConfig(tokens[++i], config, &error)) {
+                std::cout << RED << error << RESET << std::endl;
+                std::cout << COFFEE << "==============================================" << RESET << std::endl;
+                return;
+            }
+        }
     }
 
-    if (ram >= 85.0) {
-        issues.push_back({"CRITICAL", "High RAM usage (" + std::to_string((int)ram) + "%)", "Close apps or upgrade memory if needed."});
-    } else if (ram >= 75.0) {
-        issues.push_back({"WARNING", "Elevated RAM usage (" + std::to_string((int)ram) + "%)", "Close unused apps and browser tabs."});
+    std::cout << "CPU Health: " << Health::statusName(Health::status(Health::Metric::CpuUsage, snapshot.cpuUsage, config)) << std::endl;
+    std::cout << "RAM Health: " << Health::statusName(Health::status(Health::Metric::RamUsage, snapshot.ramUsage, config)) << std::endl;
+    std::cout << "Disk Health: " << Health::statusName(Health::status(Health::Metric::DiskUsage, Metrics::worstDiskUsage(snapshot), config)) << std::endl;
+    for (int i = 0; i < snapshot.mountCount; ++i) {
+        if (snapshot.mounts[i].timedOut) {
+            std::cout << "Mount Health (" << snapshot.mounts[i].mountPoint << "): " << RED << "Not responding" << RESET << std::endl;
+        }
     }
-
-    int uptimeDays = uptimeSeconds / (60 * 60 * 24);
-    if (uptimeDays >= 30) {
-        issues.push_back({"CRITICAL", "Long uptime (" + std::to_string(uptimeDays) + " days)", "Reboot to clear leaks and apply updates."});
-    } else if (uptimeDays >= 7) {
-        issues.push_back({"WARNING", "Long uptime (" + std::to_string(uptimeDays) + " days)", "Consider a reboot if issues appear."});
+    if (snapshot.ratesReady.disk) {
+        for (int i = 0; i < snapshot.diskCount; ++i) {
+            std::cout << "Disk I/O Health (" << snapshot.disks[i].name << "): "
+                      << Health::statusName(Health::status(Health::Metric::DiskIOUtilization, snapshot.disks[i].utilization, config)) << std::endl;
+        }
     }
 
-    if (tempC >= 0.0) {
-        if (tempC >= 85.0) {
-            issues.push_back({"CRITICAL", "High CPU temperature (" + std::to_string((int)tempC) + " C)", "Check cooling, fans, and airflow."});
-        } else if (tempC >= 75.0) {
-            issues.push_back({"WARNING", "Elevated CPU temperature (" + std::to_string((int)tempC) + " C)", "Clean dust and ensure good airflow."});
-        }
+    Health::Report report = Health::evaluate(Metrics::healthInputs(snapshot), config);
+    std::cout << COFFEE << "Score breakdown:" << RESET << std::endl;
+    for (int i = 0; i < report.factorCount; ++i) {
+        const Health::Factor& factor = report.factors[i];
+        const char* color = factor.status == Health::Status::Good ? GREEN
+            : factor.status == Health::Status::Moderate ? YELLOW : RED;
+        std::cout << color << "  [" << Health::statusName(factor.status) << "] " << RESET << factor.label << ": ";
+        Health::writeReason(std::cout, factor);
+        std::cout << " (score " << factor.score << ", weight " << factor.weight << ")" << std::endl;
     }
+    std::cout << "Overall Health Score: " << report.score << "/100 (" << Health::statusName(report.status) << ")";
+    if (report.cappedBy >= 0) {
+        std::cout << ", limited by " << report.factors[report.cappedBy].label;
+    }
+    std::cout << std::endl;
+    std::cout << COFFEE << "==============================================" << RESET << std::endl;
+}
+
+// Scan for common system problems
+void CLI::showScan(const Metrics::Snapshot& snapshot) {
+    Scan::Result result;
+    Scan::scan(snapshot, result);
 
     std::cout << YELLOW << BOLD << "---------- System Problem Scan ----------" << RESET << std::endl;
-    if (issues.empty()) {
+    if (result.count == 0) {
         std::cout << GREEN << "No problems detected." << RESET << std::endl;
     } else {
-        for (const auto& issue : issues) {
-            std::cout << RED << "[" << issue.severity << "] " << RESET
-                      << issue.message << " | Tip: " << issue.tip << std::endl;
+        for (int i = 0; i < result.count; ++i) {
+            const Scan::Finding& finding = result.findings[i];
+            std::cout << RED << "[" << Scan::severityName(finding.severity) << "] " << RESET;
+            Scan::writeMessage(std::cout, finding);
+            std::cout << " | Tip: " << Scan::tip(finding.problem) << std::endl;
+        }
+    }
+    std::cout << COFFEE << "==============================================" << RESET << std::endl;
+}
+
+// Display every discovered temperature sensor and the thermal throttle counters
+void CLI::showSensors(const Metrics::Snapshot& snapshot) {
+    std::cout << YELLOW << BOLD << "---------- Temperature Sensors ----------" << RESET << std::endl;
+    if (snapshot.sensorCount == 0) {
+        std::cout << WHITE << "No temperature sensors found." << std::endl;
+    }
+    for (int i = 0; i < snapshot.sensorCount; ++i) {
+        const Metrics::SensorEntry& sensor = snapshot.sensors[i];
+        std::cout << sensor.name << " [" << Sensors::kindName(static_cast<Sensors::Kind>(sensor.kind)) << "]: ";
+        if (sensor.celsius < 0.0) {
+            std::cout << "unavailable" << std::endl;
+        } else {
+            std::cout << sensor.celsius << " C" << std::endl;
+        }
+    }
+    if (snapshot.throttleAvailable) {
+        std::cout << "Thermal throttle events since boot: " << snapshot.coreThrottleEvents << " core, "
+                  << snapshot.packageThrottleEvents << " package" << std::endl;
+        if (snapshot.ratesReady.throttle) {
+            std::cout << "Thermal throttle rate: " << snapshot.coreThrottlePerSec << " core, "
+                      << snapshot.packageThrottlePerSec << " package events/s" << std::endl;
         }
     }
     std::cout << COFFEE << "==============================================" << RESET << std::endl;
@@ -180,16 +565,121 @@ void CLI::showIntegrity(const std::vector<std::string>& tokens) {
     }
 
     std::string action = tokens[1];
-    std::filesystem::path root = std::filesystem::current_path();
-    if (tokens.size() >= 3) {
-        root = tokens[2];
+    std::vector<std::filesystem::path> roots;
+    bool multiRoot = false;
+    Integrity::Options options;
+    IoBudget::IoClass ioClass = IoBudget::IoClass::Default;
+    std::string summaryPath;
+    bool showProgress = false;
+    for (size_t i = 2; i < tokens.size(); ++i) {
+        const std::string& arg = tokens[i];
+        bool hasValue = i + 1 < tokens.size();
+        if (arg == "--max-read-rate" && hasValue) {
+            options.io.maxReadBytesPerSec = IoBudget::parseRate(tokens[++i]);
+            if (options.io.maxReadBytesPerSec == 0) {
+                std::cout << RED << "Invalid --max-read-rate value (e.g. 20M, 512K)." << RESET << std::endl;
+                return;
+            }
+        } else if (arg == "--max-iops" && hasValue) {
+            options.io.maxReadOpsPerSec = IoBudget::parseRate(tokens[++i]);
+            if (options.io.maxReadOpsPerSec == 0) {
+                std::cout << RED << "Invalid --max-iops value." << RESET << std::endl;
+                return;
+            }
+        } else if (arg == "--io-pressure-limit" && hasValue) {
+            try {
+                options.io.pressureLimit = std::stod(tokens[++i]);
+            } catch (...) {
+                std::cout << RED << "Invalid --io-pressure-limit value." << RESET << std::endl;
+                return;
+            }
+        } else if (arg == "--idle-only") {
+            ioClass = IoBudget::IoClass::Idle;
+        } else if (arg == "--resume") {
+            options.resume = true;
+        } else if (arg == "--summary" && hasValue) {
+            summaryPath = tokens[++i];
+        } else if (arg == "--roots" && hasValue) {
+            std::ifstream list(tokens[++i]);
+            if (!list) {
+                std::cout << RED << "Cannot open roots file: " << tokens[i] << RESET << std::endl;
+                return;
+            }
+            for (std::string line; std::getline(list, line);) {
+                size_t start = line.find_first_not_of(" \t\r");
+                if (start == std::string::npos || line[start] == '#') {
+                    continue;
+                }
+                roots.emplace_back(line.substr(start, line.find_last_not_of(" \t\r") - start + 1));
+            }
+            multiRoot = true;
+        } else if ((arg == "--threads" || arg == "--per-device") && hasValue) {
+            // stoul would wrap "-1" to the largest size_t
+            const std::string& text = tokens[++i];
+            long long value = 0;
+            size_t used = 0;
+            try {
+                value = std::stoll(text, &used);
+            } catch (...) {
+            }
+            if (value <= 0 || used != text.size()) {
+                std::cout << RED << "Invalid " << arg << " value." << RESET << std::endl;
+                return;
+            }
+            (arg == "--threads" ? options.threads : options.readsPerDevice) = static_cast<size_t>(value);
+        } else if (arg == "--progress") {
+            showProgress = true;
+        } else if (arg == "--tier" && hasValue) {
+            const std::string& tier = tokens[++i];
+            if (tier == "quick") {
+                options.tier = Integrity::Tier::Quick;
+            } else if (tier == "sample") {
+                options.tier = Integrity::Tier::Sample;
+            } else if (tier == "full") {
+                options.tier = Integrity::Tier::Full;
+            } else {
+                std::cout << RED << "Invalid --tier value (quick, sample or full)." << RESET << std::endl;
+                return;
+            }
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << RED << "Unknown integrity option: " << arg << RESET << std::endl;
+            return;
+        } else {
+            roots.emplace_back(arg);
+        }
     }
-    root = std::filesystem::absolute(root);
+    multiRoot = multiRoot || roots.size() > 1;
+    if (multiRoot && action != "check") {
+        std::cout << RED << "Only check accepts several roots." << RESET << std::endl;
+        std::cout << COFFEE << "==============================================" << RESET << std::endl;
+        return;
+    }
+    // Idle-only also pauses when anything else is stalling on I/O, unless a limit was given
+    if (ioClass == IoBudget::IoClass::Idle && options.io.pressureLimit <= 0.0) {
+        options.io.pressureLimit = 5.0;
+    }
+    std::string error;
+    if (!IoBudget::setIoPriority(ioClass, 0, &error)) {
+        std::cout << YELLOW << "Warning: " << error << RESET << std::endl;
+        error.clear();
+    }
+    if (multiRoot) {
+        if (showProgress) {
+            options.progress = [](const Integrity::Progress& progress) {
+                std::cerr << "\rRoots walked " << progress.rootsWalked << "/" << progress.roots
+                          << " | Files " << progress.files << " | Read " << progress.bytesRead / (1024 * 1024)
+                          << " MB | Queued " << progress.bytesQueued / (1024 * 1024) << " MB   " << std::flush;
+            };
+        }
+        checkRoots(roots, options, summaryPath);
+        std::cout << COFFEE << "==============================================" << RESET << std::endl;
+        return;
+    }
+    std::filesystem::path root = std::filesystem::absolute(roots.empty() ? std::filesystem::current_path() : roots.front());
     std::filesystem::path manifestPath = root / Integrity::kManifestFileName;
 
-    std::string error;
     if (action == "init") {
-        bool ok = Integrity::createManifest(root, &error);
+        bool ok = Integrity::createManifest(root, &error, options);
         if (ok) {
             std::cout << GREEN << "Integrity manifest created at: " << manifestPath.string() << RESET << std::endl;
             if (!error.empty()) {
@@ -199,7 +689,7 @@ void CLI::showIntegrity(const std::vector<std::string>& tokens) {
             std::cout << RED << (error.empty() ? "Failed to create integrity manifest." : error) << RESET << std::endl;
         }
     } else if (action == "update") {
-        bool ok = Integrity::updateManifest(root, &error);
+        bool ok = Integrity::updateManifest(root, &error, options);
         if (ok) {
             std::cout << GREEN << "Integrity manifest updated at: " << manifestPath.string() << RESET << std::endl;
             if (!error.empty()) {
@@ -210,13 +700,21 @@ void CLI::showIntegrity(const std::vector<std::string>& tokens) {
         }
     } else if (action == "check") {
         Integrity::CheckResult result;
-        bool ok = Integrity::checkManifest(root, result, &error);
+        bool ok = Integrity::checkManifest(root, result, &error, options);
         if (!ok) {
             std::cout << RED << (error.empty() ? "Failed to check integrity manifest." : error) << RESET << std::endl;
             std::cout << COFFEE << "==============================================" << RESET << std::endl;
             return;
         }
 
+        if (!summaryPath.empty()) {
+            std::ofstream summary(summaryPath, std::ios::binary | std::ios::trunc);
+            Fleet::writeJson(Fleet::summarize(SystemInfo::getHostName(), root.string(), result), summary);
+            if (!summary) {
+                std::cout << YELLOW << "Warning: unable to write summary to " << summaryPath << RESET << std::endl;
+            }
+        }
+
         std::cout << WHITE << "Root: " << root.string() << std::endl;
         std::cout << WHITE << "Manifest: " << manifestPath.string() << std::endl;
         std::cout << WHITE << "Tracked: " << result.total << std::endl;
@@ -224,14 +722,35 @@ void CLI::showIntegrity(const std::vector<std::string>& tokens) {
                   << " | Changed: " << result.changed
                   << " | Missing: " << result.missing
                   << " | New: " << result.added
-                  << " | Errors: " << result.errors << std::endl;
+                  << " | Errors: " << result.errors;
+        if (result.unlinked > 0) {
+            std::cout << " | Unlinked: " << result.unlinked;
+        }
+        std::cout << std::endl;
+        if (result.sampled > 0) {
+            std::cout << WHITE << "Sampled: " << result.sampled << " files checked by fingerprint" << std::endl;
+        }
+        if (result.sharedHashes > 0) {
+            std::cout << WHITE << "Hard links: " << result.sharedHashes << " paths reused the hash of an inode read once" << std::endl;
+        }
+        if (result.resumed > 0) {
+            std::cout << WHITE << "Resumed: " << result.resumed << " results taken from the previous run" << std::endl;
+        }
+        if (result.io.rateWaitMs > 0.0 || result.io.pressureWaitMs > 0.0) {
+            std::cout << WHITE << "Read budget: " << result.io.bytesRead / (1024 * 1024) << " MB in "
+                      << result.io.reads << " reads, waited " << static_cast<int64_t>(result.io.rateWaitMs)
+                      << " ms for rate limits and " << static_cast<int64_t>(result.io.pressureWaitMs)
+                      << " ms for I/O pressure" << std::endl;
+        }
 
         if (result.issues.empty()) {
             std::cout << GREEN << "Integrity OK." << RESET << std::endl;
         } else {
             for (const auto& issue : result.issues) {
-                std::cout << RED << "[" << issue.status << "] " << RESET
-                          << issue.path << " | " << issue.detail << std::endl;
+                std::cout << RED << "[" << Integrity::statusName(issue.status) << "] " << RESET
+                          << result.path(issue) << " | ";
+                Integrity::writeDetail(std::cout, result, issue);
+                std::cout << std::endl;
             }
         }
     } else {
@@ -240,6 +759,289 @@ void CLI::showIntegrity(const std::vector<std::string>& tokens) {
     std::cout << COFFEE << "==============================================" << RESET << std::endl;
 }
 
+// Checks every root on one shared hashing pool and prints one summary line per root, its
+// issues and the combined counts. The summary file gets one JSON line per root.
+void CLI::checkRoots(const std::vector<std::filesystem::path>& roots, const Integrity::Options& options,
+    const std::string& summaryPath) {
+    std::vector<std::filesystem::path> absolute;
+    for (const auto& root : roots) {
+        absolute.push_back(std::filesystem::absolute(root));
+    }
+    std::vector<Integrity::RootResult> results;
+    Integrity::CheckResult total;
+    std::string error;
+    Integrity::checkManifests(absolute, results, total, &error, options);
+    if (options.progress) {
+        std::cerr << std::endl;
+    }
+
+    std::ofstream summary;
+    if (!summaryPath.empty()) {
+        summary.open(summaryPath, std::ios::binary | std::ios::trunc);
+    }
+    std::string host = SystemInfo::getHostName();
+    std::ios oldState(nullptr);
+    oldState.copyfmt(std::cout);
+    std::cout << std::fixed << std::setprecision(1);
+    size_t withIssues = 0;
+    for (const auto& root : results) {
+        if (!root.ok) {
+            std::cout << RED << "[FAILED] " << RESET << root.root.string() << " | " << root.error << std::endl;
+            continue;
+        }
+        const Integrity::CheckResult& result = root.result;
+        if (summary.is_open()) {
+            Fleet::writeJson(Fleet::summarize(host, root.root.string(), result), summary);
+        }
+        bool clean = result.issues.empty();
+        withIssues += clean ? 0 : 1;
+        std::cout << (clean ? GREEN : RED) << (clean ? "[OK] " : "[ISSUES] ") << RESET << root.root.string()
+                  << WHITE << " | Tracked: " << result.total << " | Changed: " << result.changed
+                  << " | Missing: " << result.missing << " | New: " << result.added << " | Errors: " << result.errors;
+        if (result.unlinked > 0) {
+            std::cout << " | Unlinked: " << result.unlinked;
+        }
+        std::cout << " | " << result.io.bytesRead / (1024 * 1024) << " MB read, done at " << root.seconds << " s"
+                  << std::endl;
+        for (const auto& issue : result.issues) {
+            std::cout << RED << "  [" << Integrity::statusName(issue.status) << "] " << RESET
+                      << result.path(issue) << " | ";
+            Integrity::writeDetail(std::cout, result, issue);
+            std::cout << std::endl;
+        }
+    }
+    if (summary.is_open() && !summary) {
+        std::cout << YELLOW << "Warning: unable to write summary to " << summaryPath << RESET << std::endl;
+    }
+
+    std::cout << COFFEE << "Total:" << RESET << WHITE << " " << results.size() << " roots, " << withIssues
+              << " with issues | Tracked: " << total.total << " | OK: " << total.ok << " | Changed: " << total.changed
+              << " | Missing: " << total.missing << " | New: " << total.added << " | Errors: " << total.errors;
+    if (total.unlinked > 0) {
+        std::cout << " | Unlinked: " << total.unlinked;
+    }
+    std::cout << std::endl;
+    std::cout << WHITE << "Read: " << total.io.bytesRead / (1024 * 1024) << " MB in " << total.io.reads << " reads";
+    if (total.io.rateWaitMs > 0.0 || total.io.pressureWaitMs > 0.0) {
+        std::cout << ", waited " << static_cast<int64_t>(total.io.rateWaitMs) << " ms for rate limits and "
+                  << static_cast<int64_t>(total.io.pressureWaitMs) << " ms for I/O pressure";
+    }
+    std::cout << std::endl;
+    std::cout.copyfmt(oldState);
+    if (!error.empty()) {
+        std::cout << RED << error << RESET << std::endl;
+    } else if (withIssues == 0) {
+        std::cout << GREEN << "Integrity OK." << RESET << std::endl;
+    }
+}
+
+// Writes one snapshot as a JSON line (default) or a binary record, to stdout or a
+// file, so hosts can be collected centrally and combined with "aggregate"
+void CLI::exportSnapshot(const std::vector<std::string>& tokens) {
+    bool binary = false;
+    std::string outputPath;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i] == "json") {
+            binary = false;
+        } else if (tokens[i] == "binary") {
+            binary = true;
+        } else if (tokens[i] == "--output" && i + 1 < tokens.size()) {
+            outputPath = tokens[++i];
+        } else {
+            std::cout << RED << "Usage: export [json|binary] [--output file]" << RESET << std::endl;
+            return;
+        }
+    }
+    auto snapshot = std::make_unique<Metrics::Snapshot>();
+    // Section freshness is part of the export itself; notes would corrupt it on stdout
+    if (!takeSnapshot(*snapshot, true)) {
+        return;
+    }
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cout << RED << "Cannot open export file: " << outputPath << RESET << std::endl;
+            return;
+        }
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : file;
+    if (binary) {
+        Fleet::writeBinary(*snapshot, out);
+    } else {
+        Fleet::writeJson(*snapshot, out);
+    }
+    out.flush();
+    if (!out) {
+        std::cerr << RED << "Failed to write export." << RESET << std::endl;
+    }
+}
+
+// Combines the exports and integrity summaries of many hosts into distributions,
+// worst hosts per metric and a health score histogram
+void CLI::runAggregate(const std::vector<std::string>& tokens) {
+    std::string input;
+    Fleet::Options options;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        bool hasValue = i + 1 < tokens.size();
+        if ((tokens[i] == "--top" || tokens[i] == "--threads") && hasValue) {
+            int value = std::atoi(tokens[i + 1].c_str());
+            if (value <= 0) {
+                std::cout << RED << "Invalid " << tokens[i] << " value." << RESET << std::endl;
+                return;
+            }
+            (tokens[i] == "--top" ? options.worst : options.threads) = static_cast<size_t>(value);
+            ++i;
+        } else if (input.empty() && (tokens[i] == "-" || tokens[i].compare(0, 2, "--") != 0)) {
+            input = tokens[i];
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty()) {
+        std::cout << RED << "Usage: aggregate <dir|-> [--top n] [--threads n]" << RESET << std::endl;
+        return;
+    }
+
+    Fleet::Report report;
+    std::string error;
+    if (!Fleet::aggregate(input, options, report, &error)) {
+        std::cout << RED << error << RESET << std::endl;
+        return;
+    }
+
+    std::ios oldState(nullptr);
+    oldState.copyfmt(std::cout);
+    std::cout << YELLOW << BOLD << "---------- Fleet Aggregate ----------" << RESET << std::endl;
+    std::cout << WHITE << "Inputs: " << report.inputs << " | Snapshots: " << report.snapshots
+              << " | Integrity summaries: " << report.integrityRuns << " | Rejected: " << report.rejected << std::endl;
+    for (const auto& problem : report.problems) {
+        std::cout << YELLOW << "  " << problem << RESET << std::endl;
+    }
+
+    uint64_t scored = 0;
+    uint64_t tallest = 0;
+    for (uint64_t bucket : report.healthHistogram) {
+        scored += bucket;
+        tallest = std::max(tallest, bucket);
+    }
+    if (scored > 0) {
+        std::cout << COFFEE << "Health score distribution:" << RESET << std::endl;
+        for (int i = 9; i >= 0; --i) {
+            uint64_t hosts = report.healthHistogram[i];
+            std::string range = std::to_string(i * 10) + "-" + std::to_string(i == 9 ? 100 : i * 10 + 9);
+            int width = static_cast<int>(hosts * 40 / tallest);
+            const char* color = i >= 8 ? GREEN : i >= 5 ? YELLOW : RED;
+            std::cout << WHITE << "  " << std::left << std::setw(7) << range << std::right << color
+                      << std::string(width, '#') << RESET << " " << hosts << std::endl;
+        }
+    }
+
+    if (!report.metrics.empty()) {
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << COFFEE << std::left << std::setw(26) << "Metric" << std::right << std::setw(8) << "Hosts"
+                  << std::setw(9) << "Min" << std::setw(9) << "Mean" << std::setw(9) << "p50"
+                  << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9) << "Max" << RESET << std::endl;
+        for (const auto& metric : report.metrics) {
+            std::string label = Fleet::metricLabel(metric.metric);
+            if (*Fleet::metricUnit(metric.metric)) {
+                label += std::string(" (") + Fleet::metricUnit(metric.metric) + ")";
+            }
+            std::cout << WHITE << std::left << std::setw(26) << label << std::right << std::setw(8) << metric.hosts
+                      << std::setw(9) << metric.min << std::setw(9) << metric.mean << std::setw(9) << metric.p50
+                      << std::setw(9) << metric.p90 << std::setw(9) << metric.p99 << std::setw(9) << metric.max << std::endl;
+        }
+        std::cout << COFFEE << "Worst hosts:" << RESET << std::endl;
+        for (const auto& metric : report.metrics) {
+            if (metric.max == metric.min) {
+                continue;       // Every host reported the same value
+            }
+            std::cout << WHITE << "  " << Fleet::metricLabel(metric.metric) << ":";
+            for (size_t i = 0; i < metric.worst.size(); ++i) {
+                std::cout << (i ? ", " : " ") << metric.worst[i].host << " " << metric.worst[i].value;
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (report.integrityRuns > 0) {
+        std::cout << COFFEE << "Integrity:" << RESET << std::endl;
+        std::cout << WHITE << "  " << report.integrityRunsWithIssues << " of " << report.integrityRuns
+                  << " checks found differences | Tracked: " << report.tracked << " | Changed: " << report.changed
+                  << " | Missing: " << report.missing << " | New: " << report.added << " | Errors: " << report.errors << std::endl;
+        for (const auto& ranked : report.worstIntegrity) {
+            std::cout << RED << "  " << ranked.host << RESET << " " << static_cast<uint64_t>(ranked.value)
+                      << " changed, missing or unreadable" << std::endl;
+        }
+    }
+    std::cout.copyfmt(oldState);
+    std::cout << COFFEE << "==============================================" << RESET << std::endl;
+}
+
+// Publish snapshots to shared memory until interrupted
+void CLI::runPublisher(const std::vector<std::string>& tokens) {
+    int intervalMs = 1000;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i] == "--interval" && i + 1 < tokens.size()) {
+            try {
+                intervalMs = std::max(50, std::stoi(tokens[++i]));
+            } catch (...) {
+                std::cout << RED << "Invalid --interval value." << RESET << std::endl;
+                return;
+            }
+        } else if (tokens[i] == "--name" && i + 1 < tokens.size()) {
+            shmName = tokens[++i];
+        }
+    }
+
+    SharedMetrics::Publisher publisher;
+    std::string error;
+    if (!publisher.open(shmName, &error)) {
+        std::cout << RED << error << RESET << std::endl;
+        return;
+    }
+    std::cout << GREEN << "Publishing metrics to " << shmName << " every " << intervalMs
+              << " ms. Press Ctrl+C to stop." << RESET << std::endl;
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    // Each section refreshes at its own period on one thread; cheap rate
+    // counters follow the interval, slow or static sections much less often
+    auto snapshot = std::make_unique<Metrics::Snapshot>();
+    Metrics::Snapshot& target = *snapshot;
+    Scheduler::TimerWheel wheel(std::min(50, intervalMs));
+    wheel.add("host", 0, 500, [&] { collector.collectHost(target); });
+    wheel.add("cpu", intervalMs, 5, [&] { collector.collectCpu(target); });
+    wheel.add("memory", intervalMs, 5, [&] { collector.collectMemory(target); });
+    wheel.add("io", intervalMs, 10, [&] { collector.collectIo(target); });
+    wheel.add("cgroup", intervalMs, 5, [&] { collector.collectCgroup(target); });
+    wheel.add("sensors", std::max(5000, intervalMs), 20, [&] { collector.collectSensors(target); });
+    wheel.add("mounts", std::max(30000, intervalMs), 2000, [&] { collector.collectMounts(target); });
+    while (!stopRequested) {
+        if (wheel.tick() > 0) {
+            collector.stamp(target);
+            publisher.publish(target);
+        }
+    }
+
+    std::ios oldState(nullptr);
+    oldState.copyfmt(std::cout);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << COFFEE << std::left << std::setw(10) << "Collector" << std::right << std::setw(10) << "Period"
+              << std::setw(8) << "Runs" << std::setw(10) << "Overruns" << std::setw(9) << "Skipped"
+              << std::setw(10) << "Avg ms" << std::setw(10) << "Max ms" << RESET << std::endl;
+    for (const auto& stats : wheel.stats()) {
+        std::cout << std::left << std::setw(10) << stats.name << std::right << std::setw(10)
+                  << (stats.periodMs > 0 ? std::to_string(stats.periodMs) + " ms" : std::string("once"))
+                  << std::setw(8) << stats.runs << std::setw(10) << stats.overruns << std::setw(9) << stats.skipped
+                  << std::setw(10) << (stats.runs ? stats.totalMs / stats.runs : 0.0)
+                  << std::setw(10) << stats.maxMs << std::endl;
+    }
+    std::cout.copyfmt(oldState);
+    std::cout << RED << "Stopped publishing." << RESET << std::endl;
+}
+
 std::vector<std::string> CLI::tokenize(const std::string& line) {
     std::istringstream iss(line);
     std::vector<std::string> tokens;
@@ -251,11 +1053,11 @@ std::vector<std::string> CLI::tokenize(const std::string& line) {
 
 
 // Display all information
-void CLI::showAll() {
-    showInfo();
-    showUsage();
-    showHealth();
-    showScan();
+void CLI::showAll(const Metrics::Snapshot& snapshot) {
+    showInfo(snapshot);
+    showUsage(snapshot);
+    showHealth(snapshot, {});
+    showScan(snapshot);
 }
 
 // Interactive mode implementation of the CLI 
@@ -290,23 +1092,7 @@ void CLI::interactiveMode() {
         if (cmd == "exit" || cmd == "quit") {
             std::cout << RED << "Exiting System Insight Toolkit." << RESET << std::endl;
             break;
-        } else if (cmd == "help") {
-            showHelp();
-        } else if (cmd == "version") {
-            showVersion();
-        } else if (cmd == "info") {
-            showInfo();
-        } else if (cmd == "usage") {
-            showUsage();
-        } else if (cmd == "health") {
-            showHealth();
-        } else if (cmd == "scan") {
-            showScan();
-        } else if (cmd == "integrity checker") {
-            showIntegrity(tokens);
-        } else if (cmd == "all") {
-            showAll();
-        } else {
+        } else if (!runCommand(tokens)) {
             std::cout << RED << "Unknown command. Type 'help' for available commands." << RESET << std::endl;
         }
     }
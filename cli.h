@@ -1,6 +1,11 @@
 #pragma once
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
+#include "snapshot.h"
+#include "sharedMetrics.h"
+#include "integrity.h"
 
 class CLI {
 public:
@@ -10,15 +15,42 @@ private:
     std::vector<std::string> args;
     bool interactive = true;
 
+    // Global options, accepted anywhere on the command line
+    bool fromShm = false;
+    std::string shmName = SharedMetrics::kDefaultName;
+    bool profile = false;
+    std::string tracePath;
+
+    Metrics::Collector collector;
+    std::unique_ptr<SharedMetrics::Reader> shmReader;
+
+    // Fills snapshot from the shared-memory segment (--from-shm) or a fresh collection.
+    // Notes about sections that missed their deadline are printed unless quiet.
+    bool takeSnapshot(Metrics::Snapshot& snapshot, bool quiet = false);
+
+    // Runs one command; returns false if it is not recognised
+    bool runCommand(const std::vector<std::string>& tokens);
+
+    // Commands rendered purely from a snapshot
+    static bool isReport(const std::string& cmd);
+    void showReport(const Metrics::Snapshot& snapshot, const std::vector<std::string>& tokens);
+
     //system commands implementation 
     void showHelp();
     void showVersion();
-    void showInfo();
-    void showUsage();
-    void showHealth();
-    void showScan();
-    void showAll();
+    void showInfo(const Metrics::Snapshot& snapshot);
+    void showUsage(const Metrics::Snapshot& snapshot);
+    void showHealth(const Metrics::Snapshot& snapshot, const std::vector<std::string>& tokens);
+    void showScan(const Metrics::Snapshot& snapshot);
+    void showSensors(const Metrics::Snapshot& snapshot);
+    void showAll(const Metrics::Snapshot& snapshot);
     void showIntegrity(const std::vector<std::string>& tokens);
+    void checkRoots(const std::vector<std::filesystem::path>& roots, const Integrity::Options& options,
+        const std::string& summaryPath);
+    void runPublisher(const std::vector<std::string>& tokens);
+    void runBatch(const std::vector<std::string>& tokens);
+    void exportSnapshot(const std::vector<std::string>& tokens);
+    void runAggregate(const std::vector<std::string>& tokens);
     void interactiveMode();
     static std::vector<std::string> tokenize(const std::string& line);
 };
@@ -0,0 +1,124 @@
+// diskStats.cpp block device I/O sampler implementation
+#include "diskStats.h"
+#include "procfs.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <filesystem>     // For checking /sys/block entries
+#endif
+
+namespace DiskStats {
+namespace {
+    constexpr double kSectorBytes = 512.0;
+
+    // Only whole disks are reported; partitions, loop and ram devices are skipped
+    bool isTrackedDevice(const std::string& name) {
+#ifdef _WIN32
+        (void)name;
+        return false;
+#else
+        if (name.rfind("loop", 0) == 0 || name.rfind("ram", 0) == 0) {
+            return false;
+        }
+        std::error_code ec;
+        return std::filesystem::exists(ProcFS::path("/sys/block/") + name, ec);
+#endif
+    }
+
+    double perSecond(uint64_t count, double seconds) {
+        return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+    }
+
+    using ProcFS::delta;
+} // namespace
+
+    bool Sampler::sample() {
+#ifdef _WIN32
+        return false;
+#else
+        if (!ProcFS::readSource("/proc/diskstats", buffer)) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastSample).count();
+
+        // Collect line boundaries and names first so index changes can be detected cheaply
+        index.begin();
+        const char* p = buffer.data();
+        const char* bufferEnd = p + buffer.size();
+        while (p < bufferEnd) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(bufferEnd - p)));
+            if (!eol) {
+                eol = bufferEnd;
+            }
+            const char* cursor = p;
+            ProcFS::parseU64(cursor, eol);   // major
+            ProcFS::parseU64(cursor, eol);   // minor
+            std::string_view name = ProcFS::parseTokenView(cursor, eol);
+            if (!name.empty()) {
+                index.add(name, cursor, eol);
+            }
+            p = eol + 1;
+        }
+        index.finish(isTrackedDevice);
+
+        std::vector<Device>& devices = index.entries();
+        std::vector<Counters>& previous = index.counters();
+        for (size_t i = 0; i < index.rowCount(); ++i) {
+            int slot = index.slot(i);
+            if (slot < 0) {
+                continue;
+            }
+            const char* cursor = index.fields(i);
+            const char* end = index.end(i);
+            Counters c;
+            c.reads = ProcFS::parseU64(cursor, end);
+            ProcFS::parseU64(cursor, end);                // reads merged
+            c.readSectors = ProcFS::parseU64(cursor, end);
+            c.readMs = ProcFS::parseU64(cursor, end);
+            c.writes = ProcFS::parseU64(cursor, end);
+            ProcFS::parseU64(cursor, end);                // writes merged
+            c.writeSectors = ProcFS::parseU64(cursor, end);
+            c.writeMs = ProcFS::parseU64(cursor, end);
+            ProcFS::parseU64(cursor, end);                // I/Os currently in progress
+            c.ioMs = ProcFS::parseU64(cursor, end);
+            c.valid = true;
+
+            Counters& prev = previous[static_cast<size_t>(slot)];
+            Device& dev = devices[static_cast<size_t>(slot)];
+            if (prev.valid) {
+                uint64_t reads = delta(c.reads, prev.reads);
+                uint64_t writes = delta(c.writes, prev.writes);
+                dev.readIops = perSecond(reads, seconds);
+                dev.writeIops = perSecond(writes, seconds);
+                dev.readBytesPerSec = perSecond(delta(c.readSectors, prev.readSectors), seconds) * kSectorBytes;
+                dev.writeBytesPerSec = perSecond(delta(c.writeSectors, prev.writeSectors), seconds) * kSectorBytes;
+                dev.readLatencyMs = reads ? static_cast<double>(delta(c.readMs, prev.readMs)) / reads : 0.0;
+                dev.writeLatencyMs = writes ? static_cast<double>(delta(c.writeMs, prev.writeMs)) / writes : 0.0;
+                dev.utilization = seconds > 0.0
+                    ? static_cast<double>(delta(c.ioMs, prev.ioMs)) / (seconds * 1000.0) * 100.0
+                    : 0.0;
+                if (dev.utilization > 100.0) {
+                    dev.utilization = 100.0;
+                }
+            }
+            prev = c;
+        }
+
+        lastSample = now;
+        ++samples;
+        return true;
+#endif
+    }
+
+    const Device* busiest(const std::vector<Device>& devices) {
+        const Device* worst = nullptr;
+        for (const auto& dev : devices) {
+            if (!worst || dev.utilization > worst->utilization) {
+                worst = &dev;
+            }
+        }
+        return worst;
+    }
+}
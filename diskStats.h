@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "procfs.h"
+
+// DiskStats namespace encapsulating block device I/O metrics from /proc/diskstats
+namespace DiskStats {
+
+    // Per-device rates computed from the delta between two samples
+    struct Device {
+        std::string name;
+        double readIops = 0.0;
+        double writeIops = 0.0;
+        double readBytesPerSec = 0.0;
+        double writeBytesPerSec = 0.0;
+        double readLatencyMs = 0.0;   // Average time per completed read
+        double writeLatencyMs = 0.0;  // Average time per completed write
+        double utilization = 0.0;     // Percentage of wall time the device was busy
+    };
+
+    // Samples /proc/diskstats and keeps the previous counters so every call
+    // after the first produces rates. The device table is parsed once and
+    // indexed by line position; it is only rebuilt when devices come or go.
+    class Sampler {
+    public:
+        // Reads /proc/diskstats once. Returns false if the file is unavailable.
+        bool sample();
+
+        // True once two samples have been taken and the rates are meaningful
+        bool ready() const { return samples >= 2; }
+
+        const std::vector<Device>& devices() const { return index.entries(); }
+
+    private:
+        struct Counters {
+            uint64_t reads = 0;
+            uint64_t readSectors = 0;
+            uint64_t readMs = 0;
+            uint64_t writes = 0;
+            uint64_t writeSectors = 0;
+            uint64_t writeMs = 0;
+            uint64_t ioMs = 0;
+            bool valid = false;
+        };
+
+        // Line of /proc/diskstats -> device slot; partitions and virtual devices have none
+        ProcFS::RowIndex<Device, Counters> index;
+        std::string buffer;
+        std::chrono::steady_clock::time_point lastSample;
+        int samples = 0;
+    };
+
+    // Returns the busiest device, or nullptr when there are none
+    const Device* busiest(const std::vector<Device>& devices);
+}
@@ -0,0 +1,41 @@
+// executor.cpp worker pool implementation
+#include "executor.h"
+
+#include <thread>
+
+namespace Async {
+    Executor::Executor(size_t threads)
+        : queue(std::make_shared<Queue>()), threadCount(threads > 0 ? threads : 1) {
+    }
+
+    Executor::~Executor() {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->stopping = true;
+        queue->ready.notify_all();
+    }
+
+    void Executor::post(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!started) {
+            for (size_t i = 0; i < threadCount; ++i) {
+                std::thread([shared = queue] {
+                    std::unique_lock<std::mutex> lock(shared->mutex);
+                    while (true) {
+                        shared->ready.wait(lock, [&shared] { return shared->stopping || !shared->tasks.empty(); });
+                        if (shared->tasks.empty()) {
+                            return;     // Stopping and drained
+                        }
+                        std::function<void()> next = std::move(shared->tasks.front());
+                        shared->tasks.pop_front();
+                        lock.unlock();
+                        next();
+                        lock.lock();
+                    }
+                }).detach();
+            }
+            started = true;
+        }
+        queue->tasks.push_back(std::move(task));
+        queue->ready.notify_one();
+    }
+}
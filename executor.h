@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+// Async namespace encapsulating the small worker pool used to run collectors concurrently
+namespace Async {
+
+    // Fixed pool of worker threads, started on first use. Workers are detached and
+    // share the queue with the pool, so a task stuck in a system call (statvfs on a
+    // dead network filesystem) never blocks destruction; it is abandoned instead.
+    class Executor {
+    public:
+        explicit Executor(size_t threads);
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        // Queues task and returns a future for its result (or exception)
+        template <typename F>
+        auto submit(F task) -> std::future<decltype(task())> {
+            using Result = decltype(task());
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+            std::future<Result> result = packaged->get_future();
+            post([packaged] { (*packaged)(); });
+            return result;
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::deque<std::function<void()>> tasks;
+            bool stopping = false;
+        };
+
+        std::shared_ptr<Queue> queue;
+        size_t threadCount;
+        bool started = false;
+
+        void post(std::function<void()> task);
+    };
+}
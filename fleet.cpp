@@ -0,0 +1,819 @@
+// fleet.cpp snapshot export and fleet aggregation implementation
+#include "fleet.h"
+#include "sharedMetrics.h"
+#include "executor.h"
+#include "stats.h"
+#include "procfs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace Fleet {
+namespace {
+    struct MetricInfo {
+        const char* key;
+        const char* label;
+        const char* unit;
+    };
+
+    constexpr std::array<MetricInfo, kMetricCount> kMetrics = {{
+        { "cpu_usage", "CPU usage", "%" },
+        { "ram_usage", "RAM usage", "%" },
+        { "disk_usage", "Fullest disk", "%" },
+        { "disk_io_utilization", "Busiest disk I/O", "%" },
+        { "load_per_core", "Load per core", "" },
+        { "run_queue_wait", "Run-queue wait", "%" },
+        { "cpu_pressure", "CPU pressure", "%" },
+        { "memory_pressure", "Memory pressure", "%" },
+        { "io_pressure", "I/O pressure", "%" },
+        { "swap_activity", "Swap activity", "pages/s" },
+        { "major_faults", "Major faults", "/s" },
+        { "cpu_temperature", "CPU temperature", "C" },
+        { "health_score", "Health score", "" },
+    }};
+
+    constexpr int kJsonVersion = 1;
+    constexpr char kSnapshotFormat[] = "sit-snapshot";
+    constexpr char kIntegrityFormat[] = "sit-integrity";
+
+    // Binary export header; the layout version is the shared-memory one, since both
+    // carry the Snapshot struct as-is
+    constexpr char kBinaryMagic[8] = { 'S', 'I', 'T', 'S', 'N', 'A', 'P', '\n' };
+    struct BinaryHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t snapshotSize;
+    };
+
+    constexpr size_t kMaxProblems = 10;
+    constexpr size_t kChunkBytes = 1 << 20;             // Records handed to a worker at once; larger files are split
+    constexpr size_t kExportProbeBytes = 64;            // Read to tell a large export from any other file
+    constexpr size_t kMaxRecordBytes = 16 << 20;        // Larger binary records are rejected unread
+
+    const char* sectionStateName(Metrics::SectionState state) {
+        switch (state) {
+            case Metrics::SectionState::Fresh: return "fresh";
+            case Metrics::SectionState::TimedOut: return "timed_out";
+            case Metrics::SectionState::Stale: return "stale";
+        }
+        return "unknown";
+    }
+
+    void writeString(std::ostream& out, std::string_view text) {
+        static const char kHex[] = "0123456789abcdef";
+        out << '"';
+        for (char c : text) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (byte < 0x20) {
+                out << "\\u00" << kHex[byte >> 4] << kHex[byte & 0xF];
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    // JSON has no NaN or infinity
+    void writeNumber(std::ostream& out, double value) {
+        if (std::isfinite(value)) {
+            out << value;
+        } else {
+            out << "null";
+        }
+    }
+
+    // One scalar of a parsed record
+    struct Value {
+        bool isString = false;
+        double number = 0.0;
+        std::string text;
+    };
+
+    // Parsed record with nested object keys flattened to "outer.inner"
+    using Fields = std::unordered_map<std::string, Value>;
+
+    // Minimal JSON reader for export records. Objects are flattened into fields;
+    // arrays are parsed for validity but their contents are not kept.
+    class JsonReader {
+    public:
+        JsonReader(const char* begin, const char* end) : p(begin), end(end) {}
+
+        bool parse(Fields& fields, std::string& problem) {
+            skipSpace();
+            if (!parseValue(std::string(), &fields, 0)) {
+                problem = failure.empty() ? "malformed JSON" : failure;
+                return false;
+            }
+            skipSpace();
+            if (p != end) {
+                problem = "trailing data after JSON object";
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr int kMaxDepth = 16;
+        const char* p;
+        const char* end;
+        std::string failure;
+
+        void skipSpace() {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+                ++p;
+            }
+        }
+
+        bool expect(char c) {
+            skipSpace();
+            if (p < end && *p == c) {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+
+        bool parseString(std::string& out) {
+            if (p >= end || *p != '"') {
+                return false;
+            }
+            ++p;
+            out.clear();
+            while (p < end && *p != '"') {
+                if (*p != '\\') {
+                    out.push_back(*p++);
+                    continue;
+                }
+                if (++p >= end) {
+                    return false;
+                }
+                char escape = *p++;
+                switch (escape) {
+                    case 'n': out.push_back('\n'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'u': {
+                        if (end - p < 4) {
+                            return false;
+                        }
+                        unsigned code = static_cast<unsigned>(std::strtoul(std::string(p, 4).c_str(), nullptr, 16));
+                        p += 4;
+                        // Host names and paths are ASCII in practice; others become '?'
+                        out.push_back(code < 0x80 ? static_cast<char>(code) : '?');
+                        break;
+                    }
+                    default: out.push_back(escape); break;
+                }
+            }
+            if (p >= end) {
+                return false;
+            }
+            ++p;
+            return true;
+        }
+
+        // Parses one value; scalars are stored under key when fields is set
+        bool parseValue(const std::string& key, Fields* fields, int depth) {
+            skipSpace();
+            if (p >= end) {
+                return false;
+            }
+            if (depth > kMaxDepth) {
+                failure = "JSON nested too deeply";
+                return false;
+            }
+            if (*p == '{') {
+                ++p;
+                if (expect('}')) {
+                    return true;
+                }
+                std::string name;
+                do {
+                    skipSpace();
+                    if (!parseString(name) || !expect(':')) {
+                        return false;
+                    }
+                    if (!parseValue(key.empty() ? name : key + "." + name, fields, depth + 1)) {
+                        return false;
+                    }
+                } while (expect(','));
+                return expect('}');
+            }
+            if (*p == '[') {
+                ++p;
+                if (expect(']')) {
+                    return true;
+                }
+                do {
+                    if (!parseValue(key, nullptr, depth + 1)) {
+                        return false;
+                    }
+                } while (expect(','));
+                return expect(']');
+            }
+            Value value;
+            if (*p == '"') {
+                if (!parseString(value.text)) {
+                    return false;
+                }
+                value.isString = true;
+            } else if (end - p >= 4 && std::strncmp(p, "true", 4) == 0) {
+                value.number = 1.0;
+                p += 4;
+            } else if (end - p >= 5 && std::strncmp(p, "false", 5) == 0) {
+                p += 5;
+            } else if (end - p >= 4 && std::strncmp(p, "null", 4) == 0) {
+                p += 4;
+                return true;        // Absent
+            } else {
+                // Bounded copy: strtod would otherwise read past the record
+                const char* start = p;
+                while (p < end && (std::strchr("+-.eE", *p) || (*p >= '0' && *p <= '9'))) {
+                    ++p;
+                }
+                std::string digits(start, p);
+                char* parsed = nullptr;
+                value.number = std::strtod(digits.c_str(), &parsed);
+                if (digits.empty() || parsed != digits.c_str() + digits.size()) {
+                    return false;
+                }
+            }
+            if (fields) {
+                (*fields)[key] = std::move(value);
+            }
+            return true;
+        }
+    };
+
+    double number(const Fields& fields, const std::string& key, bool* found = nullptr) {
+        auto it = fields.find(key);
+        bool present = it != fields.end() && !it->second.isString;
+        if (found) {
+            *found = present;
+        }
+        return present ? it->second.number : 0.0;
+    }
+
+    std::string text(const Fields& fields, const std::string& key) {
+        auto it = fields.find(key);
+        return it != fields.end() && it->second.isString ? it->second.text : std::string();
+    }
+
+    uint64_t count(const Fields& fields, const std::string& key) {
+        double value = number(fields, key);
+        return value > 0.0 ? static_cast<uint64_t>(value) : 0;
+    }
+
+    // What a worker hands back for one file or stdin chunk
+    struct Batch {
+        bool skipped = false;       // Not an export file at all
+        uint64_t inputs = 0;        // Input files this batch counts (the first chunk of a chunked file)
+        std::vector<HostSample> samples;
+        std::vector<IntegritySummary> integrity;
+        uint64_t rejected = 0;
+        std::vector<std::string> problems;
+    };
+
+    void reject(Batch& batch, const std::string& source, const std::string& reason) {
+        ++batch.rejected;
+        if (batch.problems.size() < kMaxProblems) {
+            batch.problems.push_back(source + ": " + reason);
+        }
+    }
+
+    void parseJsonRecord(const char* begin, const char* end, const std::string& source, Batch& batch) {
+        Fields fields;
+        std::string problem;
+        if (!JsonReader(begin, end).parse(fields, problem)) {
+            reject(batch, source, problem);
+            return;
+        }
+        std::string format = text(fields, "format");
+        if (format == kSnapshotFormat) {
+            HostSample sample;
+            sample.host = text(fields, "host");
+            sample.timestampMs = count(fields, "timestamp_ms");
+            for (int i = 0; i < kMetricCount; ++i) {
+                bool found = false;
+                double value = number(fields, std::string("metrics.") + kMetrics[i].key, &found);
+                if (found) {
+                    sample.set(static_cast<Metric>(i), value);
+                }
+            }
+            batch.samples.push_back(std::move(sample));
+        } else if (format == kIntegrityFormat) {
+            IntegritySummary summary;
+            summary.host = text(fields, "host");
+            summary.root = text(fields, "root");
+            summary.timestampMs = count(fields, "timestamp_ms");
+            summary.tracked = count(fields, "tracked");
+            summary.ok = count(fields, "ok");
+            summary.changed = count(fields, "changed");
+            summary.missing = count(fields, "missing");
+            summary.added = count(fields, "new");
+            summary.errors = count(fields, "errors");
+            summary.unlinked = count(fields, "unlinked");
+            batch.integrity.push_back(std::move(summary));
+        } else {
+            reject(batch, source, format.empty() ? "no \"format\" field" : "unknown format \"" + format + "\"");
+        }
+    }
+
+    // Counts and strings in a foreign binary record are not trusted
+    void sanitize(Metrics::Snapshot& snapshot) {
+        snapshot.diskCount = std::clamp(snapshot.diskCount, 0, Metrics::kMaxDisks);
+        snapshot.interfaceCount = std::clamp(snapshot.interfaceCount, 0, Metrics::kMaxInterfaces);
+        snapshot.mountCount = std::clamp(snapshot.mountCount, 0, Metrics::kMaxMounts);
+        snapshot.sensorCount = std::clamp(snapshot.sensorCount, 0, Metrics::kMaxSensors);
+        snapshot.processCount = std::clamp(snapshot.processCount, 0, Metrics::kMaxProcesses);
+        snapshot.anomalyCount = std::clamp(snapshot.anomalyCount, 0, Metrics::kMaxAnomalies);
+        snapshot.hostName[sizeof(snapshot.hostName) - 1] = '\0';
+    }
+
+    // Splits data into records. JSON lines and binary records may be mixed, as they
+    // are when exports from different hosts are simply concatenated.
+    void parseRecords(const std::string& data, const std::string& source, Batch& batch) {
+        const char* p = data.data();
+        const char* end = p + data.size();
+        std::unique_ptr<Metrics::Snapshot> snapshot;
+        while (p < end) {
+            if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+                ++p;
+                continue;
+            }
+            size_t remaining = static_cast<size_t>(end - p);
+            if (remaining >= sizeof(kBinaryMagic) && std::memcmp(p, kBinaryMagic, sizeof(kBinaryMagic)) == 0) {
+                BinaryHeader header;
+                if (remaining < sizeof(header)) {
+                    reject(batch, source, "truncated binary header");
+                    return;
+                }
+                std::memcpy(&header, p, sizeof(header));
+                size_t total = sizeof(header) + header.snapshotSize;
+                if (remaining < total) {
+                    reject(batch, source, "truncated binary snapshot");
+                    return;
+                }
+                p += total;
+                if (header.version != SharedMetrics::kLayoutVersion || header.snapshotSize != sizeof(Metrics::Snapshot)) {
+                    reject(batch, source, "binary layout version " + std::to_string(header.version) + " (this build reads "
+                        + std::to_string(SharedMetrics::kLayoutVersion) + "); export as JSON instead");
+                    continue;
+                }
+                if (!snapshot) {
+                    snapshot = std::make_unique<Metrics::Snapshot>();
+                }
+                std::memcpy(snapshot.get(), p - header.snapshotSize, sizeof(Metrics::Snapshot));
+                sanitize(*snapshot);
+                batch.samples.push_back(sample(*snapshot));
+                continue;
+            }
+            const char* eol = ProcFS::lineEnd(p, end);
+            parseJsonRecord(p, eol, source, batch);
+            p = eol;
+        }
+    }
+
+    // Export files start with a JSON object or the binary magic; anything else is skipped
+    bool looksLikeExport(const std::string& data) {
+        size_t start = data.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) {
+            return false;
+        }
+        return data[start] == '{'
+            || data.compare(start, sizeof(kBinaryMagic), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+    }
+
+    Batch parseFile(const std::filesystem::path& path) {
+        Batch batch;
+        batch.inputs = 1;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            reject(batch, path.string(), "cannot be read");
+            return batch;
+        }
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!looksLikeExport(data)) {
+            batch.skipped = true;
+            return batch;
+        }
+        parseRecords(data, path.string(), batch);
+        return batch;
+    }
+
+    // Checks the start of a file that is read in chunks, then rewinds it
+    bool startsLikeExport(std::istream& in) {
+        std::string head(kExportProbeBytes, '\0');
+        in.read(&head[0], static_cast<std::streamsize>(head.size()));
+        head.resize(static_cast<size_t>(in.gcount()));
+        in.clear();
+        in.seekg(0);
+        return looksLikeExport(head);
+    }
+
+    // Appends the next whole record from a stream to chunk; false at the end. A record
+    // that cannot be read sets problem instead.
+    bool readRecord(std::istream& in, std::string& chunk, std::string& problem) {
+        int next = in.peek();
+        while (next == ' ' || next == '\t' || next == '\r' || next == '\n') {
+            in.get();
+            next = in.peek();
+        }
+        if (next == std::char_traits<char>::eof()) {
+            return false;
+        }
+        if (next == kBinaryMagic[0]) {
+            BinaryHeader header;
+            if (in.read(reinterpret_cast<char*>(&header), sizeof(header))
+                && std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) == 0) {
+                if (header.snapshotSize > kMaxRecordBytes) {
+                    // Cannot be skipped reliably either; the rest of the stream is abandoned
+                    problem = "binary record of " + std::to_string(header.snapshotSize) + " bytes; rest of stream ignored";
+                    in.setstate(std::ios::eofbit);
+                    return true;
+                }
+                size_t offset = chunk.size();
+                chunk.append(reinterpret_cast<const char*>(&header), sizeof(header));
+                chunk.resize(offset + sizeof(header) + header.snapshotSize);
+                in.read(&chunk[offset + sizeof(header)], header.snapshotSize);
+                chunk.resize(offset + sizeof(header) + static_cast<size_t>(in.gcount()));
+                return true;
+            }
+            // Not a binary record after all: keep what was read as the start of a line
+            chunk.append(reinterpret_cast<const char*>(&header), static_cast<size_t>(in.gcount()));
+            in.clear(in.rdstate() & ~std::ios::failbit);
+        }
+        std::string line;
+        std::getline(in, line);
+        chunk += line;
+        chunk.push_back('\n');
+        return true;
+    }
+
+    // Keeps the limit worst values, one per host, worst first
+    void rank(std::vector<Ranked>& worst, size_t limit, const std::string& host, double value, bool higherWorse) {
+        if (limit == 0) {
+            return;
+        }
+        auto worse = [higherWorse](double a, double b) { return higherWorse ? a > b : a < b; };
+        auto existing = std::find_if(worst.begin(), worst.end(), [&host](const Ranked& r) { return r.host == host; });
+        if (existing != worst.end()) {
+            if (!worse(value, existing->value)) {
+                return;
+            }
+            existing->value = value;
+        } else if (worst.size() < limit) {
+            worst.push_back(Ranked{ host, value });
+        } else if (worse(value, worst.back().value)) {
+            worst.back() = Ranked{ host, value };
+        } else {
+            return;
+        }
+        std::stable_sort(worst.begin(), worst.end(),
+            [&worse](const Ranked& a, const Ranked& b) { return worse(a.value, b.value); });
+    }
+
+    // Fleet-wide state, updated on the calling thread as batches complete
+    class Accumulator {
+    public:
+        explicit Accumulator(size_t worstCount) : worstCount(worstCount) {}
+
+        void merge(const Batch& batch, Report& report) {
+            if (batch.skipped) {
+                return;
+            }
+            report.rejected += batch.rejected;
+            for (const auto& problem : batch.problems) {
+                if (report.problems.size() < kMaxProblems) {
+                    report.problems.push_back(problem);
+                }
+            }
+            for (const auto& sample : batch.samples) {
+                add(sample, report);
+            }
+            for (const auto& summary : batch.integrity) {
+                add(summary, report);
+            }
+        }
+
+        void finish(Report& report) const {
+            for (int i = 0; i < kMetricCount; ++i) {
+                const Series& s = series[i];
+                if (s.moments.samples() == 0) {
+                    continue;
+                }
+                MetricSummary summary;
+                summary.metric = static_cast<Metric>(i);
+                summary.hosts = s.moments.samples();
+                summary.min = s.min;
+                summary.mean = s.moments.mean();
+                summary.max = s.max;
+                summary.p50 = s.sketch.quantile(0.50);
+                summary.p90 = s.sketch.quantile(0.90);
+                summary.p99 = s.sketch.quantile(0.99);
+                summary.worst = s.worst;
+                report.metrics.push_back(std::move(summary));
+            }
+        }
+
+    private:
+        struct Series {
+            Stats::Welford moments;
+            Stats::Sketch sketch;
+            double min = 0.0;
+            double max = 0.0;
+            std::vector<Ranked> worst;
+        };
+
+        size_t worstCount;
+        std::array<Series, kMetricCount> series;
+
+        void add(const HostSample& sample, Report& report) {
+            ++report.snapshots;
+            std::string host = sample.host.empty() ? "(unnamed)" : sample.host;
+            for (int i = 0; i < kMetricCount; ++i) {
+                double value = sample.values[i];
+                if (!sample.present[i] || !std::isfinite(value)) {
+                    continue;
+                }
+                Series& s = series[i];
+                s.min = s.moments.samples() == 0 ? value : std::min(s.min, value);
+                s.max = s.moments.samples() == 0 ? value : std::max(s.max, value);
+                s.moments.add(value);
+                s.sketch.add(value);
+                rank(s.worst, worstCount, host, value, higherIsWorse(static_cast<Metric>(i)));
+            }
+            if (sample.present[static_cast<int>(Metric::HealthScore)]) {
+                int score = static_cast<int>(sample.values[static_cast<int>(Metric::HealthScore)]);
+                ++report.healthHistogram[std::clamp(score / 10, 0, 9)];
+            }
+        }
+
+        void add(const IntegritySummary& summary, Report& report) {
+            ++report.integrityRuns;
+            report.tracked += summary.tracked;
+            report.changed += summary.changed;
+            report.missing += summary.missing;
+            report.added += summary.added;
+            report.errors += summary.errors;
+            uint64_t issues = summary.changed + summary.missing + summary.errors;
+            if (issues > 0 || summary.added > 0) {
+                ++report.integrityRunsWithIssues;
+            }
+            if (issues > 0) {
+                std::string host = summary.host.empty() ? "(unnamed)" : summary.host;
+                if (!summary.root.empty()) {
+                    host += ":" + summary.root;
+                }
+                rank(report.worstIntegrity, worstCount, host, static_cast<double>(issues), true);
+            }
+        }
+    };
+} // namespace
+
+    const char* metricKey(Metric metric) {
+        return kMetrics[static_cast<size_t>(metric)].key;
+    }
+
+    const char* metricLabel(Metric metric) {
+        return kMetrics[static_cast<size_t>(metric)].label;
+    }
+
+    const char* metricUnit(Metric metric) {
+        return kMetrics[static_cast<size_t>(metric)].unit;
+    }
+
+    bool higherIsWorse(Metric metric) {
+        return metric != Metric::HealthScore;
+    }
+
+    HostSample sample(const Metrics::Snapshot& snapshot) {
+        HostSample result;
+        result.host = snapshot.hostName;
+        result.timestampMs = snapshot.timestampMs;
+        // The health inputs already carry the per-host derivations (fullest mount,
+        // busiest disk, load per core) and which metrics were collected
+        Health::Inputs inputs = Metrics::healthInputs(snapshot);
+        static const std::pair<Health::Metric, Metric> kShared[] = {
+            { Health::Metric::CpuUsage, Metric::CpuUsage },
+            { Health::Metric::RamUsage, Metric::RamUsage },
+            { Health::Metric::DiskUsage, Metric::DiskUsage },
+            { Health::Metric::DiskIOUtilization, Metric::DiskIoUtilization },
+            { Health::Metric::LoadPerCore, Metric::LoadPerCore },
+            { Health::Metric::RunQueueWait, Metric::RunQueueWait },
+            { Health::Metric::CpuPressure, Metric::CpuPressure },
+            { Health::Metric::MemoryPressure, Metric::MemoryPressure },
+            { Health::Metric::IoPressure, Metric::IoPressure },
+            { Health::Metric::SwapActivity, Metric::SwapActivity },
+        };
+        for (const auto& [health, fleet] : kShared) {
+            int index = static_cast<int>(health);
+            if (inputs.present[index]) {
+                result.set(fleet, inputs.values[index]);
+            }
+        }
+        if (snapshot.ratesReady.memory && snapshot.memory.available) {
+            result.set(Metric::MajorFaults, snapshot.memoryActivity.majorFaultsPerSec);
+        }
+        if (snapshot.cpuTempC >= 0.0) {
+            result.set(Metric::CpuTemperature, snapshot.cpuTempC);
+        }
+        result.set(Metric::HealthScore, Health::evaluate(inputs).score);
+        return result;
+    }
+
+    IntegritySummary summarize(const std::string& host, const std::string& root, const Integrity::CheckResult& result) {
+        IntegritySummary summary;
+        summary.host = host;
+        summary.root = root;
+        summary.timestampMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        summary.tracked = static_cast<uint64_t>(result.total);
+        summary.ok = static_cast<uint64_t>(result.ok);
+        summary.changed = static_cast<uint64_t>(result.changed);
+        summary.missing = static_cast<uint64_t>(result.missing);
+        summary.added = static_cast<uint64_t>(result.added);
+        summary.errors = static_cast<uint64_t>(result.errors);
+        summary.unlinked = static_cast<uint64_t>(result.unlinked);
+        return summary;
+    }
+
+    void writeJson(const Metrics::Snapshot& snapshot, std::ostream& out) {
+        HostSample values = sample(snapshot);
+        Health::Report health = Health::evaluate(Metrics::healthInputs(snapshot));
+        out << "{\"format\":\"" << kSnapshotFormat << "\",\"version\":" << kJsonVersion << ",\"host\":";
+        writeString(out, snapshot.hostName);
+        out << ",\"timestamp_ms\":" << snapshot.timestampMs << ",\"os\":";
+        writeString(out, snapshot.osName);
+        out << ",\"cpu_model\":";
+        writeString(out, snapshot.cpuModel);
+        out << ",\"threads\":" << snapshot.threads
+            << ",\"total_ram_bytes\":" << snapshot.totalRamBytes
+            << ",\"uptime_seconds\":" << snapshot.uptimeSeconds
+            << ",\"rates_ready\":" << (snapshot.ratesReady.all() ? "true" : "false")
+            << ",\"health\":{\"score\":" << health.score << ",\"status\":";
+        writeString(out, Health::statusName(health.status));
+        out << "},\"metrics\":{";
+        bool first = true;
+        for (int i = 0; i < kMetricCount; ++i) {
+            if (!values.present[i]) {
+                continue;
+            }
+            out << (first ? "" : ",") << '"' << kMetrics[i].key << "\":";
+            writeNumber(out, values.values[i]);
+            first = false;
+        }
+        out << "},\"sections\":{";
+        for (int i = 0; i < Metrics::kSectionCount; ++i) {
+            out << (i ? "," : "") << '"' << Metrics::sectionName(static_cast<Metrics::Section>(i)) << "\":\""
+                << sectionStateName(static_cast<Metrics::SectionState>(snapshot.sectionState[i])) << '"';
+        }
+        out << "}}\n";
+    }
+
+    void writeJson(const IntegritySummary& summary, std::ostream& out) {
+        out << "{\"format\":\"" << kIntegrityFormat << "\",\"version\":" << kJsonVersion << ",\"host\":";
+        writeString(out, summary.host);
+        out << ",\"root\":";
+        writeString(out, summary.root);
+        out << ",\"timestamp_ms\":" << summary.timestampMs
+            << ",\"tracked\":" << summary.tracked
+            << ",\"ok\":" << summary.ok
+            << ",\"changed\":" << summary.changed
+            << ",\"missing\":" << summary.missing
+            << ",\"new\":" << summary.added
+            << ",\"errors\":" << summary.errors
+            << ",\"unlinked\":" << summary.unlinked << "}\n";
+    }
+
+    void writeBinary(const Metrics::Snapshot& snapshot, std::ostream& out) {
+        BinaryHeader header;
+        std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+        header.version = SharedMetrics::kLayoutVersion;
+        header.snapshotSize = sizeof(Metrics::Snapshot);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&snapshot), sizeof(snapshot));
+    }
+
+    bool aggregate(const std::string& input, const Options& options, Report& report, std::string* error) {
+        report = Report{};
+        size_t threads = options.threads;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        Async::Executor pool(threads);
+        Accumulator totals(options.worst);
+        std::deque<std::future<Batch>> inFlight;
+        // Parsed batches are merged in submission order; at most this many wait at once
+        const size_t window = threads * 2;
+        auto drain = [&](size_t keep) {
+            while (inFlight.size() > keep) {
+                Batch batch = inFlight.front().get();
+                inFlight.pop_front();
+                if (!batch.skipped) {
+                    report.inputs += batch.inputs;
+                }
+                totals.merge(batch, report);
+            }
+        };
+
+        // Records are grouped into chunks so workers get enough to parse per task, and
+        // a large file or a stream is parsed by several workers instead of one
+        auto readChunked = [&](std::istream& in, const std::string& name, bool countInput) {
+            std::string chunk;
+            uint64_t chunks = 0;
+            auto submit = [&] {
+                std::string source = name + " chunk " + std::to_string(++chunks);
+                uint64_t inputs = countInput && chunks == 1 ? 1 : 0;
+                inFlight.push_back(pool.submit([data = std::move(chunk), source, inputs] {
+                    Batch batch;
+                    batch.inputs = inputs;
+                    parseRecords(data, source, batch);
+                    return batch;
+                }));
+                chunk.clear();
+                drain(window);
+            };
+            std::string problem;
+            while (readRecord(in, chunk, problem)) {
+                if (!problem.empty()) {
+                    Batch rejected;
+                    reject(rejected, name, problem);
+                    totals.merge(rejected, report);
+                    problem.clear();
+                }
+                if (chunk.size() >= kChunkBytes) {
+                    submit();
+                }
+            }
+            if (!chunk.empty()) {
+                submit();
+            }
+        };
+        // Files up to a chunk are read and parsed whole on a worker
+        auto readFile = [&](const std::filesystem::path& path) {
+            std::error_code sizeError;
+            if (std::filesystem::file_size(path, sizeError) > kChunkBytes && !sizeError) {
+                std::ifstream file(path, std::ios::binary);
+                if (file) {
+                    if (startsLikeExport(file)) {
+                        readChunked(file, path.string(), true);
+                    }
+                    return;
+                }
+            }
+            inFlight.push_back(pool.submit([path] { return parseFile(path); }));
+            drain(window);
+        };
+
+        if (input == "-") {
+            readChunked(std::cin, "stdin", false);
+            drain(0);
+            report.inputs = 1;
+        } else {
+            std::error_code ec;
+            std::filesystem::path root(input);
+            if (std::filesystem::is_regular_file(root, ec)) {
+                readFile(root);
+            } else if (std::filesystem::is_directory(root, ec)) {
+                std::filesystem::recursive_directory_iterator it(root,
+                    std::filesystem::directory_options::skip_permission_denied, ec);
+                for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+                    std::error_code statError;
+                    if (!it->is_regular_file(statError)) {
+                        continue;
+                    }
+                    readFile(it->path());
+                }
+                if (ec) {
+                    drain(0);
+                    if (error) {
+                        *error = "Unable to read " + input + ": " + ec.message();
+                    }
+                    return false;
+                }
+            } else {
+                if (error) {
+                    *error = "No such file or directory: " + input;
+                }
+                return false;
+            }
+            drain(0);
+        }
+        totals.finish(report);
+        return true;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "snapshot.h"
+#include "integrity.h"
+
+// Fleet namespace encapsulating snapshot export files and the aggregation of
+// many hosts' exports into one fleet-wide report
+namespace Fleet {
+
+    // Per-host values compared across the fleet
+    enum class Metric {
+        CpuUsage,
+        RamUsage,
+        DiskUsage,
+        DiskIoUtilization,
+        LoadPerCore,
+        RunQueueWait,
+        CpuPressure,
+        MemoryPressure,
+        IoPressure,
+        SwapActivity,
+        MajorFaults,
+        CpuTemperature,
+        HealthScore,
+        Count
+    };
+    constexpr int kMetricCount = static_cast<int>(Metric::Count);
+
+    // JSON key ("cpu_usage"), label and unit of a metric
+    const char* metricKey(Metric metric);
+    const char* metricLabel(Metric metric);
+    const char* metricUnit(Metric metric);
+
+    // True for every metric except the health score, where low values are the bad ones
+    bool higherIsWorse(Metric metric);
+
+    // The comparable values of one snapshot; metrics the host did not collect are absent
+    struct HostSample {
+        std::string host;
+        uint64_t timestampMs = 0;
+        double values[kMetricCount] = {};
+        bool present[kMetricCount] = {};
+
+        void set(Metric metric, double value) {
+            values[static_cast<int>(metric)] = value;
+            present[static_cast<int>(metric)] = true;
+        }
+    };
+
+    // Derives the fleet metrics (and the default-config health score) from a snapshot
+    HostSample sample(const Metrics::Snapshot& snapshot);
+
+    // Counts from one "integrity check" run
+    struct IntegritySummary {
+        std::string host;
+        std::string root;
+        uint64_t timestampMs = 0;
+        uint64_t tracked = 0;
+        uint64_t ok = 0;
+        uint64_t changed = 0;
+        uint64_t missing = 0;
+        uint64_t added = 0;
+        uint64_t errors = 0;
+        uint64_t unlinked = 0;
+    };
+
+    IntegritySummary summarize(const std::string& host, const std::string& root, const Integrity::CheckResult& result);
+
+    // Export formats. JSON is one object per line ("sit-snapshot" or "sit-integrity"),
+    // so exports can be concatenated and streamed. Binary is a small header followed by
+    // the raw Snapshot; it is only readable by a build with the same layout version.
+    void writeJson(const Metrics::Snapshot& snapshot, std::ostream& out);
+    void writeJson(const IntegritySummary& summary, std::ostream& out);
+    void writeBinary(const Metrics::Snapshot& snapshot, std::ostream& out);
+
+    struct Options {
+        size_t threads = 0;         // Parser threads; 0 uses the hardware concurrency
+        size_t worst = 5;           // Hosts listed per metric
+    };
+
+    struct Ranked {
+        std::string host;
+        double value = 0.0;
+    };
+
+    struct MetricSummary {
+        Metric metric = Metric::CpuUsage;
+        uint64_t hosts = 0;         // Snapshots that reported the metric
+        double min = 0.0;
+        double mean = 0.0;
+        double max = 0.0;
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+        std::vector<Ranked> worst;  // Worst first, one entry per host
+    };
+
+    struct Report {
+        uint64_t inputs = 0;        // Files read (or 1 for a stream)
+        uint64_t snapshots = 0;
+        uint64_t rejected = 0;      // Records that could not be parsed
+        std::vector<std::string> problems;      // The first few rejection reasons
+        std::array<uint64_t, 10> healthHistogram{};     // Scores 0-9, 10-19, ... 90-100
+        std::vector<MetricSummary> metrics;     // Metrics at least one host reported
+
+        // Integrity summaries
+        uint64_t integrityRuns = 0;
+        uint64_t integrityRunsWithIssues = 0;
+        uint64_t tracked = 0;
+        uint64_t changed = 0;
+        uint64_t missing = 0;
+        uint64_t added = 0;
+        uint64_t errors = 0;
+        std::vector<Ranked> worstIntegrity;     // By changed + missing + errors
+    };
+
+    // Reads every export in a directory (recursively), or a stream of concatenated
+    // exports from stdin when input is "-", parsing on a worker pool. Memory stays
+    // bounded: distributions are fixed-size sketches, worst lists hold Options::worst
+    // entries, and only a few parsed batches are in flight at once.
+    bool aggregate(const std::string& input, const Options& options, Report& report, std::string* error);
+}
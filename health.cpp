@@ -1,63 +1,279 @@
-#ifdef _WIN32
-#define UNICODE
-#include <windows.h>          // For Windows API functions
-#include <intrin.h>          // For __cpuid
-#include <cstring>          // For memcpy
-#endif
+#include "health.h"
 
+#include <algorithm>       // For std::min and std::max
 #include <cstdint>          // For uint64_t
 #include <string>          // For std::string
-#include <sstream>        // For std::ostringstream
 #include <iomanip>       // For std::fixed and std::setprecision
-
-#ifndef _WIN32
-#include <fstream>         // For file input/output (reading /proc and /etc files)
-#include <filesystem>     // For std::filesystem::space (replaces statvfs for disk info)
-#include <cstdlib>       // For getenv (replaces getlogin/getpwuid for username)
-#endif
+#include <fstream>      // For reading scoring config files
 
 // Implementation of System Health functions
 namespace Health {
+namespace {
+    // Scores at or above this are Good, at or above kModerateScore Moderate, else Critical
+    constexpr int kGoodScore = 80;
+    constexpr int kModerateScore = 60;
 
-    // Returns the CPU health score
-    std::string CPUhp(double cpuUsage) {
-        if (cpuUsage < 50.0) {
-            return "Good";
-        } else if (cpuUsage < 80.0) {
-            return "Moderate";
+    const Rule* findRule(const Config& config, Metric metric) {
+        for (const auto& rule : config.rules) {
+            if (rule.metric == metric) {
+                return &rule;
+            }
+        }
+        return nullptr;
+    }
+
+    // 100 up to warn, falling linearly to 40 at crit and to 0 one band beyond crit
+    int scoreFor(const Rule& rule, double value) {
+        if (value <= rule.warn) {
+            return 100;
+        }
+        double band = std::max(rule.crit - rule.warn, 1e-9);
+        if (value < rule.crit) {
+            return static_cast<int>(100.0 - 60.0 * (value - rule.warn) / band);
+        }
+        double beyond = (value - rule.crit) / band;
+        return std::max(0, static_cast<int>(40.0 - 40.0 * beyond));
+    }
+
+    Status statusForScore(int score) {
+        if (score >= kGoodScore) {
+            return Status::Good;
+        } else if (score >= kModerateScore) {
+            return Status::Moderate;
+        }
+        return Status::Critical;
+    }
+
+    // Same boundaries as scoreFor and writeReason: warn itself is still Good
+    Status statusForValue(const Rule& rule, double value) {
+        if (value <= rule.warn) {
+            return Status::Good;
+        } else if (value < rule.crit) {
+            return Status::Moderate;
+        }
+        return Status::Critical;
+    }
+
+    void writeValue(std::ostream& out, double value, const char* unit) {
+        out << std::setprecision(value < 10.0 ? 2 : 1) << value << unit;
+    }
+
+    std::string trim(const std::string& text) {
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string::npos) {
+            return std::string();
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(start, end - start + 1);
+    }
+} // namespace
+
+    // Returns the built-in scoring table. Contention signals carry more weight than
+    // raw utilisation and veto the overall result: a busy but uncontended machine is
+    // healthy, a stalled one is not, however idle its other resources are.
+    const Config& defaultConfig() {
+        static const Config config = {{
+            { Metric::CpuUsage,          "cpu_usage",       "CPU usage",                   "%",         50.0,   80.0, 1.0, false },
+            { Metric::RamUsage,          "ram_usage",       "RAM usage",                   "%",         50.0,   80.0, 1.0, false },
+            { Metric::DiskUsage,         "disk_usage",      "Disk usage",                  "%",         70.0,   90.0, 1.0, false },
+            { Metric::DiskIOUtilization, "disk_io",         "Busiest disk utilisation",    "%",         60.0,   90.0, 1.0, false },
+            { Metric::CpuPressure,       "cpu_pressure",    "CPU pressure (some avg10)",   "%",         10.0,   40.0, 2.0, true },
+            { Metric::MemoryPressure,    "memory_pressure", "Memory pressure (some avg10)", "%",         5.0,   20.0, 3.0, true },
+            { Metric::IoPressure,        "io_pressure",     "I/O pressure (some avg10)",   "%",         10.0,   40.0, 2.0, true },
+            { Metric::LoadPerCore,       "load_per_core",   "1 min load per core",         "",           1.0,    2.0, 2.0, true },
+            { Metric::SwapActivity,      "swap_activity",   "Swap in+out",                 " pages/s", 100.0, 1000.0, 2.0, true },
+            { Metric::RunQueueWait,      "run_queue_wait",  "Run-queue wait per CPU",      "%",         10.0,   50.0, 2.0, true },
+        }};
+        return config;
+    }
+
+    bool loadConfig(const std::filesystem::path& path, Config& config, std::string* error) {
+        std::ifstream in(path);
+        if (!in) {
+            if (error) {
+                *error = "Unable to open health config: " + path.string();
+            }
+            return false;
+        }
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            line = trim(line);
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            size_t equal = line.find('=');
+            size_t dot = line.find('.');
+            if (equal == std::string::npos || dot == std::string::npos || dot > equal) {
+                if (error) {
+                    *error = "Health config parse error on line " + std::to_string(lineNumber) + ".";
+                }
+                return false;
+            }
+            std::string name = trim(line.substr(0, dot));
+            std::string field = trim(line.substr(dot + 1, equal - dot - 1));
+            std::string valueText = trim(line.substr(equal + 1));
+
+            auto rule = std::find_if(config.rules.begin(), config.rules.end(),
+                [&](const Rule& r) { return r.name == name; });
+            if (rule == config.rules.end()) {
+                if (error) {
+                    *error = "Unknown health rule '" + name + "' on line " + std::to_string(lineNumber) + ".";
+                }
+                return false;
+            }
+            double value = 0.0;
+            try {
+                value = std::stod(valueText);
+            } catch (...) {
+                if (error) {
+                    *error = "Invalid number on line " + std::to_string(lineNumber) + ".";
+                }
+                return false;
+            }
+            if (field == "weight") {
+                rule->weight = value;
+            } else if (field == "warn") {
+                rule->warn = value;
+            } else if (field == "crit") {
+                rule->crit = value;
+            } else if (field == "veto") {
+                rule->veto = value != 0.0;
+            } else {
+                if (error) {
+                    *error = "Unknown field '" + field + "' on line " + std::to_string(lineNumber) + ".";
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Report evaluate(const Inputs& inputs, const Config& config) {
+        Report report;
+        double weighted = 0.0;
+        double totalWeight = 0.0;
+        int vetoScore = 100;
+        Status vetoStatus = Status::Good;
+        int vetoFactor = -1;
+        for (const auto& rule : config.rules) {
+            int index = static_cast<int>(rule.metric);
+            if (!inputs.present[index] || rule.weight <= 0.0) {
+                continue;
+            }
+            if (report.factorCount >= kMetricCount) {
+                break;      // A config listing a metric twice
+            }
+            Factor& factor = report.factors[report.factorCount++];
+            factor.metric = rule.metric;
+            factor.name = rule.name;
+            factor.label = rule.label;
+            factor.unit = rule.unit;
+            factor.value = inputs.values[index];
+            factor.warn = rule.warn;
+            factor.crit = rule.crit;
+            factor.weight = rule.weight;
+            factor.score = scoreFor(rule, factor.value);
+            factor.status = statusForValue(rule, factor.value);
+            weighted += factor.score * rule.weight;
+            totalWeight += rule.weight;
+            if (rule.veto && (factor.score < vetoScore || factor.status > vetoStatus)) {
+                vetoScore = std::min(vetoScore, factor.score);
+                vetoStatus = std::max(vetoStatus, factor.status);
+                vetoFactor = report.factorCount - 1;
+            }
+        }
+        report.score = totalWeight > 0.0 ? static_cast<int>(weighted / totalWeight + 0.5) : 100;
+        report.status = statusForScore(report.score);
+        if (vetoScore < report.score || vetoStatus > report.status) {
+            report.score = std::min(report.score, vetoScore);
+            report.status = std::max(statusForScore(report.score), vetoStatus);
+            report.cappedBy = vetoFactor;
+        }
+        return report;
+    }
+
+    void writeReason(std::ostream& out, const Factor& factor) {
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed;
+        writeValue(out, factor.value, factor.unit);
+        if (factor.value <= factor.warn) {
+            out << " is within the normal range (warn at ";
+            writeValue(out, factor.warn, factor.unit);
+            out << ")";
+        } else if (factor.value < factor.crit) {
+            out << " is above the warning level of ";
+            writeValue(out, factor.warn, factor.unit);
         } else {
-            return "Critical";
+            out << " is at or above the critical level of ";
+            writeValue(out, factor.crit, factor.unit);
         }
+        out.flags(flags);
+        out.precision(precision);
     }
 
-    // Returns the RAM health score
-    std::string RAMhp(double ramUsage) {
-        if (ramUsage < 50.0) {
+    const char* statusName(Status status) {
+        switch (status) {
+        case Status::Good:
             return "Good";
-        } else if (ramUsage < 80.0) {
+        case Status::Moderate:
             return "Moderate";
-        } else {
+        case Status::Critical:
             return "Critical";
+        case Status::Unknown:
+            break;
         }
+        return "Unknown";
+    }
+
+    Status status(Metric metric, double value, const Config& config) {
+        const Rule* rule = findRule(config, metric);
+        return rule ? statusForValue(*rule, value) : Status::Unknown;
+    }
+
+    // Returns the CPU health score
+    Status CPUhp(double cpuUsage) {
+        return status(Metric::CpuUsage, cpuUsage);
+    }
+
+    // Returns the RAM health score
+    Status RAMhp(double ramUsage) {
+        return status(Metric::RamUsage, ramUsage);
     }
 
     // Returns the disk health score
-    std::string Diskhp(double diskUsage) {
-        if (diskUsage < 70.0) {
-            return "Good";
-        } else if (diskUsage < 90.0) {
-            return "Moderate";
-        } else {
-            return "Critical";
+    Status Diskhp(double diskUsage) {
+        return status(Metric::DiskUsage, diskUsage);
+    }
+
+    // Returns the disk health of the fullest mount (blocks or inodes, whichever is worse),
+    // or Unknown when no mount answered
+    Status Diskhp(const std::vector<SystemInfo::MountUsage>& mounts) {
+        double worst = 0.0;
+        bool answered = false;
+        for (const auto& mount : mounts) {
+            if (!mount.timedOut && !mount.failed) {
+                worst = std::max(worst, SystemInfo::worstUsage(mount));
+                answered = true;
+            }
         }
+        return answered ? Diskhp(worst) : Status::Unknown;
+    }
+
+    // Returns the disk I/O health based on device utilisation (busy time)
+    Status DiskIOhp(double utilization) {
+        return status(Metric::DiskIOUtilization, utilization);
     }
 
-    // Returns overall health score
+    // Returns overall health score from utilisation alone
     int overallScore(double cpu, double ram, double disk) {
-        int cpuScore = (cpu < 50.0) ? 100 : (cpu < 80.0) ? 70 : 40;
-        int ramScore = (ram < 50.0) ? 100 : (ram < 80.0) ? 70 : 40;
-        int diskScore = (disk < 70.0) ? 100 : (disk < 90.0) ? 70 : 40;
-        return (cpuScore + ramScore + diskScore) / 3;
+        Inputs inputs;
+        inputs.set(Metric::CpuUsage, cpu);
+        inputs.set(Metric::RamUsage, ram);
+        inputs.set(Metric::DiskUsage, disk);
+        return evaluate(inputs).score;
     }
 
 }
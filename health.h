@@ -1,11 +1,116 @@
 #pragma once
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
 #include <string>
+#include <vector>
+#include "systemInfo.h"
 
 namespace Health {
 
-    std::string CPUhp(double cpuUsage);
-    std::string RAMhp(double ramUsage);
-    std::string Diskhp(double diskUsage);
+    // Signals the scoring engine understands. Utilisation metrics say how busy a
+    // resource is; pressure, load and swap metrics say whether work is waiting on it.
+    enum class Metric {
+        CpuUsage,
+        RamUsage,
+        DiskUsage,
+        DiskIOUtilization,
+        CpuPressure,
+        MemoryPressure,
+        IoPressure,
+        LoadPerCore,
+        SwapActivity,
+        RunQueueWait,
+        Count
+    };
+
+    constexpr int kMetricCount = static_cast<int>(Metric::Count);
+
+    enum class Status : uint8_t {
+        Good,
+        Moderate,
+        Critical,
+        Unknown
+    };
+
+    // "Good", "Moderate", "Critical" or "Unknown"
+    const char* statusName(Status status);
+
+    // One row of the scoring table: a metric is Good up to and including warn,
+    // Moderate above it and Critical from crit. A veto rule caps the overall score and
+    // status at its own, so one stalled resource is not averaged away by idle ones.
+    // The strings are static; a config file only overrides the numbers.
+    struct Rule {
+        Metric metric;
+        const char* name;     // Key used in config files, e.g. "memory_pressure"
+        const char* label;    // Human readable description
+        const char* unit;
+        double warn;
+        double crit;
+        double weight;
+        bool veto = false;
+    };
+
+    struct Config {
+        std::vector<Rule> rules;
+    };
+
+    // Measured values; metrics that were not collected are skipped when scoring
+    struct Inputs {
+        double values[kMetricCount] = {};
+        bool present[kMetricCount] = {};
+
+        void set(Metric metric, double value) {
+            values[static_cast<int>(metric)] = value;
+            present[static_cast<int>(metric)] = true;
+        }
+    };
+
+    // Score of a single rule, with the thresholds it was judged against so the
+    // reason can be written out later (see writeReason)
+    struct Factor {
+        Metric metric = Metric::CpuUsage;
+        const char* name = "";
+        const char* label = "";
+        const char* unit = "";
+        double value = 0.0;
+        double warn = 0.0;
+        double crit = 0.0;
+        double weight = 0.0;
+        int score = 100;
+        Status status = Status::Good;
+    };
+
+    // Fixed size so scoring does not allocate; one factor per scored metric
+    struct Report {
+        int score = 100;
+        Status status = Status::Good;
+        Factor factors[kMetricCount];
+        int factorCount = 0;
+        int cappedBy = -1;          // Index of the veto factor that lowered score or status, or -1
+    };
+
+    // Built-in scoring table
+    const Config& defaultConfig();
+
+    // Overrides rules from a file of "<rule>.<weight|warn|crit|veto> = <value>" lines
+    bool loadConfig(const std::filesystem::path& path, Config& config, std::string* error);
+
+    // Scores every present metric and combines them into a weighted overall score,
+    // capped by the worst veto factor
+    Report evaluate(const Inputs& inputs, const Config& config = defaultConfig());
+
+    // Writes why a factor got its score, e.g. "85.0% is at or above the critical level of 80.0%"
+    void writeReason(std::ostream& out, const Factor& factor);
+
+    // Status of a single metric value
+    Status status(Metric metric, double value, const Config& config = defaultConfig());
+
+    Status CPUhp(double cpuUsage);
+    Status RAMhp(double ramUsage);
+    Status Diskhp(double diskUsage);
+    Status Diskhp(const std::vector<SystemInfo::MountUsage>& mounts);
+    Status DiskIOhp(double utilization);
 
     int overallScore(double cpu, double ram, double disk);
     
@@ -1,8 +1,12 @@
 // integrity.cpp integration manifest implementation
 #include "integrity.h"
+#include "integrityDetail.h"
+#include "profile.h"
+#include "executor.h"
 
 // Standard library includes for succesful implementation
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
 #include <cstdint>
 #include <fstream>
@@ -12,148 +16,156 @@
 #include <vector>
 #include <chrono>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/stat.h>   // For stat
+#include <cerrno>
+#endif
 
 namespace Integrity {
 namespace {
-    constexpr const char kManifestHeader[] = "# SIT-INTEGRITY-1 SHA256";
+    using Clock = std::chrono::steady_clock;
 
-    struct ManifestEntry {
-        uint64_t size = 0;
-        int64_t mtime = 0;
-        std::string hash;
-        bool seen = false;
-    };
+    // Hashing waits on I/O, but far more workers than cores only adds contention
+    constexpr size_t kMaxThreadsPerCore = 4;
+
+    uint32_t rotr(uint32_t value, uint32_t bits) {
+        return (value >> bits) | (value << (32 - bits));
+    }
 
     struct FileRecord {
         std::string relPath;
         uint64_t size = 0;
         int64_t mtime = 0;
         std::string hash;
+        std::string fingerprint;
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t linkGroup = 0;
     };
 
-    uint32_t rotr(uint32_t value, uint32_t bits) {
-        return (value >> bits) | (value << (32 - bits));
-    }
+    // Where a file's data lives. Inode 0 means unknown (Windows, or the lookup failed).
+    struct FileIdentity {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t links = 1;
 
-    class Sha256 {
-    public:
-        Sha256() {
-            reset();
+        bool operator==(const FileIdentity& other) const {
+            return device == other.device && inode == other.inode;
         }
+    };
 
-        void update(const uint8_t* data, size_t length) {
-            for (size_t i = 0; i < length; ++i) {
-                buffer[bufferLen++] = data[i];
-                if (bufferLen == buffer.size()) {
-                    transform(buffer.data());
-                    bitLen += 512;
-                    bufferLen = 0;
-                }
-            }
+    struct FileIdentityHash {
+        size_t operator()(const FileIdentity& id) const {
+            return std::hash<uint64_t>()(id.inode) ^ (std::hash<uint64_t>()(id.device) << 1);
         }
+    };
 
-        std::string finalHex() {
-            uint64_t totalBits = bitLen + static_cast<uint64_t>(bufferLen) * 8;
-            buffer[bufferLen++] = 0x80;
-            if (bufferLen > 56) {
-                while (bufferLen < buffer.size()) {
-                    buffer[bufferLen++] = 0;
-                }
-                transform(buffer.data());
-                bufferLen = 0;
+    // Value of key=value in a manifest line's extra fields, empty if absent
+    std::string extraField(const std::string& extras, const std::string& key) {
+        std::istringstream iss(extras);
+        for (std::string field; std::getline(iss, field, '\t');) {
+            if (field.size() > key.size() && field.compare(0, key.size(), key) == 0 && field[key.size()] == '=') {
+                return field.substr(key.size() + 1);
             }
-            while (bufferLen < 56) {
-                buffer[bufferLen++] = 0;
-            }
-            for (int i = 7; i >= 0; --i) {
-                buffer[bufferLen++] = static_cast<uint8_t>((totalBits >> (i * 8)) & 0xFF);
-            }
-            transform(buffer.data());
+        }
+        return std::string();
+    }
 
-            std::ostringstream oss;
-            oss << std::hex << std::setfill('0');
-            for (uint32_t word : state) {
-                oss << std::setw(8) << word;
-            }
-            reset();
-            return oss.str();
+    // Sampled fingerprints read about 1 block in kSampleDivisor, within these bounds
+    constexpr uint64_t kSampleDivisor = 100;
+    constexpr uint64_t kMinSampledBlocks = 4;
+    constexpr uint64_t kMaxSampledBlocks = 256;
+    constexpr size_t kFingerprintLength = 32;    // Hex digits kept from the digest
+
+    uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Version 2 manifests seeded the sampled blocks with the leading 64 bits of the full hash
+    uint64_t hashSeed(const std::string& fullHash, uint64_t size) {
+        try {
+            return std::stoull(fullHash.substr(0, 16), nullptr, 16);
+        } catch (...) {
+            return size;
         }
+    }
 
-    private:
-        std::array<uint8_t, 64> buffer{};
-        size_t bufferLen = 0;
-        uint64_t bitLen = 0;
-        std::array<uint32_t, 8> state{};
+    uint64_t blockCount(uint64_t size) {
+        return (size + detail::kSampleBlockSize - 1) / detail::kSampleBlockSize;
+    }
 
-        void reset() {
-            bufferLen = 0;
-            bitLen = 0;
-            state = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
-        }
-
-        void transform(const uint8_t* chunk) {
-            static const uint32_t k[64] = {
-                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-            };
+    uint64_t sampledBlockCount(uint64_t blocks) {
+        return std::clamp<uint64_t>(blocks / kSampleDivisor, kMinSampledBlocks, kMaxSampledBlocks);
+    }
 
-            uint32_t w[64];
-            for (int i = 0; i < 16; ++i) {
-                w[i] = (static_cast<uint32_t>(chunk[i * 4]) << 24)
-                    | (static_cast<uint32_t>(chunk[i * 4 + 1]) << 16)
-                    | (static_cast<uint32_t>(chunk[i * 4 + 2]) << 8)
-                    | (static_cast<uint32_t>(chunk[i * 4 + 3]));
-            }
-            for (int i = 16; i < 64; ++i) {
-                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
-                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
-                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
-            }
-
-            uint32_t a = state[0];
-            uint32_t b = state[1];
-            uint32_t c = state[2];
-            uint32_t d = state[3];
-            uint32_t e = state[4];
-            uint32_t f = state[5];
-            uint32_t g = state[6];
-            uint32_t h = state[7];
-
-            for (int i = 0; i < 64; ++i) {
-                uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
-                uint32_t ch = (e & f) ^ (~e & g);
-                uint32_t temp1 = h + s1 + ch + k[i] + w[i];
-                uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
-                uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
-                uint32_t temp2 = s0 + maj;
-
-                h = g;
-                g = f;
-                f = e;
-                e = d + temp1;
-                d = c;
-                c = b;
-                b = a;
-                a = temp1 + temp2;
-            }
-
-            state[0] += a;
-            state[1] += b;
-            state[2] += c;
-            state[3] += d;
-            state[4] += e;
-            state[5] += f;
-            state[6] += g;
-            state[7] += h;
+    // Files too small to sample carry no fingerprint; the sample tier hashes them whole
+    bool isSampled(uint64_t size) {
+        uint64_t blocks = blockCount(size);
+        return blocks > sampledBlockCount(blocks) + 2;
+    }
+
+    const char* tierName(Tier tier) {
+        switch (tier) {
+        case Tier::Sample:
+            return "sample";
+        case Tier::Full:
+            return "full";
+        default:
+            return "quick";
         }
+    }
+
+    // Indexed by Status and Reason. These are also the words journals record, so
+    // a resumed run can map a journal line back to its codes.
+    constexpr const char* kStatusNames[] = { "OK", "CHANGED", "NEW", "MISSING", "ERROR", "UNLINKED" };
+    constexpr const char* kReasonTexts[] = {
+        "",
+        "Not in manifest",
+        "Size changed",
+        "Sampled content mismatch",
+        "Hash mismatch",
+        "File not found",
+        "No longer a hard link to",
+        "Unable to read file size",
+        "Unable to read last write time",
+        "Unable to open file",
+        "Error while reading file",
+        "Unable to sample file",
+        "Unable to hash file",
+        "Directory scan error",
     };
+    static_assert(sizeof(kReasonTexts) / sizeof(kReasonTexts[0]) == static_cast<size_t>(Reason::Count),
+        "kReasonTexts must list every Reason");
+
+    Status statusFromName(const std::string& name) {
+        for (size_t i = 0; i < sizeof(kStatusNames) / sizeof(kStatusNames[0]); ++i) {
+            if (name == kStatusNames[i]) {
+                return static_cast<Status>(i);
+            }
+        }
+        return Status::Error;
+    }
+
+    // Maps a message from the hashing helpers or a journal back to its reason
+    Reason reasonFromText(const std::string& text, Reason fallback) {
+        for (size_t i = 1; i < static_cast<size_t>(Reason::Count); ++i) {
+            if (text == kReasonTexts[i]) {
+                return static_cast<Reason>(i);
+            }
+        }
+        return fallback;
+    }
 
     bool isExcludedDir(const std::filesystem::path& path) {
         auto name = path.filename().string();
@@ -167,7 +179,166 @@ namespace {
         return static_cast<int64_t>(system_clock::to_time_t(sctp));
     }
 
-    std::string hashFileSha256(const std::filesystem::path& path, std::string* error) {
+    // Iterator step, timed separately from the per-file work it leads to
+    void advance(std::filesystem::recursive_directory_iterator& it, std::error_code& ec) {
+        SIT_PROFILE_SCOPE(IntegrityWalk);
+        SIT_PROFILE_COUNT(DirEntries, 1);
+        it.increment(ec);
+    }
+
+    // Size, mtime and identity of one file. On failure sets ec and the lookup that failed.
+    bool statFile(const std::filesystem::path& path, uint64_t& size, int64_t& mtime, FileIdentity& identity,
+        std::error_code& ec, Reason* failure) {
+        SIT_PROFILE_SCOPE(IntegrityStat);
+#ifndef _WIN32
+        // One call, and the kernel's own seconds; converting file_time_type can be off by one
+        SIT_PROFILE_COUNT(Stats, 1);
+        struct stat info {};
+        if (::stat(path.c_str(), &info) != 0) {
+            ec = std::error_code(errno, std::generic_category());
+            *failure = Reason::UnreadableSize;
+            return false;
+        }
+        size = static_cast<uint64_t>(info.st_size);
+        mtime = static_cast<int64_t>(info.st_mtime);
+        identity = { static_cast<uint64_t>(info.st_dev), static_cast<uint64_t>(info.st_ino),
+            static_cast<uint64_t>(info.st_nlink) };
+        return true;
+#else
+        SIT_PROFILE_COUNT(Stats, 2);
+        size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            *failure = Reason::UnreadableSize;
+            return false;
+        }
+        identity = FileIdentity{};
+        auto mtimeFs = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            *failure = Reason::UnreadableTime;
+            return false;
+        }
+        mtime = toUnixSeconds(mtimeFs);
+        return true;
+#endif
+    }
+} // namespace
+
+namespace detail {
+    Sha256::Sha256() {
+        reset();
+    }
+
+    void Sha256::update(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            buffer[bufferLen++] = data[i];
+            if (bufferLen == buffer.size()) {
+                transform(buffer.data());
+                bitLen += 512;
+                bufferLen = 0;
+            }
+        }
+    }
+
+    std::string Sha256::finalHex() {
+        uint64_t totalBits = bitLen + static_cast<uint64_t>(bufferLen) * 8;
+        buffer[bufferLen++] = 0x80;
+        if (bufferLen > 56) {
+            while (bufferLen < buffer.size()) {
+                buffer[bufferLen++] = 0;
+            }
+            transform(buffer.data());
+            bufferLen = 0;
+        }
+        while (bufferLen < 56) {
+            buffer[bufferLen++] = 0;
+        }
+        for (int i = 7; i >= 0; --i) {
+            buffer[bufferLen++] = static_cast<uint8_t>((totalBits >> (i * 8)) & 0xFF);
+        }
+        transform(buffer.data());
+
+        std::ostringstream oss;
+        oss << std::hex << std::setfill('0');
+        for (uint32_t word : state) {
+            oss << std::setw(8) << word;
+        }
+        reset();
+        return oss.str();
+    }
+
+    void Sha256::reset() {
+        bufferLen = 0;
+        bitLen = 0;
+        state = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    }
+
+    void Sha256::transform(const uint8_t* chunk) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (static_cast<uint32_t>(chunk[i * 4]) << 24)
+                | (static_cast<uint32_t>(chunk[i * 4 + 1]) << 16)
+                | (static_cast<uint32_t>(chunk[i * 4 + 2]) << 8)
+                | (static_cast<uint32_t>(chunk[i * 4 + 3]));
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t temp1 = h + s1 + ch + k[i] + w[i];
+            uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = s0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    std::string hashFileSha256(const std::filesystem::path& path, std::string* error, IoBudget::Limiter* limiter,
+        std::string* fingerprint, uint64_t size, uint64_t seed) {
+        SIT_PROFILE_SCOPE(HashFile);
+        SIT_PROFILE_COUNT(Opens, 1);
         std::ifstream file(path, std::ios::binary);
         if (!file) {
             if (error) {
@@ -177,23 +348,133 @@ namespace {
         }
         Sha256 hasher;
         std::array<char, 8192> buffer;
+        // Sampled blocks are fed to a second hasher as the sequential read passes them
+        std::vector<uint64_t> blocks;
+        if (fingerprint) {
+            fingerprint->clear();
+            blocks = sampleBlocks(size, seed);
+        }
+        Sha256 sampler;
+        size_t nextBlock = 0;
+        uint64_t offset = 0;
         while (file) {
-            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (limiter) {
+                limiter->acquire(buffer.size());
+            }
+            {
+                SIT_PROFILE_SCOPE(HashRead);
+                file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            }
             std::streamsize count = file.gcount();
+            SIT_PROFILE_COUNT(Reads, 1);
+            if (limiter && static_cast<size_t>(count) < buffer.size()) {
+                limiter->release(buffer.size() - static_cast<size_t>(count));
+            }
             if (count > 0) {
+                SIT_PROFILE_SCOPE(HashCompute);
+                SIT_PROFILE_COUNT(BytesHashed, count);
                 hasher.update(reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(count));
+                uint64_t end = offset + static_cast<uint64_t>(count);
+                while (nextBlock < blocks.size() && blocks[nextBlock] * kSampleBlockSize < end) {
+                    uint64_t blockStart = blocks[nextBlock] * kSampleBlockSize;
+                    uint64_t from = std::max(blockStart, offset);
+                    uint64_t to = std::min(blockStart + kSampleBlockSize, end);
+                    sampler.update(reinterpret_cast<const uint8_t*>(buffer.data() + (from - offset)),
+                        static_cast<size_t>(to - from));
+                    if (to < blockStart + kSampleBlockSize) {
+                        break;      // The rest of the block comes with the next read
+                    }
+                    ++nextBlock;
+                }
+                offset = end;
             }
         }
-        if (!file.eof() && file.fail()) {
+        // Shorter than its size means the file shrank and the last sampled blocks are missing
+        if ((!file.eof() && file.fail()) || (!blocks.empty() && offset < size)) {
             if (error) {
                 *error = "Error while reading file";
             }
             return std::string();
         }
+        if (!blocks.empty()) {
+            *fingerprint = sampler.finalHex().substr(0, kFingerprintLength);
+        }
         return hasher.finalHex();
     }
 
-    bool parseManifestLine(const std::string& line, std::string& path, uint64_t& size, int64_t& mtime, std::string& hash) {
+    uint64_t fileSeed(const std::string& relPath, uint64_t size) {
+        uint64_t state = 0xcbf29ce484222325ULL;     // FNV-1a over the path, then mixed with the size
+        for (unsigned char c : relPath) {
+            state = (state ^ c) * 0x100000001b3ULL;
+        }
+        state ^= size;
+        return splitMix64(state);
+    }
+
+    std::vector<uint64_t> sampleBlocks(uint64_t size, uint64_t seed) {
+        if (!isSampled(size)) {
+            return {};
+        }
+        uint64_t blocks = blockCount(size);
+        uint64_t picks = sampledBlockCount(blocks);
+
+        uint64_t state = seed;
+        std::vector<uint64_t> chosen = { 0, blocks - 1 };
+        std::unordered_set<uint64_t> taken(chosen.begin(), chosen.end());
+        while (chosen.size() < picks + 2) {
+            uint64_t block = 1 + splitMix64(state) % (blocks - 2);
+            if (taken.insert(block).second) {
+                chosen.push_back(block);
+            }
+        }
+        std::sort(chosen.begin(), chosen.end());
+        return chosen;
+    }
+
+    std::string sampleFingerprint(const std::filesystem::path& path, uint64_t size, uint64_t seed,
+        std::string* error, IoBudget::Limiter* limiter) {
+        SIT_PROFILE_SCOPE(SampleFile);
+        SIT_PROFILE_COUNT(Opens, 1);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            if (error) {
+                *error = "Unable to open file";
+            }
+            return std::string();
+        }
+        Sha256 hasher;
+        std::array<char, kSampleBlockSize> buffer;
+        uint64_t lastBlock = blockCount(size) - 1;
+        for (uint64_t block : sampleBlocks(size, seed)) {
+            if (limiter) {
+                limiter->acquire(buffer.size());
+            }
+            {
+                SIT_PROFILE_SCOPE(HashRead);
+                file.seekg(static_cast<std::streamoff>(block * kSampleBlockSize));
+                file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            }
+            std::streamsize count = file.gcount();
+            SIT_PROFILE_COUNT(Reads, 1);
+            if (limiter && static_cast<size_t>(count) < buffer.size()) {
+                limiter->release(buffer.size() - static_cast<size_t>(count));
+            }
+            // The last block may be short; anything else means the file shrank
+            if (file.bad() || (static_cast<size_t>(count) < buffer.size() && block != lastBlock)) {
+                if (error) {
+                    *error = "Error while reading file";
+                }
+                return std::string();
+            }
+            file.clear();
+            SIT_PROFILE_COUNT(BytesHashed, count);
+            hasher.update(reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(count));
+        }
+        return hasher.finalHex().substr(0, kFingerprintLength);
+    }
+
+    bool parseManifestLine(const std::string& line, std::string& path, uint64_t& size, int64_t& mtime, std::string& hash,
+        std::string* extras) {
         std::string sizeStr;
         std::string mtimeStr;
         std::istringstream iss(line);
@@ -206,9 +487,13 @@ namespace {
         if (!std::getline(iss, mtimeStr, '\t')) {
             return false;
         }
-        if (!std::getline(iss, hash)) {
+        if (!std::getline(iss, hash, '\t')) {
             return false;
         }
+        if (extras) {
+            extras->clear();
+            std::getline(iss, *extras);
+        }
         try {
             size = std::stoull(sizeStr);
             mtime = std::stoll(mtimeStr);
@@ -221,6 +506,7 @@ namespace {
     bool loadManifest(const std::filesystem::path& manifestPath,
         std::unordered_map<std::string, ManifestEntry>& entries,
         std::string* error) {
+        SIT_PROFILE_SCOPE(ManifestLoad);
         std::ifstream in(manifestPath, std::ios::binary);
         if (!in) {
             if (error) {
@@ -235,7 +521,8 @@ namespace {
             }
             return false;
         }
-        if (header != kManifestHeader) {
+        if (header != kManifestHeader && header != kManifestHeaderV3 && header != kManifestHeaderV2
+            && header != kManifestHeaderV1) {
             if (error) {
                 *error = "Integrity manifest format not recognized.";
             }
@@ -253,18 +540,238 @@ namespace {
             uint64_t size = 0;
             int64_t mtime = 0;
             std::string hash;
-            if (!parseManifestLine(line, path, size, mtime, hash)) {
+            std::string extras;
+            if (!parseManifestLine(line, path, size, mtime, hash, &extras)) {
                 if (error) {
                     *error = "Integrity manifest parse error on line " + std::to_string(lineNumber) + ".";
                 }
                 return false;
             }
-            entries[path] = { size, mtime, hash, false };
+            ManifestEntry& entry = entries[path];
+            entry = { size, mtime, hash, std::string(), size, 0, false };
+            if (!extras.empty()) {
+                entry.fingerprint = extraField(extras, "fp");
+                if (header == kManifestHeader) {
+                    entry.sampleSeed = fileSeed(path, size);
+                } else if (header == kManifestHeaderV2) {
+                    entry.sampleSeed = hashSeed(hash, size);
+                }
+                std::string link = extraField(extras, "link");
+                if (!link.empty()) {
+                    try {
+                        entry.linkGroup = std::stoull(link);
+                    } catch (...) {
+                        if (error) {
+                            *error = "Integrity manifest parse error on line " + std::to_string(lineNumber) + ".";
+                        }
+                        return false;
+                    }
+                }
+            }
         }
         return true;
     }
+} // namespace detail
+
+namespace {
+    using detail::ManifestEntry;
+    using detail::hashFileSha256;
+    using detail::loadManifest;
+    using detail::kManifestHeader;
+
+    // Version 3 journals carry fingerprints seeded with fileSeed, as version 4 manifests do
+    constexpr const char kJournalHeader[] = "# SIT-INTEGRITY-JOURNAL-3";
+
+    // A checkpoint is written after whichever comes first
+    constexpr std::chrono::seconds kCheckpointInterval(5);
+    constexpr size_t kCheckpointEntries = 10000;
+
+    struct JournalEntry {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::string hash;       // init and update runs
+        std::string fingerprint;
+        Status status = Status::Ok;     // check runs
+        Reason reason = Reason::None;
+        bool consumed = false;
+    };
+
+    // What a resumed run takes over from the interrupted one
+    struct JournalReplay {
+        std::unordered_map<std::string, JournalEntry> files;
+        std::unordered_set<std::string> completedDirs;
+        std::unordered_set<std::string> skippedDirs;    // Completed directories this run did not walk again
+
+        bool underSkipped(const std::string& relPath) const {
+            for (size_t slash = relPath.rfind('/'); slash != std::string::npos && slash > 0;
+                 slash = relPath.rfind('/', slash - 1)) {
+                if (skippedDirs.count(relPath.substr(0, slash))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Append-only progress log next to the manifest. Lines are tab separated:
+    //   F path size mtime hash [fp]  hashed file (init/update)
+    //   R path status detail     file outcome (check)
+    //   D dir                    every file below dir has been recorded
+    //   K                        checkpoint; anything after the last one is discarded on resume
+    class Journal {
+    public:
+        bool open(const std::filesystem::path& root, const std::string& tag, bool resume,
+            JournalReplay& replay, std::string* error) {
+            journalPath = root / kJournalFileName;
+            std::string header = std::string(kJournalHeader) + " " + tag;
+            if (resume) {
+                if (!load(header, replay, error)) {
+                    return false;
+                }
+                out.open(journalPath, std::ios::binary | std::ios::app);
+            } else {
+                out.open(journalPath, std::ios::binary | std::ios::trunc);
+                out << header << "\nK\n";
+                out.flush();
+            }
+            if (!out) {
+                if (error) {
+                    *error = "Unable to write integrity journal.";
+                }
+                return false;
+            }
+            lastCheckpoint = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        void record(const std::string& relPath, uint64_t size, int64_t mtime, const std::string& hash,
+            const std::string& fingerprint) {
+            out << "F\t" << relPath << "\t" << size << "\t" << mtime << "\t" << hash << "\t" << fingerprint << "\n";
+            ++pending;
+        }
+
+        void result(const std::string& relPath, Status status, Reason reason) {
+            out << "R\t" << relPath << "\t" << statusName(status) << "\t" << reasonText(reason) << "\n";
+            ++pending;
+        }
+
+        void directoryDone(const std::string& relDir) {
+            out << "D\t" << relDir << "\n";
+        }
+
+        void checkpoint() {
+            auto now = std::chrono::steady_clock::now();
+            if (pending < kCheckpointEntries && now - lastCheckpoint < kCheckpointInterval) {
+                return;
+            }
+            out << "K\n";
+            out.flush();
+            pending = 0;
+            lastCheckpoint = now;
+        }
+
+        // Called once the run has completed and its result is safely written
+        void discard() {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(journalPath, ec);
+        }
 
-    bool writeManifest(const std::filesystem::path& root, bool allowOverwrite, std::string* error) {
+    private:
+        std::filesystem::path journalPath;
+        std::ofstream out;
+        size_t pending = 0;
+        std::chrono::steady_clock::time_point lastCheckpoint;
+
+        bool load(const std::string& header, JournalReplay& replay, std::string* error) {
+            std::ifstream in(journalPath, std::ios::binary);
+            std::string line;
+            if (!in || !std::getline(in, line)) {
+                if (error) {
+                    *error = "No integrity journal to resume from.";
+                }
+                return false;
+            }
+            if (line != header) {
+                if (error) {
+                    *error = "Integrity journal belongs to a different run. Start again without --resume.";
+                }
+                return false;
+            }
+
+            // Entries only count once a checkpoint follows them
+            std::vector<std::pair<std::string, JournalEntry>> files;
+            std::vector<std::string> dirs;
+            std::streamoff committed = in.tellg();
+            while (std::getline(in, line)) {
+                if (in.eof()) {
+                    break;      // Torn final line without a newline
+                }
+                std::vector<std::string> fields;
+                std::istringstream iss(line);
+                for (std::string field; std::getline(iss, field, '\t');) {
+                    fields.push_back(field);
+                }
+                if (line == "K") {
+                    for (auto& file : files) {
+                        replay.files[file.first] = std::move(file.second);
+                    }
+                    replay.completedDirs.insert(dirs.begin(), dirs.end());
+                    files.clear();
+                    dirs.clear();
+                    committed = in.tellg();
+                } else if ((fields.size() == 5 || fields.size() == 6) && fields[0] == "F") {
+                    JournalEntry entry;
+                    try {
+                        entry.size = std::stoull(fields[2]);
+                        entry.mtime = std::stoll(fields[3]);
+                    } catch (...) {
+                        break;
+                    }
+                    entry.hash = fields[4];
+                    entry.fingerprint = fields.size() > 5 ? fields[5] : std::string();
+                    files.emplace_back(fields[1], std::move(entry));
+                } else if (fields.size() >= 3 && fields[0] == "R") {
+                    JournalEntry entry;
+                    entry.status = statusFromName(fields[2]);
+                    entry.reason = fields.size() > 3 ? reasonFromText(fields[3], Reason::None) : Reason::None;
+                    files.emplace_back(fields[1], std::move(entry));
+                } else if (fields.size() == 2 && fields[0] == "D") {
+                    dirs.push_back(fields[1]);
+                } else {
+                    break;
+                }
+            }
+            in.close();
+
+            // Drop the uncommitted tail so new entries follow the last checkpoint directly
+            std::error_code ec;
+            std::filesystem::resize_file(journalPath, static_cast<uintmax_t>(committed), ec);
+            return true;
+        }
+    };
+
+    // Follows the recursive walk and reports each directory once every entry below it has been visited
+    class DirectoryTracker {
+    public:
+        template <typename Done>
+        void visit(int depth, Done&& done) {
+            while (static_cast<int>(open.size()) > depth) {
+                done(open.back());
+                open.pop_back();
+            }
+        }
+
+        void enter(std::string relDir) {
+            open.push_back(std::move(relDir));
+        }
+
+    private:
+        std::vector<std::string> open;      // Ancestors of the current entry below the root
+    };
+
+    bool writeManifest(const std::filesystem::path& root, bool allowOverwrite, std::string* error,
+        const Options& options) {
         std::error_code ec;
         if (!std::filesystem::exists(root, ec) || !std::filesystem::is_directory(root, ec)) {
             if (error) {
@@ -282,22 +789,39 @@ namespace {
         }
 
         std::vector<FileRecord> records;
+        std::unordered_map<FileIdentity, size_t, FileIdentityHash> hashedInodes;   // Index of the first record per inode
         int errorCount = 0;
+        IoBudget::Limiter limiter(options.io);
+
+        JournalReplay replay;
+        Journal journal;
+        if (!journal.open(root, "write", options.resume, replay, error)) {
+            return false;
+        }
+        DirectoryTracker tracker;
+        auto finished = [&journal](const std::string& relDir) { journal.directoryDone(relDir); };
 
         std::filesystem::recursive_directory_iterator it(
             root,
             std::filesystem::directory_options::skip_permission_denied,
             ec);
         std::filesystem::recursive_directory_iterator end;
-        for (; it != end; it.increment(ec)) {
+        for (; it != end; advance(it, ec)) {
             if (ec) {
                 ++errorCount;
                 ec.clear();
                 continue;
             }
+            tracker.visit(it.depth(), finished);
             if (it->is_directory(ec)) {
+                std::string relDir = it->path().lexically_relative(root).generic_string();
                 if (isExcludedDir(it->path())) {
                     it.disable_recursion_pending();
+                } else if (replay.completedDirs.count(relDir)) {
+                    it.disable_recursion_pending();
+                    replay.skippedDirs.insert(relDir);
+                } else {
+                    tracker.enter(std::move(relDir));
                 }
                 continue;
             }
@@ -306,35 +830,93 @@ namespace {
             }
 
             auto relPath = it->path().lexically_relative(root).generic_string();
-            if (relPath == kManifestFileName) {
+            if (relPath == kManifestFileName || relPath == kJournalFileName) {
                 continue;
             }
 
-            uint64_t size = std::filesystem::file_size(it->path(), ec);
-            if (ec) {
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            FileIdentity identity;
+            Reason failure = Reason::None;
+            if (!statFile(it->path(), size, mtime, identity, ec, &failure)) {
                 ++errorCount;
                 ec.clear();
                 continue;
             }
-            auto mtimeFs = std::filesystem::last_write_time(it->path(), ec);
-            if (ec) {
-                ++errorCount;
-                ec.clear();
-                continue;
+            SIT_PROFILE_COUNT(Files, 1);
+            // Only multiply linked inodes are tracked; a single link cannot be met twice
+            bool linked = identity.links > 1 && identity.inode != 0;
+            FileRecord record{ relPath, size, mtime, std::string(), std::string(),
+                linked ? identity.device : 0, linked ? identity.inode : 0, 0 };
+
+            auto sameInode = linked ? hashedInodes.find(identity) : hashedInodes.end();
+            auto resumed = replay.files.find(relPath);
+            if (sameInode != hashedInodes.end()) {
+                record.hash = records[sameInode->second].hash;
+                record.fingerprint = records[sameInode->second].fingerprint;
+                // Journaled like a hashed file, or a resume past this directory would drop the link
+                journal.record(relPath, size, mtime, record.hash, record.fingerprint);
+                journal.checkpoint();
+            } else if (resumed != replay.files.end() && resumed->second.size == size && resumed->second.mtime == mtime) {
+                resumed->second.consumed = true;
+                record.hash = resumed->second.hash;
+                record.fingerprint = resumed->second.fingerprint;
+            } else {
+                std::string hashError;
+                record.hash = hashFileSha256(it->path(), &hashError, &limiter, &record.fingerprint, size,
+                    detail::fileSeed(relPath, size));
+                if (record.hash.empty()) {
+                    ++errorCount;
+                    continue;
+                }
+                journal.record(relPath, size, mtime, record.hash, record.fingerprint);
+                journal.checkpoint();
             }
-            int64_t mtime = toUnixSeconds(mtimeFs);
-            std::string hashError;
-            std::string hash = hashFileSha256(it->path(), &hashError);
-            if (hash.empty()) {
-                ++errorCount;
+            if (linked) {
+                hashedInodes.emplace(identity, records.size());
+            }
+            records.push_back(std::move(record));
+        }
+        // Files below completed directories were not walked again; take them from the journal
+        for (const auto& resumed : replay.files) {
+            if (resumed.second.consumed || !replay.underSkipped(resumed.first)) {
                 continue;
             }
-            records.push_back({ relPath, size, mtime, hash });
+            FileRecord record{ resumed.first, resumed.second.size, resumed.second.mtime, resumed.second.hash,
+                resumed.second.fingerprint, 0, 0, 0 };
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            FileIdentity identity;
+            Reason failure = Reason::None;
+            if (statFile(root / resumed.first, size, mtime, identity, ec, &failure) && identity.links > 1) {
+                record.device = identity.device;
+                record.inode = identity.inode;
+            }
+            ec.clear();
+            records.push_back(std::move(record));
         }
 
         std::sort(records.begin(), records.end(),
             [](const FileRecord& a, const FileRecord& b) { return a.relPath < b.relPath; });
 
+        // Paths that still share an inode form a link group, numbered in path order
+        std::unordered_map<FileIdentity, size_t, FileIdentityHash> linkCounts;
+        for (const auto& record : records) {
+            if (record.inode != 0) {
+                ++linkCounts[{ record.device, record.inode, 0 }];
+            }
+        }
+        std::unordered_map<FileIdentity, uint64_t, FileIdentityHash> linkGroups;
+        for (auto& record : records) {
+            FileIdentity identity{ record.device, record.inode, 0 };
+            if (record.inode == 0 || linkCounts[identity] < 2) {
+                continue;
+            }
+            auto group = linkGroups.emplace(identity, linkGroups.size() + 1).first;
+            record.linkGroup = group->second;
+        }
+
+        SIT_PROFILE_SCOPE(ManifestWrite);
         std::ofstream out(manifestPath, std::ios::binary | std::ios::trunc);
         if (!out) {
             if (error) {
@@ -344,8 +926,24 @@ namespace {
         }
         out << kManifestHeader << "\n";
         for (const auto& record : records) {
-            out << record.relPath << "\t" << record.size << "\t" << record.mtime << "\t" << record.hash << "\n";
+            out << record.relPath << "\t" << record.size << "\t" << record.mtime << "\t" << record.hash;
+            if (!record.fingerprint.empty()) {
+                out << "\tfp=" << record.fingerprint;
+            }
+            if (record.linkGroup != 0) {
+                out << "\tlink=" << record.linkGroup;
+            }
+            out << "\n";
+        }
+
+        out.close();
+        if (!out) {
+            if (error) {
+                *error = "Error while writing integrity manifest.";
+            }
+            return false;
         }
+        journal.discard();
 
         if (errorCount > 0 && error) {
             *error = "Manifest created with " + std::to_string(errorCount) + " unreadable files skipped.";
@@ -354,118 +952,640 @@ namespace {
         return true;
     }
 
-    void addIssue(CheckResult& result, const std::string& path, const std::string& status, const std::string& detail) {
-        result.issues.push_back({ path, status, detail });
+    Issue& addIssue(CheckResult& result, const std::string& path, Status status, Reason reason) {
+        Issue issue;
+        issue.path = result.paths.add(path);
+        issue.status = status;
+        issue.reason = reason;
+        result.issues.push_back(issue);
+        return result.issues.back();
     }
-} // namespace
 
-    bool createManifest(const std::filesystem::path& root, std::string* error) {
-        return writeManifest(root, false, error);
+    // Counts one file's outcome; everything but OK is also listed as an issue
+    void addOutcome(CheckResult& result, const std::string& path, Status status, Reason reason) {
+        if (status == Status::Ok) {
+            ++result.ok;
+            return;
+        }
+        if (status == Status::Changed) {
+            ++result.changed;
+        } else if (status == Status::New) {
+            ++result.added;
+        } else {
+            ++result.errors;
+        }
+        addIssue(result, path, status, reason);
     }
 
-    bool updateManifest(const std::filesystem::path& root, std::string* error) {
-        return writeManifest(root, true, error);
-    }
+    // A file whose content has to be read before its outcome is known
+    struct Read {
+        std::string relPath;
+        std::filesystem::path path;
+        ManifestEntry* entry = nullptr;
+        uint64_t size = 0;
+        uint64_t readBytes = 0;     // The whole file, or its sampled blocks
+        uint64_t device = 0;
+        bool sample = false;
+        FileIdentity identity;      // Only set for multiply linked inodes, which are read once
+        std::vector<std::pair<std::string, ManifestEntry*>> links;     // Other paths to that inode
+    };
 
-    bool checkManifest(const std::filesystem::path& root, CheckResult& result, std::string* error) {
-        std::error_code ec;
-        if (!std::filesystem::exists(root, ec) || !std::filesystem::is_directory(root, ec)) {
-            if (error) {
-                *error = "Root path is not a directory.";
+    // One root's check. The walk settles every file it can from metadata and hands the
+    // ones that need reading to a dispatch function; complete() settles those. A single
+    // root completes each read inline, several roots on a shared pool, so outcomes, the
+    // journal and the inode table are guarded by one mutex.
+    class RootCheck {
+    public:
+        RootCheck(const std::filesystem::path& root, const Options& options, CheckResult& result,
+            IoBudget::Limiter* shared)
+            : root(root), options(options), result(result),
+              limiter(shared ? IoBudget::Limits() : options.io, shared) {
+        }
+
+        bool open(std::string* error) {
+            std::error_code ec;
+            if (!std::filesystem::exists(root, ec) || !std::filesystem::is_directory(root, ec)) {
+                if (error) {
+                    *error = "Root path is not a directory.";
+                }
+                return false;
             }
-            return false;
+
+            std::filesystem::path manifestPath = root / kManifestFileName;
+            if (!loadManifest(manifestPath, manifest, error)) {
+                return false;
+            }
+            result = CheckResult{};
+            result.total = static_cast<int>(manifest.size());
+            for (const auto& entryPair : manifest) {
+                trackedBytes += entryPair.second.size;
+            }
+
+            // The journal is tied to this exact manifest so a resume never mixes two baselines
+            uint64_t manifestSize = std::filesystem::file_size(manifestPath, ec);
+            int64_t manifestTime = toUnixSeconds(std::filesystem::last_write_time(manifestPath, ec));
+            ec.clear();
+            if (!journal.open(root, "check " + std::to_string(manifestSize) + " " + std::to_string(manifestTime)
+                    + " " + tierName(options.tier), options.resume, replay, error)) {
+                return false;
+            }
+
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            FileIdentity identity;
+            Reason failure = Reason::None;
+            if (statFile(root, size, mtime, identity, ec, &failure)) {
+                rootDevice = identity.device;
+            }
+            return true;
         }
 
-        std::filesystem::path manifestPath = root / kManifestFileName;
-        std::unordered_map<std::string, ManifestEntry> manifest;
-        if (!loadManifest(manifestPath, manifest, error)) {
-            return false;
+        uint64_t bytes() const { return trackedBytes; }
+        uint64_t device() const { return rootDevice; }
+        uint64_t settled() const { return settledFiles.load(std::memory_order_relaxed); }
+        Clock::time_point lastOutcome() const { return lastOutcomeTime; }
+
+        // Completed directories are only journaled when every read below them has
+        // finished by the time the walk leaves them, which holds for inline reads
+        template <typename Dispatch>
+        void walk(bool recordDirectories, Dispatch&& dispatch) {
+            std::error_code ec;
+            DirectoryTracker tracker;
+            auto finished = [&](const std::string& relDir) {
+                if (recordDirectories) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    journal.directoryDone(relDir);
+                }
+            };
+
+            std::filesystem::recursive_directory_iterator it(
+                root,
+                std::filesystem::directory_options::skip_permission_denied,
+                ec);
+            std::filesystem::recursive_directory_iterator end;
+            for (; it != end; advance(it, ec)) {
+                if (ec) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++result.errors;
+                    addIssue(result, std::string(), Status::Error, Reason::ScanError).code = ec.value();
+                    ec.clear();
+                    continue;
+                }
+
+                tracker.visit(it.depth(), finished);
+                if (it->is_directory(ec)) {
+                    std::string relDir = it->path().lexically_relative(root).generic_string();
+                    if (isExcludedDir(it->path())) {
+                        it.disable_recursion_pending();
+                    } else if (replay.completedDirs.count(relDir)) {
+                        it.disable_recursion_pending();
+                        replay.skippedDirs.insert(relDir);
+                    } else {
+                        tracker.enter(std::move(relDir));
+                    }
+                    continue;
+                }
+                if (!it->is_regular_file(ec)) {
+                    continue;
+                }
+
+                auto relPath = it->path().lexically_relative(root).generic_string();
+                if (relPath == kManifestFileName || relPath == kJournalFileName) {
+                    continue;
+                }
+
+                auto resumed = replay.files.find(relPath);
+                if (resumed != replay.files.end()) {
+                    replayed(relPath, resumed->second);
+                    continue;
+                }
+
+                auto found = manifest.find(relPath);
+                if (found == manifest.end()) {
+                    settle(relPath, Status::New, Reason::NotInManifest);
+                    continue;
+                }
+
+                ManifestEntry& entry = found->second;
+                entry.seen = true;
+
+                uint64_t size = 0;
+                int64_t mtime = 0;
+                FileIdentity identity;
+                Reason failure = Reason::None;
+                if (!statFile(it->path(), size, mtime, identity, ec, &failure)) {
+                    settle(relPath, Status::Error, failure);
+                    ec.clear();
+                    continue;
+                }
+                SIT_PROFILE_COUNT(Files, 1);
+
+                // A different size cannot hash the same, so there is nothing to read
+                if (size != entry.size) {
+                    settle(relPath, Status::Changed, Reason::SizeChanged);
+                    continue;
+                }
+                bool sameMetadata = mtime == entry.mtime;
+                if (sameMetadata && options.tier == Tier::Quick) {
+                    settle(relPath, Status::Ok, Reason::None);
+                    continue;
+                }
+
+                auto read = std::make_unique<Read>();
+                read->relPath = std::move(relPath);
+                read->path = it->path();
+                read->entry = &entry;
+                read->size = size;
+                read->readBytes = size;
+                read->device = identity.device;
+                if (sameMetadata && options.tier == Tier::Sample && isSampled(size)) {
+                    if (entry.fingerprint.empty()) {
+                        settle(read->relPath, Status::Ok, Reason::None);      // Manifest written before fingerprints
+                        continue;
+                    }
+                    read->sample = true;
+                    read->readBytes = std::min(size, (sampledBlockCount(blockCount(size)) + 2) * detail::kSampleBlockSize);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++result.sampled;
+                } else if (identity.links > 1 && identity.inode != 0) {
+                    // Another path to an inode that is already read (or being read) takes its hash
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto known = inodes.find(identity);
+                    if (known != inodes.end()) {
+                        if (known->second.pending) {
+                            known->second.pending->links.emplace_back(std::move(read->relPath), &entry);
+                        } else {
+                            ++result.sharedHashes;
+                            record(read->relPath, known->second.hash == entry.hash ? Status::Ok : Status::Changed,
+                                known->second.hash == entry.hash ? Reason::None : Reason::HashMismatch);
+                        }
+                        continue;
+                    }
+                    read->identity = identity;
+                    inodes[identity].pending = read.get();
+                }
+                dispatch(std::move(read));
+            }
         }
 
-        result = CheckResult{};
-        result.total = static_cast<int>(manifest.size());
+        // Reads the file and settles it, along with any other paths to the same inode
+        void complete(Read& read) {
+            if (read.sample) {
+                std::string sampleError;
+                std::string fingerprint = detail::sampleFingerprint(read.path, read.size, read.entry->sampleSeed,
+                    &sampleError, &limiter);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (fingerprint.empty()) {
+                    record(read.relPath, Status::Error, reasonFromText(sampleError, Reason::SampleFailed));
+                } else if (fingerprint == read.entry->fingerprint) {
+                    record(read.relPath, Status::Ok, Reason::None);
+                } else {
+                    record(read.relPath, Status::Changed, Reason::SampledMismatch);
+                }
+                return;
+            }
 
-        std::filesystem::recursive_directory_iterator it(
-            root,
-            std::filesystem::directory_options::skip_permission_denied,
-            ec);
-        std::filesystem::recursive_directory_iterator end;
-        for (; it != end; it.increment(ec)) {
-            if (ec) {
-                ++result.errors;
-                addIssue(result, "", "ERROR", "Directory scan error: " + ec.message());
-                ec.clear();
-                continue;
+            std::string hashError;
+            std::string hash = hashFileSha256(read.path, &hashError, &limiter);
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<std::pair<std::string, ManifestEntry*>> links;
+            if (read.identity.inode != 0) {
+                links.swap(read.links);
+                auto known = inodes.find(read.identity);
+                if (hash.empty()) {
+                    inodes.erase(known);        // A later path to it tries again
+                } else {
+                    known->second.hash = hash;
+                    known->second.pending = nullptr;
+                }
+            }
+            if (hash.empty()) {
+                Reason reason = reasonFromText(hashError, Reason::HashFailed);
+                record(read.relPath, Status::Error, reason);
+                for (const auto& link : links) {
+                    record(link.first, Status::Error, reason);
+                }
+                return;
+            }
+            bool same = hash == read.entry->hash;
+            record(read.relPath, same ? Status::Ok : Status::Changed, same ? Reason::None : Reason::HashMismatch);
+            for (const auto& link : links) {
+                ++result.sharedHashes;
+                same = hash == link.second->hash;
+                record(link.first, same ? Status::Ok : Status::Changed, same ? Reason::None : Reason::HashMismatch);
             }
+        }
 
-            if (it->is_directory(ec)) {
-                if (isExcludedDir(it->path())) {
-                    it.disable_recursion_pending();
+        // Called once every read has completed
+        void finish() {
+            std::error_code ec;
+            for (auto& resumed : replay.files) {
+                if (!resumed.second.consumed && replay.underSkipped(resumed.first)) {
+                    replayed(resumed.first, resumed.second);
                 }
-                continue;
             }
-            if (!it->is_regular_file(ec)) {
-                continue;
+
+            for (const auto& entryPair : manifest) {
+                if (!entryPair.second.seen) {
+                    ++result.missing;
+                    addIssue(result, entryPair.first, Status::Missing, Reason::FileNotFound);
+                }
             }
 
-            auto relPath = it->path().lexically_relative(root).generic_string();
-            if (relPath == kManifestFileName) {
-                continue;
+            // Paths recorded as hard links to one inode must still share one
+            std::vector<std::pair<std::string, uint64_t>> linkedPaths;
+            for (const auto& entryPair : manifest) {
+                if (entryPair.second.seen && entryPair.second.linkGroup != 0) {
+                    linkedPaths.emplace_back(entryPair.first, entryPair.second.linkGroup);
+                }
+            }
+            std::sort(linkedPaths.begin(), linkedPaths.end());
+            std::unordered_map<uint64_t, std::pair<std::string, FileIdentity>> groupInodes;
+            for (const auto& linkedPath : linkedPaths) {
+                uint64_t size = 0;
+                int64_t mtime = 0;
+                FileIdentity identity;
+                Reason failure = Reason::None;
+                if (!statFile(root / linkedPath.first, size, mtime, identity, ec, &failure) || identity.inode == 0) {
+                    ec.clear();
+                    continue;
+                }
+                auto first = groupInodes.emplace(linkedPath.second, std::make_pair(linkedPath.first, identity)).first;
+                if (!(first->second.second == identity)) {
+                    ++result.unlinked;
+                    Issue& issue = addIssue(result, linkedPath.first, Status::Unlinked, Reason::NoLongerLinked);
+                    issue.other = result.paths.add(first->second.first);
+                }
             }
+            result.io = limiter.stats();
+            journal.discard();
+        }
+
+    private:
+        struct InodeState {
+            std::string hash;
+            Read* pending = nullptr;    // The read in flight for this inode, if any
+        };
+
+        std::filesystem::path root;
+        const Options& options;
+        CheckResult& result;
+        IoBudget::Limiter limiter;
+        std::unordered_map<std::string, ManifestEntry> manifest;
+        uint64_t trackedBytes = 0;
+        uint64_t rootDevice = 0;
+        JournalReplay replay;
+        Journal journal;
+
+        std::mutex mutex;
+        std::unordered_map<FileIdentity, InodeState, FileIdentityHash> inodes;
+        std::atomic<uint64_t> settledFiles{0};
+        Clock::time_point lastOutcomeTime = Clock::now();
+
+        // Caller holds the mutex
+        void record(const std::string& relPath, Status status, Reason reason) {
+            addOutcome(result, relPath, status, reason);
+            journal.result(relPath, status, reason);
+            journal.checkpoint();
+            settledFiles.fetch_add(1, std::memory_order_relaxed);
+            lastOutcomeTime = Clock::now();
+        }
 
+        void settle(const std::string& relPath, Status status, Reason reason) {
+            std::lock_guard<std::mutex> lock(mutex);
+            record(relPath, status, reason);
+        }
+
+        void replayed(const std::string& relPath, JournalEntry& entry) {
+            entry.consumed = true;
             auto found = manifest.find(relPath);
-            if (found == manifest.end()) {
-                ++result.added;
-                addIssue(result, relPath, "NEW", "Not in manifest");
-                continue;
+            if (found != manifest.end()) {
+                found->second.seen = true;
             }
+            std::lock_guard<std::mutex> lock(mutex);
+            ++result.resumed;
+            addOutcome(result, relPath, entry.status, entry.reason);
+            settledFiles.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
 
-            ManifestEntry& entry = found->second;
-            entry.seen = true;
+    // Reads of every root waiting for a worker. A worker takes the next read of the root
+    // with the most bytes outstanding (queued or being read) among those whose next read
+    // is on a device below its limit. Device 0 means unknown and is not limited.
+    class ReadQueue {
+    public:
+        ReadQueue(size_t roots, size_t readsPerDevice)
+            : queues(roots), readsPerDevice(std::max<size_t>(1, readsPerDevice)) {
+        }
 
-            uint64_t size = std::filesystem::file_size(it->path(), ec);
-            if (ec) {
-                ++result.errors;
-                addIssue(result, relPath, "ERROR", "Unable to read file size");
-                ec.clear();
-                continue;
+        // Blocks while the root already has kMaxQueuedReads waiting, so a fast walk
+        // cannot hold a whole tree's worth of paths in memory
+        void push(size_t root, std::unique_ptr<Read> read) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return queues[root].reads.size() < kMaxQueuedReads; });
+            queues[root].outstanding += read->readBytes;
+            outstandingBytes += read->readBytes;
+            queues[root].reads.push_back(std::move(read));
+            changed.notify_all();
+        }
+
+        // Waits for the next read; false once closed and drained
+        bool pop(size_t& root, std::unique_ptr<Read>& read) {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                size_t best = queues.size();
+                bool queued = false;
+                for (size_t i = 0; i < queues.size(); ++i) {
+                    if (queues[i].reads.empty()) {
+                        continue;
+                    }
+                    queued = true;
+                    uint64_t device = queues[i].reads.front()->device;
+                    if (device != 0 && active[device] >= readsPerDevice) {
+                        continue;
+                    }
+                    if (best == queues.size() || queues[i].outstanding > queues[best].outstanding) {
+                        best = i;
+                    }
+                }
+                if (best < queues.size()) {
+                    root = best;
+                    read = std::move(queues[best].reads.front());
+                    queues[best].reads.pop_front();
+                    ++active[read->device];
+                    changed.notify_all();
+                    return true;
+                }
+                if (closed && !queued) {
+                    return false;
+                }
+                changed.wait(lock);
             }
-            auto mtimeFs = std::filesystem::last_write_time(it->path(), ec);
-            if (ec) {
-                ++result.errors;
-                addIssue(result, relPath, "ERROR", "Unable to read last write time");
-                ec.clear();
-                continue;
+        }
+
+        void done(size_t root, const Read& read) {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active[read.device];
+            queues[root].outstanding -= read.readBytes;
+            outstandingBytes -= read.readBytes;
+            changed.notify_all();
+        }
+
+        // No more pushes; workers exit once the queues are empty
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            changed.notify_all();
+        }
+
+        uint64_t outstanding() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return outstandingBytes;
+        }
+
+    private:
+        static constexpr size_t kMaxQueuedReads = 1024;
+
+        struct RootQueue {
+            std::deque<std::unique_ptr<Read>> reads;
+            uint64_t outstanding = 0;
+        };
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<RootQueue> queues;
+        std::unordered_map<uint64_t, size_t> active;    // Reads in progress per device
+        size_t readsPerDevice;
+        uint64_t outstandingBytes = 0;
+        bool closed = false;
+    };
+} // namespace
+
+    const char* statusName(Status status) {
+        return kStatusNames[static_cast<int>(status)];
+    }
+
+    const char* reasonText(Reason reason) {
+        return reason < Reason::Count ? kReasonTexts[static_cast<int>(reason)] : "";
+    }
+
+    PathPool::Id PathPool::add(std::string_view path) {
+        Id id = data.size();
+        data.append(path.data(), path.size());
+        data.push_back('\0');
+        return id;
+    }
+
+    std::string_view PathPool::get(Id id) const {
+        return id < data.size() ? std::string_view(data.c_str() + id) : std::string_view();
+    }
+
+    void writeDetail(std::ostream& out, const CheckResult& result, const Issue& issue) {
+        out << reasonText(issue.reason);
+        if (issue.reason == Reason::NoLongerLinked) {
+            out << " " << result.paths.get(issue.other);
+        } else if (issue.reason == Reason::ScanError) {
+            out << ": " << std::error_code(issue.code, std::system_category()).message();
+        }
+    }
+
+    bool createManifest(const std::filesystem::path& root, std::string* error, const Options& options) {
+        return writeManifest(root, false, error, options);
+    }
+
+    bool updateManifest(const std::filesystem::path& root, std::string* error, const Options& options) {
+        return writeManifest(root, true, error, options);
+    }
+
+    bool checkManifest(const std::filesystem::path& root, CheckResult& result, std::string* error,
+        const Options& options) {
+        RootCheck check(root, options, result, nullptr);
+        if (!check.open(error)) {
+            return false;
+        }
+        check.walk(true, [&check](std::unique_ptr<Read> read) { check.complete(*read); });
+        check.finish();
+        return true;
+    }
+
+    bool checkManifests(const std::vector<std::filesystem::path>& roots, std::vector<RootResult>& results,
+        CheckResult& total, std::string* error, const Options& options) {
+        auto began = Clock::now();
+        total = CheckResult{};
+        results.clear();
+        results.resize(roots.size());
+        if (roots.empty()) {
+            if (error) {
+                *error = "No roots to check.";
             }
-            int64_t mtime = toUnixSeconds(mtimeFs);
+            return false;
+        }
 
-            if (size == entry.size && mtime == entry.mtime) {
-                ++result.ok;
-                continue;
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        size_t threads = options.threads > 0 ? std::min(options.threads, cores * kMaxThreadsPerCore) : cores;
+        IoBudget::Limiter shared(options.io);
+        Async::Executor pool(threads);
+        std::vector<std::unique_ptr<RootCheck>> checks;
+        std::vector<std::future<void>> opened;
+        for (size_t i = 0; i < roots.size(); ++i) {
+            results[i].root = roots[i];
+            checks.push_back(std::make_unique<RootCheck>(roots[i], options, results[i].result, &shared));
+        }
+        for (size_t i = 0; i < roots.size(); ++i) {
+            opened.push_back(pool.submit([&results, &checks, i] {
+                results[i].ok = checks[i]->open(&results[i].error);
+            }));
+        }
+        for (auto& future : opened) {
+            future.get();
+        }
+
+        // Roots on one device are walked one after another, largest first, so their
+        // metadata reads do not compete; roots on different devices walk side by side
+        std::unordered_map<uint64_t, std::vector<size_t>> groups;
+        for (size_t i = 0; i < roots.size(); ++i) {
+            if (results[i].ok) {
+                uint64_t device = checks[i]->device();
+                groups[device != 0 ? device : ~static_cast<uint64_t>(i)].push_back(i);
             }
+        }
 
-            std::string hashError;
-            std::string hash = hashFileSha256(it->path(), &hashError);
-            if (hash.empty()) {
-                ++result.errors;
-                addIssue(result, relPath, "ERROR", hashError.empty() ? "Unable to hash file" : hashError);
-                continue;
+        size_t walkable = 0;
+        for (const auto& group : groups) {
+            walkable += group.second.size();
+        }
+        ReadQueue queue(roots.size(), options.readsPerDevice);
+        std::atomic<size_t> walked{0};
+        auto progress = [&] {
+            if (!options.progress) {
+                return;
             }
-            if (hash == entry.hash) {
-                ++result.ok;
-                continue;
+            Progress current;
+            current.roots = walkable;
+            current.rootsWalked = walked.load();
+            for (const auto& check : checks) {
+                current.files += check->settled();
             }
-            ++result.changed;
-            addIssue(result, relPath, "CHANGED", "Hash mismatch");
+            current.bytesRead = shared.stats().bytesRead;
+            current.bytesQueued = queue.outstanding();
+            options.progress(current);
+        };
+        auto await = [&](std::future<void>& future) {
+            while (future.wait_for(std::chrono::seconds(1)) != std::future_status::ready) {
+                progress();
+            }
+        };
+
+        std::vector<std::future<void>> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.push_back(pool.submit([&queue, &checks] {
+                size_t root = 0;
+                std::unique_ptr<Read> read;
+                while (queue.pop(root, read)) {
+                    checks[root]->complete(*read);
+                    queue.done(root, *read);
+                    read.reset();
+                }
+            }));
+        }
+        std::vector<std::future<void>> walks;
+        if (!groups.empty()) {
+            Async::Executor walkers(std::min(groups.size(), threads));
+            for (auto& group : groups) {
+                std::vector<size_t> members = group.second;
+                std::sort(members.begin(), members.end(),
+                    [&checks](size_t a, size_t b) { return checks[a]->bytes() > checks[b]->bytes(); });
+                walks.push_back(walkers.submit([&queue, &checks, &walked, members] {
+                    for (size_t i : members) {
+                        checks[i]->walk(false, [&queue, i](std::unique_ptr<Read> read) { queue.push(i, std::move(read)); });
+                        ++walked;
+                    }
+                }));
+            }
+            for (auto& walk : walks) {
+                await(walk);
+            }
+        }
+        queue.close();
+        for (auto& worker : workers) {
+            await(worker);
+        }
+        for (auto& future : walks) {
+            future.get();
         }
+        for (auto& future : workers) {
+            future.get();
+        }
+        progress();
 
-        for (const auto& entryPair : manifest) {
-            if (!entryPair.second.seen) {
-                ++result.missing;
-                addIssue(result, entryPair.first, "MISSING", "File not found");
+        size_t failed = 0;
+        for (size_t i = 0; i < roots.size(); ++i) {
+            if (!results[i].ok) {
+                ++failed;
+                continue;
             }
+            checks[i]->finish();
+            results[i].seconds = std::chrono::duration<double>(checks[i]->lastOutcome() - began).count();
+            const CheckResult& result = results[i].result;
+            total.total += result.total;
+            total.ok += result.ok;
+            total.changed += result.changed;
+            total.missing += result.missing;
+            total.added += result.added;
+            total.errors += result.errors;
+            total.unlinked += result.unlinked;
+            total.resumed += result.resumed;
+            total.sharedHashes += result.sharedHashes;
+            total.sampled += result.sampled;
         }
+        total.io = shared.stats();
 
+        if (failed > 0) {
+            if (error) {
+                *error = std::to_string(failed) + " of " + std::to_string(roots.size()) + " roots could not be checked.";
+            }
+            return false;
+        }
         return true;
     }
 }
@@ -1,17 +1,77 @@
 #pragma once
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "ioBudget.h"
 
 // Integrity namespace encapsulating manifest integrity functions
 namespace Integrity {
     inline constexpr const char kManifestFileName[] = ".sit_integrity.manifest";
+    inline constexpr const char kJournalFileName[] = ".sit_integrity.journal";
+
+    // Outcome of one path in a check
+    enum class Status : uint8_t {
+        Ok,
+        Changed,
+        New,
+        Missing,
+        Error,
+        Unlinked
+    };
+
+    // Why a path got its status; each reason has one fixed message
+    enum class Reason : uint8_t {
+        None,
+        NotInManifest,
+        SizeChanged,
+        SampledMismatch,
+        HashMismatch,
+        FileNotFound,
+        NoLongerLinked,     // Message continues with Issue::other
+        UnreadableSize,
+        UnreadableTime,
+        OpenFailed,
+        ReadFailed,
+        SampleFailed,
+        HashFailed,
+        ScanError,          // Message continues with the system message for Issue::code
+        Count
+    };
+
+    // "CHANGED", "MISSING", ...
+    const char* statusName(Status status);
+
+    // "Hash mismatch", "File not found", ...
+    const char* reasonText(Reason reason);
+
+    // Issue paths, stored back to back in one growing buffer rather than one string
+    // per issue, so a report with millions of issues costs a few large allocations
+    class PathPool {
+    public:
+        using Id = uint64_t;
+        static constexpr Id kNone = ~Id(0);
+
+        Id add(std::string_view path);
+        std::string_view get(Id id) const;
+
+        size_t bytes() const { return data.size(); }
+        void clear() { data.clear(); }
+
+    private:
+        std::string data;       // NUL-terminated paths
+    };
 
     // Structure to represent an issue found during integrity check
     struct Issue {
-        std::string path;
-        std::string status;
-        std::string detail;
+        PathPool::Id path = PathPool::kNone;
+        PathPool::Id other = PathPool::kNone;   // NoLongerLinked: the path it was linked to
+        Status status = Status::Error;
+        Reason reason = Reason::None;
+        int32_t code = 0;                       // ScanError: the system error code
     };
 
     // Structure to hold the results of an integrity check
@@ -22,11 +82,76 @@ namespace Integrity {
         int missing = 0;
         int added = 0;
         int errors = 0;
+        int unlinked = 0;           // Paths no longer hard-linked to the rest of their manifest link group
         std::vector<Issue> issues;
+        PathPool paths;             // Paths referenced by issues
+        int resumed = 0;            // Outcomes taken from the journal instead of re-checked
+        int sharedHashes = 0;       // Hashes reused from another hard link to the same inode
+        int sampled = 0;            // Files verified by sampled fingerprint rather than a full hash
+        IoBudget::Stats io;
+
+        std::string_view path(const Issue& issue) const { return paths.get(issue.path); }
+    };
+
+    // Writes the detail of an issue, e.g. "Hash mismatch" or "No longer a hard link to a/b"
+    void writeDetail(std::ostream& out, const CheckResult& result, const Issue& issue);
+
+    // How much content check reads for files whose size and mtime match the manifest
+    enum class Tier {
+        Quick,      // None; metadata only
+        Sample,     // First, last and about 1% of the other 4 KiB blocks, compared to the stored fingerprint
+        Full        // Everything, compared to the full SHA-256
+    };
+
+    // Running totals of a multi-root check
+    struct Progress {
+        size_t roots = 0;           // Roots whose manifest loaded
+        size_t rootsWalked = 0;     // Roots whose tree walk has finished
+        uint64_t files = 0;         // Files with an outcome so far
+        uint64_t bytesRead = 0;
+        uint64_t bytesQueued = 0;   // Waiting to be read or being read
+    };
+
+    struct Options {
+        // Limits applied to the file reads done while hashing; with several roots they
+        // are one budget for the whole run
+        IoBudget::Limits io;
+
+        // Continue an interrupted run from the last checkpoint in the journal
+        bool resume = false;
+
+        Tier tier = Tier::Quick;
+
+        // Multi-root checks only
+        size_t threads = 0;             // Hashing workers shared by all roots; 0 uses the hardware concurrency, at most 4 per core
+        size_t readsPerDevice = 2;      // Concurrent file reads per block device
+        std::function<void(const Progress&)> progress;     // Called about once a second
+    };
+
+    // One root of a multi-root check
+    struct RootResult {
+        std::filesystem::path root;
+        bool ok = false;
+        std::string error;          // Why the root could not be checked (ok == false)
+        CheckResult result;
+        double seconds = 0.0;       // From the start of the run until the root's last outcome
     };
 
     // Function declarations for manifest operations
-    bool createManifest(const std::filesystem::path& root, std::string* error);
-    bool updateManifest(const std::filesystem::path& root, std::string* error);
-    bool checkManifest(const std::filesystem::path& root, CheckResult& result, std::string* error);
+    bool createManifest(const std::filesystem::path& root, std::string* error, const Options& options = Options());
+    bool updateManifest(const std::filesystem::path& root, std::string* error, const Options& options = Options());
+    bool checkManifest(const std::filesystem::path& root, CheckResult& result, std::string* error,
+        const Options& options = Options());
+
+    // Checks several roots at once. Each root is walked by one walker per block device,
+    // largest manifest first, and the files that need reading go to one pool of workers
+    // shared by all roots. Workers serve the root with the most bytes outstanding,
+    // within Options::readsPerDevice reads per device, so one huge root is spread over
+    // every worker instead of finishing alone. Every root keeps its own manifest and
+    // journal; with several roots the journal records file outcomes only, so a resume
+    // walks the tree again but reads nothing it already recorded.
+    // total receives the summed counts and I/O stats; issues stay in the per-root results.
+    // Returns false if any root could not be checked.
+    bool checkManifests(const std::vector<std::filesystem::path>& roots, std::vector<RootResult>& results,
+        CheckResult& total, std::string* error, const Options& options = Options());
 }
@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ioBudget.h"
+
+// Integrity internals shared with the benchmark suite. Not part of the
+// command-line tool's interface; use integrity.h for manifest operations.
+namespace Integrity {
+namespace detail {
+    // Version 2 lines may carry tab-separated key=value fields after the hash. Version 3
+    // seeds the sampled fingerprint from the file size instead of the full hash, and
+    // version 4 from the path and size (see fileSeed).
+    inline constexpr const char kManifestHeader[] = "# SIT-INTEGRITY-4 SHA256";
+    inline constexpr const char kManifestHeaderV3[] = "# SIT-INTEGRITY-3 SHA256";
+    inline constexpr const char kManifestHeaderV2[] = "# SIT-INTEGRITY-2 SHA256";
+    inline constexpr const char kManifestHeaderV1[] = "# SIT-INTEGRITY-1 SHA256";
+
+    struct ManifestEntry {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::string hash;
+        std::string fingerprint;    // Sampled fingerprint, empty for files small enough to hash whole
+        uint64_t sampleSeed = 0;    // Seed the fingerprint's blocks were chosen with (see sampleBlocks)
+        uint64_t linkGroup = 0;     // Paths sharing a nonzero group were hard links to one inode
+        bool seen = false;
+    };
+
+    class Sha256 {
+    public:
+        Sha256();
+
+        void update(const uint8_t* data, size_t length);
+
+        // Hex digest of everything added so far; resets the hasher for reuse
+        std::string finalHex();
+
+    private:
+        std::array<uint8_t, 64> buffer{};
+        size_t bufferLen = 0;
+        uint64_t bitLen = 0;
+        std::array<uint32_t, 8> state{};
+
+        void reset();
+        void transform(const uint8_t* chunk);
+    };
+
+    // Hashes a file, charging every read to the limiter when one is given. With fingerprint,
+    // also computes the sampled fingerprint of a size byte file from the same reads, with the
+    // blocks chosen by seed; it is left empty for files too small to sample.
+    std::string hashFileSha256(const std::filesystem::path& path, std::string* error,
+        IoBudget::Limiter* limiter = nullptr, std::string* fingerprint = nullptr, uint64_t size = 0,
+        uint64_t seed = 0);
+
+    inline constexpr uint64_t kSampleBlockSize = 4096;
+
+    // Fingerprint seed of the file at relPath (relative to the manifest root), so files of
+    // the same size are sampled at different offsets. Known before the file is read.
+    uint64_t fileSeed(const std::string& relPath, uint64_t size);
+
+    // Blocks read for a sampled fingerprint, ascending: the first and last block plus about 1%
+    // of the rest, chosen pseudo-randomly from seed. Current manifests seed with fileSeed;
+    // version 3 seeded with the size and version 2 with the full hash.
+    // Empty when that would cover the whole file anyway.
+    std::vector<uint64_t> sampleBlocks(uint64_t size, uint64_t seed);
+
+    // Truncated SHA-256 over the sampled blocks, or empty (and error set) if they could not be read
+    std::string sampleFingerprint(const std::filesystem::path& path, uint64_t size, uint64_t seed,
+        std::string* error, IoBudget::Limiter* limiter = nullptr);
+
+    // Extra key=value fields, if any, are left tab separated in extras
+    bool parseManifestLine(const std::string& line, std::string& path, uint64_t& size, int64_t& mtime, std::string& hash,
+        std::string* extras = nullptr);
+
+    bool loadManifest(const std::filesystem::path& manifestPath,
+        std::unordered_map<std::string, ManifestEntry>& entries,
+        std::string* error);
+}
+}
@@ -0,0 +1,192 @@
+// ioBudget.cpp I/O budget implementation
+#include "ioBudget.h"
+#include "pressure.h"
+
+#include <algorithm>
+#include <cctype>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/syscall.h>    // For SYS_ioprio_set
+#include <unistd.h>         // For syscall
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace IoBudget {
+namespace {
+    // Burst allowance as a share of one second of budget
+    constexpr double kBurstSeconds = 0.1;
+
+    // PSI averages update every two seconds; polling faster gains nothing
+    constexpr std::chrono::milliseconds kPressurePollInterval(500);
+
+    // Resume only once pressure has fallen well below the limit, so the scan
+    // does not restart right at the edge and push it back over
+    constexpr double kPressureResumeFactor = 0.5;
+
+#ifndef _WIN32
+    constexpr int kIoprioClassShift = 13;
+    constexpr int kIoprioClassBestEffort = 2;
+    constexpr int kIoprioClassIdle = 3;
+    constexpr int kIoprioWhoProcess = 1;
+#endif
+} // namespace
+
+    bool setIoPriority(IoClass ioClass, int level, std::string* error) {
+        if (ioClass == IoClass::Default) {
+            return true;
+        }
+#if !defined(_WIN32) && defined(SYS_ioprio_set)
+        int cls = ioClass == IoClass::Idle ? kIoprioClassIdle : kIoprioClassBestEffort;
+        int data = ioClass == IoClass::Idle ? 0 : std::clamp(level, 0, 7);
+        if (syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, (cls << kIoprioClassShift) | data) != 0) {
+            if (error) {
+                *error = std::string("Unable to set I/O priority: ") + std::strerror(errno);
+            }
+            return false;
+        }
+        return true;
+#else
+        (void)level;
+        if (error) {
+            *error = "I/O priority classes are not supported on this platform.";
+        }
+        return false;
+#endif
+    }
+
+    uint64_t parseRate(const std::string& text) {
+        if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+            return 0;
+        }
+        size_t used = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(text, &used);
+        } catch (...) {
+            return 0;
+        }
+        std::string suffix = text.substr(used);
+        if (!suffix.empty() && (suffix.back() == 'B' || suffix.back() == 'b')) {
+            suffix.pop_back();
+        }
+        double scale = 1.0;
+        if (suffix == "K" || suffix == "k") {
+            scale = 1024.0;
+        } else if (suffix == "M" || suffix == "m") {
+            scale = 1024.0 * 1024.0;
+        } else if (suffix == "G" || suffix == "g") {
+            scale = 1024.0 * 1024.0 * 1024.0;
+        } else if (!suffix.empty()) {
+            return 0;
+        }
+        return static_cast<uint64_t>(value * scale);
+    }
+
+    TokenBucket::TokenBucket(double rate, double burst)
+        : rate(rate), burst(burst), tokens(burst), last(Clock::now()) {
+    }
+
+    Clock::duration TokenBucket::take(double amount) {
+        if (rate <= 0.0) {
+            return Clock::duration::zero();
+        }
+        auto now = Clock::now();
+        tokens = std::min(burst, tokens + std::chrono::duration<double>(now - last).count() * rate);
+        last = now;
+        tokens -= amount;
+        if (tokens >= 0.0) {
+            return Clock::duration::zero();
+        }
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-tokens / rate));
+    }
+
+    void TokenBucket::refund(double amount) {
+        tokens = std::min(burst, tokens + amount);
+    }
+
+    Limiter::Limiter(const Limits& limits, Limiter* parent)
+        : limits(limits),
+          limited(limits.maxReadBytesPerSec > 0 || limits.maxReadOpsPerSec > 0 || limits.pressureLimit > 0.0),
+          parent(parent),
+          bytes(static_cast<double>(limits.maxReadBytesPerSec), limits.maxReadBytesPerSec * kBurstSeconds),
+          ops(static_cast<double>(limits.maxReadOpsPerSec), std::max(1.0, limits.maxReadOpsPerSec * kBurstSeconds)),
+          nextPressureCheck(Clock::now()) {
+    }
+
+    void Limiter::acquire(size_t size) {
+        charge(size);
+    }
+
+    Limiter::Waited Limiter::charge(size_t size) {
+        Waited waited;
+        if (limits.pressureLimit > 0.0) {
+            waited.pressureMs = waitForPressure();
+        }
+        // Both buckets are charged; the longer debt decides the wait. Sleeping outside
+        // the lock lets concurrent readers queue up behind the same debt.
+        Clock::duration wait = Clock::duration::zero();
+        if (limited) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wait = std::max(bytes.take(static_cast<double>(size)), ops.take(1.0));
+        }
+        if (wait > Clock::duration::zero()) {
+            waited.rateMs = std::chrono::duration<double, std::milli>(wait).count();
+            std::this_thread::sleep_for(wait);
+        }
+        if (parent) {
+            Waited inherited = parent->charge(size);
+            waited.rateMs += inherited.rateMs;
+            waited.pressureMs += inherited.pressureMs;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++totals.reads;
+        totals.bytesRead += size;
+        totals.rateWaitMs += waited.rateMs;
+        totals.pressureWaitMs += waited.pressureMs;
+        return waited;
+    }
+
+    void Limiter::release(size_t unusedBytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            totals.bytesRead -= std::min<uint64_t>(unusedBytes, totals.bytesRead);
+            bytes.refund(static_cast<double>(unusedBytes));
+        }
+        if (parent) {
+            parent->release(unusedBytes);
+        }
+    }
+
+    Stats Limiter::stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totals;
+    }
+
+    // Returns the milliseconds this reader was held back
+    double Limiter::waitForPressure() {
+        auto began = Clock::now();
+        uint64_t pausesBefore = pauses.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> pause(pressureMutex);
+        if (Clock::now() < nextPressureCheck) {
+            // Only time spent behind another reader's pause counts, not a short wait for the lock
+            return pauses.load(std::memory_order_relaxed) != pausesBefore
+                ? std::chrono::duration<double, std::milli>(Clock::now() - began).count()
+                : 0.0;
+        }
+        Pressure::Stall io = Pressure::read("io");
+        nextPressureCheck = Clock::now() + kPressurePollInterval;
+        if (!io.available || io.someAvg10 <= limits.pressureLimit) {
+            return 0.0;
+        }
+        while (io.available && io.someAvg10 > limits.pressureLimit * kPressureResumeFactor) {
+            std::this_thread::sleep_for(kPressurePollInterval);
+            io = Pressure::read("io");
+        }
+        pauses.fetch_add(1, std::memory_order_relaxed);
+        nextPressureCheck = Clock::now() + kPressurePollInterval;
+        return std::chrono::duration<double, std::milli>(Clock::now() - began).count();
+    }
+}
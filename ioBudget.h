@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// IoBudget namespace encapsulating the limits that keep background scans from
+// competing with production I/O: token-bucket rate limits, the kernel I/O
+// priority class and back-off on I/O pressure
+namespace IoBudget {
+    using Clock = std::chrono::steady_clock;
+
+    enum class IoClass {
+        Default,        // Leave the process priority alone
+        BestEffort,
+        Idle            // Only served when no other process wants the disk
+    };
+
+    // Sets the I/O scheduling class of the calling process. Level 0-7 applies to best effort only.
+    bool setIoPriority(IoClass ioClass, int level, std::string* error);
+
+    // Parses a byte rate such as "50M", "512K" or "1G" (binary units); returns 0 if invalid
+    uint64_t parseRate(const std::string& text);
+
+    // Tokens refill continuously at rate per second up to burst. Taking more
+    // than is available puts the bucket in debt and returns how long the
+    // caller must wait for it to be repaid.
+    class TokenBucket {
+    public:
+        TokenBucket(double rate, double burst);
+
+        Clock::duration take(double tokens);
+
+        // Returns tokens that were taken but not used
+        void refund(double tokens);
+
+    private:
+        double rate;
+        double burst;
+        double tokens;
+        Clock::time_point last;
+    };
+
+    struct Limits {
+        uint64_t maxReadBytesPerSec = 0;    // 0 = unlimited
+        uint64_t maxReadOpsPerSec = 0;      // Read calls per second, 0 = unlimited
+        double pressureLimit = 0.0;         // Pause while io "some" avg10 exceeds this percent, 0 = off
+    };
+
+    struct Stats {
+        uint64_t bytesRead = 0;
+        uint64_t reads = 0;
+        double rateWaitMs = 0.0;
+        double pressureWaitMs = 0.0;
+    };
+
+    // Applied before every read in a scan. Thread-safe, so the workers of a multi-root
+    // check can share one. A limiter with a parent also charges each read to the parent
+    // and counts the time spent waiting for it; per-root limiters then keep each root's
+    // stats while the parent holds one budget for the whole run.
+    class Limiter {
+    public:
+        explicit Limiter(const Limits& limits, Limiter* parent = nullptr);
+
+        Limiter(const Limiter&) = delete;
+        Limiter& operator=(const Limiter&) = delete;
+
+        bool active() const { return limited || (parent && parent->active()); }
+
+        // Blocks until a read of this many bytes fits the budget
+        void acquire(size_t bytes);
+
+        // Credits back the part of an acquired read that came back short
+        void release(size_t unusedBytes);
+
+        Stats stats() const;
+
+    private:
+        struct Waited {
+            double rateMs = 0.0;
+            double pressureMs = 0.0;
+        };
+
+        Limits limits;
+        bool limited;
+        Limiter* parent;
+        mutable std::mutex mutex;           // Buckets and totals
+        std::mutex pressureMutex;           // Held through a pause, so every reader waits it out
+        std::atomic<uint64_t> pauses{0};
+        TokenBucket bytes;
+        TokenBucket ops;
+        Clock::time_point nextPressureCheck;
+        Stats totals;
+
+        Waited charge(size_t size);
+        double waitForPressure();
+    };
+}
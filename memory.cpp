@@ -0,0 +1,300 @@
+// memory.cpp detailed memory collector implementation
+#include "memory.h"
+#include "procfs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <unistd.h>     // For sysconf
+#endif
+
+namespace Memory {
+namespace {
+    struct Key {
+        const char* name;
+        uint64_t Info::*field;
+        bool kilobytes;             // Reported in kB; false for plain counts
+    };
+
+    constexpr Key kKeys[] = {
+        { "MemTotal", &Info::memTotal, true },
+        { "MemFree", &Info::memFree, true },
+        { "MemAvailable", &Info::memAvailable, true },
+        { "Buffers", &Info::buffers, true },
+        { "Cached", &Info::cached, true },
+        { "SwapCached", &Info::swapCached, true },
+        { "Active", &Info::active, true },
+        { "Inactive", &Info::inactive, true },
+        { "Active(anon)", &Info::activeAnon, true },
+        { "Inactive(anon)", &Info::inactiveAnon, true },
+        { "Active(file)", &Info::activeFile, true },
+        { "Inactive(file)", &Info::inactiveFile, true },
+        { "Unevictable", &Info::unevictable, true },
+        { "Mlocked", &Info::mlocked, true },
+        { "SwapTotal", &Info::swapTotal, true },
+        { "SwapFree", &Info::swapFree, true },
+        { "Zswap", &Info::zswap, true },
+        { "Zswapped", &Info::zswapped, true },
+        { "Dirty", &Info::dirty, true },
+        { "Writeback", &Info::writeback, true },
+        { "AnonPages", &Info::anonPages, true },
+        { "Mapped", &Info::mapped, true },
+        { "Shmem", &Info::shmem, true },
+        { "KReclaimable", &Info::kReclaimable, true },
+        { "Slab", &Info::slab, true },
+        { "SReclaimable", &Info::slabReclaimable, true },
+        { "SUnreclaim", &Info::slabUnreclaimable, true },
+        { "KernelStack", &Info::kernelStack, true },
+        { "PageTables", &Info::pageTables, true },
+        { "SecPageTables", &Info::secPageTables, true },
+        { "NFS_Unstable", &Info::nfsUnstable, true },
+        { "Bounce", &Info::bounce, true },
+        { "WritebackTmp", &Info::writebackTmp, true },
+        { "CommitLimit", &Info::commitLimit, true },
+        { "Committed_AS", &Info::committed, true },
+        { "VmallocTotal", &Info::vmallocTotal, true },
+        { "VmallocUsed", &Info::vmallocUsed, true },
+        { "VmallocChunk", &Info::vmallocChunk, true },
+        { "Percpu", &Info::percpu, true },
+        { "HardwareCorrupted", &Info::hardwareCorrupted, true },
+        { "AnonHugePages", &Info::anonHugePages, true },
+        { "ShmemHugePages", &Info::shmemHugePages, true },
+        { "ShmemPmdMapped", &Info::shmemPmdMapped, true },
+        { "FileHugePages", &Info::fileHugePages, true },
+        { "FilePmdMapped", &Info::filePmdMapped, true },
+        { "CmaTotal", &Info::cmaTotal, true },
+        { "CmaFree", &Info::cmaFree, true },
+        { "Balloon", &Info::balloon, true },
+        { "Unaccepted", &Info::unaccepted, true },
+        { "HugePages_Total", &Info::hugePagesTotal, false },
+        { "HugePages_Free", &Info::hugePagesFree, false },
+        { "HugePages_Rsvd", &Info::hugePagesReserved, false },
+        { "HugePages_Surp", &Info::hugePagesSurplus, false },
+        { "Hugepagesize", &Info::hugePageSize, true },
+        { "Hugetlb", &Info::hugetlb, true },
+        { "DirectMap4k", &Info::directMap4k, true },
+        { "DirectMap2M", &Info::directMap2M, true },
+        { "DirectMap1G", &Info::directMap1G, true },
+    };
+    constexpr size_t kKeyCount = sizeof(kKeys) / sizeof(kKeys[0]);
+
+    // Perfect hash over the key names, found at compile time: every key lands in
+    // its own slot, so a lookup is one hash, one slot load and one compare
+    constexpr size_t kSlotCount = 512;
+    static_assert(kKeyCount < 127, "Slot indices are stored as int8_t");
+
+    constexpr size_t nameLength(const char* name) {
+        size_t length = 0;
+        while (name[length] != '\0') {
+            ++length;
+        }
+        return length;
+    }
+
+    constexpr uint32_t hashName(const char* name, size_t length, uint32_t seed) {
+        uint32_t hash = 2166136261u ^ seed;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    constexpr bool collisionFree(uint32_t seed) {
+        bool used[kSlotCount] = {};
+        for (size_t i = 0; i < kKeyCount; ++i) {
+            size_t slot = hashName(kKeys[i].name, nameLength(kKeys[i].name), seed) % kSlotCount;
+            if (used[slot]) {
+                return false;
+            }
+            used[slot] = true;
+        }
+        return true;
+    }
+
+    constexpr uint32_t findSeed() {
+        for (uint32_t seed = 1; seed < 100000; ++seed) {
+            if (collisionFree(seed)) {
+                return seed;
+            }
+        }
+        return 0;
+    }
+
+    constexpr uint32_t kSeed = findSeed();
+    static_assert(kSeed != 0, "No collision-free seed for the meminfo key table");
+
+    struct SlotTable {
+        int8_t key[kSlotCount] = {};
+    };
+
+    constexpr SlotTable buildSlots() {
+        SlotTable table;
+        for (size_t slot = 0; slot < kSlotCount; ++slot) {
+            table.key[slot] = -1;
+        }
+        for (size_t i = 0; i < kKeyCount; ++i) {
+            table.key[hashName(kKeys[i].name, nameLength(kKeys[i].name), kSeed) % kSlotCount] = static_cast<int8_t>(i);
+        }
+        return table;
+    }
+
+    constexpr SlotTable kSlots = buildSlots();
+
+    const Key* findKey(const char* name, size_t length) {
+        int8_t index = kSlots.key[hashName(name, length, kSeed) % kSlotCount];
+        if (index < 0) {
+            return nullptr;
+        }
+        const Key& key = kKeys[index];
+        if (std::strncmp(key.name, name, length) != 0 || key.name[length] != '\0') {
+            return nullptr;
+        }
+        return &key;
+    }
+
+    // Value of "Key:   123 kB" in a smaps_rollup-style file, in bytes
+    uint64_t kilobytesField(const std::string& text, const char* key) {
+        size_t keyLen = std::strlen(key);
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (static_cast<size_t>(eol - p) > keyLen && std::strncmp(p, key, keyLen) == 0 && p[keyLen] == ':') {
+                const char* value = p + keyLen + 1;
+                return ProcFS::parseU64(value, eol) * 1024;
+            }
+            p = eol + 1;
+        }
+        return 0;
+    }
+} // namespace
+
+    void parseInfo(const char* text, size_t length, Info& info) {
+        info = Info{};
+        const char* p = text;
+        const char* end = text + length;
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            const char* colon = static_cast<const char*>(std::memchr(p, ':', static_cast<size_t>(eol - p)));
+            if (colon) {
+                const Key* key = findKey(p, static_cast<size_t>(colon - p));
+                if (key) {
+                    const char* value = colon + 1;
+                    uint64_t amount = ProcFS::parseU64(value, eol);
+                    info.*(key->field) = key->kilobytes ? amount * 1024 : amount;
+                }
+            }
+            p = eol + 1;
+        }
+        info.available = info.memTotal > 0;
+    }
+
+    bool Sampler::sample() {
+#ifdef _WIN32
+        return false;
+#else
+        if (!ProcFS::readSource("/proc/meminfo", buffer)) {
+            return false;
+        }
+        parseInfo(buffer.data(), buffer.size(), current);
+
+        if (!ProcFS::readSource("/proc/vmstat", buffer)) {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        uint64_t swapIn = 0;
+        uint64_t swapOut = 0;
+        uint64_t majorFaults = 0;
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (std::strncmp(p, "pswpin ", 7) == 0) {
+                const char* value = p + 7;
+                swapIn = ProcFS::parseU64(value, eol);
+            } else if (std::strncmp(p, "pswpout ", 8) == 0) {
+                const char* value = p + 8;
+                swapOut = ProcFS::parseU64(value, eol);
+            } else if (std::strncmp(p, "pgmajfault ", 11) == 0) {
+                const char* value = p + 11;
+                majorFaults = ProcFS::parseU64(value, eol);
+            }
+            p = eol + 1;
+        }
+        if (samples > 0) {
+            double seconds = std::chrono::duration<double>(now - lastSample).count();
+            if (seconds > 0.0) {
+                rates.swapInPagesPerSec = static_cast<double>(ProcFS::delta(swapIn, previousSwapIn)) / seconds;
+                rates.swapOutPagesPerSec = static_cast<double>(ProcFS::delta(swapOut, previousSwapOut)) / seconds;
+                rates.majorFaultsPerSec = static_cast<double>(ProcFS::delta(majorFaults, previousMajorFaults)) / seconds;
+            }
+        }
+        previousSwapIn = swapIn;
+        previousSwapOut = swapOut;
+        previousMajorFaults = majorFaults;
+        lastSample = now;
+        ++samples;
+        return true;
+#endif
+    }
+
+    std::vector<Process> topProcesses(size_t count) {
+        std::vector<Process> processes;
+#ifndef _WIN32
+        if (count == 0) {
+            return processes;
+        }
+        static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        std::string buffer;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/proc"), ec)) {
+            std::string pid = entry.path().filename().string();
+            if (pid.empty() || pid.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+            // Processes can exit between listing and reading; they are simply skipped
+            if (!ProcFS::readFile(("/proc/" + pid + "/statm").c_str(), buffer)) {
+                continue;
+            }
+            const char* p = buffer.data();
+            const char* end = p + buffer.size();
+            ProcFS::parseU64(p, end);     // Total program size
+            uint64_t resident = ProcFS::parseU64(p, end) * pageSize;
+            if (resident == 0) {
+                continue;       // Kernel threads
+            }
+            Process process;
+            process.pid = std::stoi(pid);
+            process.rss = resident;
+            processes.push_back(std::move(process));
+        }
+
+        size_t keep = std::min(count, processes.size());
+        std::partial_sort(processes.begin(), processes.begin() + static_cast<std::ptrdiff_t>(keep), processes.end(),
+            [](const Process& a, const Process& b) { return a.rss > b.rss; });
+        processes.resize(keep);
+
+        for (auto& process : processes) {
+            std::string base = "/proc/" + std::to_string(process.pid);
+            if (ProcFS::readFile((base + "/comm").c_str(), buffer)) {
+                process.name = buffer.substr(0, buffer.find('\n'));
+            }
+            // Needs the same user or CAP_SYS_PTRACE, and Linux 4.14 or newer
+            if (ProcFS::readFile((base + "/smaps_rollup").c_str(), buffer) && !buffer.empty()) {
+                process.rss = kilobytesField(buffer, "Rss");
+                process.pss = kilobytesField(buffer, "Pss");
+                process.pssAnon = kilobytesField(buffer, "Pss_Anon");
+                process.pssFile = kilobytesField(buffer, "Pss_File");
+                process.pssShmem = kilobytesField(buffer, "Pss_Shmem");
+                process.swap = kilobytesField(buffer, "Swap");
+                process.detailed = true;
+            }
+        }
+#else
+        (void)count;
+#endif
+        return processes;
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Memory namespace encapsulating the detailed memory breakdown: every
+// /proc/meminfo field, paging activity from /proc/vmstat and per-process
+// proportional usage from /proc/<pid>/smaps_rollup
+namespace Memory {
+
+    // /proc/meminfo in bytes, except the HugePages_* fields which are page counts.
+    // Fields the running kernel does not report stay zero.
+    struct Info {
+        bool available = false;
+        uint64_t memTotal = 0;
+        uint64_t memFree = 0;
+        uint64_t memAvailable = 0;
+        uint64_t buffers = 0;
+        uint64_t cached = 0;                // Page cache, excluding swap cache
+        uint64_t swapCached = 0;
+        uint64_t active = 0;
+        uint64_t inactive = 0;
+        uint64_t activeAnon = 0;
+        uint64_t inactiveAnon = 0;
+        uint64_t activeFile = 0;
+        uint64_t inactiveFile = 0;
+        uint64_t unevictable = 0;
+        uint64_t mlocked = 0;
+        uint64_t swapTotal = 0;
+        uint64_t swapFree = 0;
+        uint64_t zswap = 0;
+        uint64_t zswapped = 0;
+        uint64_t dirty = 0;
+        uint64_t writeback = 0;
+        uint64_t anonPages = 0;
+        uint64_t mapped = 0;
+        uint64_t shmem = 0;
+        uint64_t kReclaimable = 0;
+        uint64_t slab = 0;
+        uint64_t slabReclaimable = 0;
+        uint64_t slabUnreclaimable = 0;
+        uint64_t kernelStack = 0;
+        uint64_t pageTables = 0;
+        uint64_t secPageTables = 0;
+        uint64_t nfsUnstable = 0;
+        uint64_t bounce = 0;
+        uint64_t writebackTmp = 0;
+        uint64_t commitLimit = 0;
+        uint64_t committed = 0;             // Committed_AS
+        uint64_t vmallocTotal = 0;
+        uint64_t vmallocUsed = 0;
+        uint64_t vmallocChunk = 0;
+        uint64_t percpu = 0;
+        uint64_t hardwareCorrupted = 0;
+        uint64_t anonHugePages = 0;
+        uint64_t shmemHugePages = 0;
+        uint64_t shmemPmdMapped = 0;
+        uint64_t fileHugePages = 0;
+        uint64_t filePmdMapped = 0;
+        uint64_t cmaTotal = 0;
+        uint64_t cmaFree = 0;
+        uint64_t balloon = 0;
+        uint64_t unaccepted = 0;
+        uint64_t hugePagesTotal = 0;
+        uint64_t hugePagesFree = 0;
+        uint64_t hugePagesReserved = 0;
+        uint64_t hugePagesSurplus = 0;
+        uint64_t hugePageSize = 0;
+        uint64_t hugetlb = 0;
+        uint64_t directMap4k = 0;
+        uint64_t directMap2M = 0;
+        uint64_t directMap1G = 0;
+    };
+
+    // Parses meminfo text (as read from /proc/meminfo) into info
+    void parseInfo(const char* text, size_t length, Info& info);
+
+    // Paging rates from /proc/vmstat
+    struct Activity {
+        double swapInPagesPerSec = 0.0;
+        double swapOutPagesPerSec = 0.0;
+        double majorFaultsPerSec = 0.0;     // Faults that had to wait for disk
+    };
+
+    // Reads /proc/meminfo and /proc/vmstat (one read each per sample) and
+    // reports the vmstat rates against the previous sample
+    class Sampler {
+    public:
+        // Returns false if /proc/meminfo is unavailable
+        bool sample();
+
+        // True once two samples have been taken and the rates are meaningful
+        bool ready() const { return samples >= 2; }
+
+        const Info& info() const { return current; }
+        const Activity& activity() const { return rates; }
+
+    private:
+        Info current;
+        Activity rates;
+        uint64_t previousSwapIn = 0;
+        uint64_t previousSwapOut = 0;
+        uint64_t previousMajorFaults = 0;
+        std::string buffer;
+        std::chrono::steady_clock::time_point lastSample;
+        int samples = 0;
+    };
+
+    // Memory of one process, in bytes
+    struct Process {
+        int pid = 0;
+        std::string name;
+        uint64_t rss = 0;
+        uint64_t pss = 0;           // Shared pages split between the processes mapping them
+        uint64_t pssAnon = 0;
+        uint64_t pssFile = 0;
+        uint64_t pssShmem = 0;
+        uint64_t swap = 0;
+        bool detailed = false;      // smaps_rollup was readable; otherwise only rss is set
+    };
+
+    // The count processes with the largest resident set, largest first. Ranks by
+    // /proc/<pid>/statm, then reads smaps_rollup for just those processes, since
+    // it walks every mapping and costs far more than statm.
+    std::vector<Process> topProcesses(size_t count);
+}
@@ -0,0 +1,192 @@
+// netStats.cpp network interface and TCP sampler implementation
+#include "netStats.h"
+#include "procfs.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace NetStats {
+namespace {
+    using ProcFS::delta;
+
+    double perSecond(uint64_t count, double seconds) {
+        return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+    }
+
+    // Locates the header and value rows of a "Prefix: names...\nPrefix: values..." table
+    bool findTable(const std::string& text, const char* prefix, const char*& header, const char*& values) {
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        size_t prefixLen = std::strlen(prefix);
+        header = nullptr;
+        values = nullptr;
+        for (const char* p = begin; p < end;) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (static_cast<size_t>(eol - p) > prefixLen && std::strncmp(p, prefix, prefixLen) == 0) {
+                if (!header) {
+                    header = p + prefixLen;
+                } else {
+                    values = p + prefixLen;
+                    return true;
+                }
+            }
+            p = eol + 1;
+        }
+        return false;
+    }
+
+    // Returns the zero-based column of name in a header row, or -1
+    int findColumn(const char* header, const char* end, const char* name) {
+        const char* p = header;
+        const char* eol = ProcFS::lineEnd(p, end);
+        for (int column = 0; p < eol; ++column) {
+            std::string token = ProcFS::parseToken(p, eol);
+            if (token.empty()) {
+                break;
+            }
+            if (token == name) {
+                return column;
+            }
+        }
+        return -1;
+    }
+
+    // Returns the value at a column of a value row; negative values read as zero
+    uint64_t valueAt(const char* values, const char* end, int column) {
+        if (column < 0) {
+            return 0;
+        }
+        const char* p = values;
+        const char* eol = ProcFS::lineEnd(p, end);
+        for (int i = 0; i < column && p < eol; ++i) {
+            ProcFS::parseToken(p, eol);
+        }
+        while (p < eol && *p == ' ') {
+            ++p;
+        }
+        if (p < eol && *p == '-') {
+            return 0;
+        }
+        return ProcFS::parseU64(p, eol);
+    }
+} // namespace
+
+    bool isLoopback(const std::string& name) {
+        return name == "lo";
+    }
+
+    bool Sampler::sample() {
+#ifdef _WIN32
+        return false;
+#else
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastSample).count();
+        if (!readInterfaces(seconds)) {
+            return false;
+        }
+
+        TcpCounters tcpNow;
+        readTcp(tcpNow);
+        if (samples > 0) {
+            uint64_t outSegs = delta(tcpNow.outSegs, previousTcp.outSegs);
+            uint64_t retrans = delta(tcpNow.retransSegs, previousTcp.retransSegs);
+            tcpRates.outSegsPerSec = perSecond(outSegs, seconds);
+            tcpRates.retransPerSec = perSecond(retrans, seconds);
+            tcpRates.retransPercent = outSegs ? static_cast<double>(retrans) / outSegs * 100.0 : 0.0;
+            tcpRates.listenOverflowsPerSec = perSecond(delta(tcpNow.listenOverflows, previousTcp.listenOverflows), seconds);
+            tcpRates.listenDropsPerSec = perSecond(delta(tcpNow.listenDrops, previousTcp.listenDrops), seconds);
+        }
+        previousTcp = tcpNow;
+
+        lastSample = now;
+        ++samples;
+        return true;
+#endif
+    }
+
+    bool Sampler::readInterfaces(double seconds) {
+        if (!ProcFS::readSource("/proc/net/dev", buffer)) {
+            return false;
+        }
+        index.begin();
+        const char* p = buffer.data();
+        const char* bufferEnd = p + buffer.size();
+        while (p < bufferEnd) {
+            const char* eol = ProcFS::lineEnd(p, bufferEnd);
+            const char* colon = static_cast<const char*>(std::memchr(p, ':', static_cast<size_t>(eol - p)));
+            // The two header rows have no "name:" prefix
+            if (colon && std::memchr(p, '|', static_cast<size_t>(eol - p)) == nullptr) {
+                const char* nameStart = p;
+                while (nameStart < colon && *nameStart == ' ') {
+                    ++nameStart;
+                }
+                index.add(std::string_view(nameStart, static_cast<size_t>(colon - nameStart)), colon + 1, eol);
+            }
+            p = eol + 1;
+        }
+        index.finish([](const std::string&) { return true; });
+
+        std::vector<Interface>& interfaces = index.entries();
+        std::vector<Counters>& previous = index.counters();
+        for (size_t i = 0; i < index.rowCount(); ++i) {
+            int slot = index.slot(i);
+            const char* cursor = index.fields(i);
+            const char* end = index.end(i);
+            Counters c;
+            c.rxBytes = ProcFS::parseU64(cursor, end);
+            c.rxPackets = ProcFS::parseU64(cursor, end);
+            c.rxErrors = ProcFS::parseU64(cursor, end);
+            c.rxDrops = ProcFS::parseU64(cursor, end);
+            ProcFS::parseU64(cursor, end);    // fifo
+            ProcFS::parseU64(cursor, end);    // frame
+            ProcFS::parseU64(cursor, end);    // compressed
+            ProcFS::parseU64(cursor, end);    // multicast
+            c.txBytes = ProcFS::parseU64(cursor, end);
+            c.txPackets = ProcFS::parseU64(cursor, end);
+            c.txErrors = ProcFS::parseU64(cursor, end);
+            c.txDrops = ProcFS::parseU64(cursor, end);
+            c.valid = true;
+
+            Counters& prev = previous[static_cast<size_t>(slot)];
+            Interface& iface = interfaces[static_cast<size_t>(slot)];
+            if (prev.valid) {
+                iface.rxBytesPerSec = perSecond(delta(c.rxBytes, prev.rxBytes), seconds);
+                iface.txBytesPerSec = perSecond(delta(c.txBytes, prev.txBytes), seconds);
+                iface.rxPacketsPerSec = perSecond(delta(c.rxPackets, prev.rxPackets), seconds);
+                iface.txPacketsPerSec = perSecond(delta(c.txPackets, prev.txPackets), seconds);
+                iface.rxDropsPerSec = perSecond(delta(c.rxDrops, prev.rxDrops), seconds);
+                iface.txDropsPerSec = perSecond(delta(c.txDrops, prev.txDrops), seconds);
+                iface.rxErrorsPerSec = perSecond(delta(c.rxErrors, prev.rxErrors), seconds);
+                iface.txErrorsPerSec = perSecond(delta(c.txErrors, prev.txErrors), seconds);
+            }
+            prev = c;
+        }
+        return true;
+    }
+
+    void Sampler::readTcp(TcpCounters& counters) {
+        const char* header = nullptr;
+        const char* values = nullptr;
+        if (ProcFS::readSource("/proc/net/snmp", buffer) && findTable(buffer, "Tcp:", header, values)) {
+            const char* end = buffer.data() + buffer.size();
+            if (!snmpColumnsResolved) {
+                snmpColumnsResolved = true;
+                outSegsColumn = findColumn(header, end, "OutSegs");
+                retransColumn = findColumn(header, end, "RetransSegs");
+            }
+            counters.outSegs = valueAt(values, end, outSegsColumn);
+            counters.retransSegs = valueAt(values, end, retransColumn);
+        }
+        // Listen queue overflows are TcpExt counters, which live in /proc/net/netstat
+        if (ProcFS::readSource("/proc/net/netstat", buffer) && findTable(buffer, "TcpExt:", header, values)) {
+            const char* end = buffer.data() + buffer.size();
+            if (!netstatColumnsResolved) {
+                netstatColumnsResolved = true;
+                listenOverflowsColumn = findColumn(header, end, "ListenOverflows");
+                listenDropsColumn = findColumn(header, end, "ListenDrops");
+            }
+            counters.listenOverflows = valueAt(values, end, listenOverflowsColumn);
+            counters.listenDrops = valueAt(values, end, listenDropsColumn);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "procfs.h"
+
+// NetStats namespace encapsulating network interface and TCP metrics from /proc/net
+namespace NetStats {
+
+    // Per-interface rates computed from the delta between two samples
+    struct Interface {
+        std::string name;
+        double rxBytesPerSec = 0.0;
+        double txBytesPerSec = 0.0;
+        double rxPacketsPerSec = 0.0;
+        double txPacketsPerSec = 0.0;
+        double rxDropsPerSec = 0.0;
+        double txDropsPerSec = 0.0;
+        double rxErrorsPerSec = 0.0;
+        double txErrorsPerSec = 0.0;
+    };
+
+    // System-wide TCP rates
+    struct Tcp {
+        double outSegsPerSec = 0.0;
+        double retransPerSec = 0.0;
+        double retransPercent = 0.0;      // Retransmitted segments as a share of sent segments
+        double listenOverflowsPerSec = 0.0;
+        double listenDropsPerSec = 0.0;
+    };
+
+    // Samples /proc/net/dev, /proc/net/snmp and /proc/net/netstat (one read each per
+    // sample) and reports rates against the previous sample. Interface slots and
+    // the column positions of the TCP counters are resolved once and cached.
+    class Sampler {
+    public:
+        // Returns false if /proc/net/dev is unavailable
+        bool sample();
+
+        // True once two samples have been taken and the rates are meaningful
+        bool ready() const { return samples >= 2; }
+
+        const std::vector<Interface>& interfaces() const { return index.entries(); }
+        const Tcp& tcp() const { return tcpRates; }
+
+    private:
+        struct Counters {
+            uint64_t rxBytes = 0;
+            uint64_t rxPackets = 0;
+            uint64_t rxErrors = 0;
+            uint64_t rxDrops = 0;
+            uint64_t txBytes = 0;
+            uint64_t txPackets = 0;
+            uint64_t txErrors = 0;
+            uint64_t txDrops = 0;
+            bool valid = false;
+        };
+
+        struct TcpCounters {
+            uint64_t outSegs = 0;
+            uint64_t retransSegs = 0;
+            uint64_t listenOverflows = 0;
+            uint64_t listenDrops = 0;
+        };
+
+        // Line of /proc/net/dev -> interface slot
+        ProcFS::RowIndex<Interface, Counters> index;
+
+        // Column positions inside the "Tcp:" and "TcpExt:" rows, resolved on first read
+        bool snmpColumnsResolved = false;
+        bool netstatColumnsResolved = false;
+        int outSegsColumn = -1;
+        int retransColumn = -1;
+        int listenOverflowsColumn = -1;
+        int listenDropsColumn = -1;
+        TcpCounters previousTcp;
+        Tcp tcpRates;
+
+        std::string buffer;
+        std::chrono::steady_clock::time_point lastSample;
+        int samples = 0;
+
+        bool readInterfaces(double seconds);
+        void readTcp(TcpCounters& counters);
+    };
+
+    // Returns true for interfaces that never carry external traffic (loopback)
+    bool isLoopback(const std::string& name);
+}
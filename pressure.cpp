@@ -0,0 +1,53 @@
+// pressure.cpp PSI implementation
+#include "pressure.h"
+#include "procfs.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace Pressure {
+namespace {
+    // Parses the value following key= on a PSI line, e.g. "avg10=1.25"
+    double psiField(const char* line, const char* end, const char* key) {
+        size_t keyLen = std::strlen(key);
+        for (const char* p = line; p + keyLen < end; ++p) {
+            if (std::strncmp(p, key, keyLen) == 0 && p[keyLen] == '=') {
+                return std::strtod(p + keyLen + 1, nullptr);
+            }
+        }
+        return 0.0;
+    }
+} // namespace
+
+    Stall read(const char* resource) {
+        // ProcFS::readSource applies the configured root itself
+        return readFile(std::string("/proc/pressure/") + resource);
+    }
+
+    Stall readFile(const std::string& path) {
+        Stall stall;
+#ifndef _WIN32
+        std::string buffer;
+        if (!ProcFS::readSource(path.c_str(), buffer) || buffer.empty()) {
+            return stall;
+        }
+        stall.available = true;
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (std::strncmp(p, "some ", 5) == 0) {
+                stall.someAvg10 = psiField(p, eol, "avg10");
+                stall.someAvg60 = psiField(p, eol, "avg60");
+            } else if (std::strncmp(p, "full ", 5) == 0) {
+                stall.fullAvg10 = psiField(p, eol, "avg10");
+                stall.fullAvg60 = psiField(p, eol, "avg60");
+            }
+            p = eol + 1;
+        }
+#else
+        (void)path;
+#endif
+        return stall;
+    }
+}
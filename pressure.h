@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Pressure namespace encapsulating contention signals: pressure stall
+// information from /proc/pressure and swap activity (sampled by Memory::Sampler)
+namespace Pressure {
+
+    // Share of wall time in which some (or all) runnable tasks were stalled on a resource
+    struct Stall {
+        bool available = false;
+        double someAvg10 = 0.0;
+        double someAvg60 = 0.0;
+        double fullAvg10 = 0.0;
+        double fullAvg60 = 0.0;
+    };
+
+    // Reads /proc/pressure/<resource> where resource is "cpu", "memory" or "io"
+    Stall read(const char* resource);
+
+    // Reads any file in PSI format, e.g. a cgroup's memory.pressure
+    Stall readFile(const std::string& path);
+
+    // Swap-in and swap-out rates in pages per second
+    struct Swap {
+        double pagesInPerSec = 0.0;
+        double pagesOutPerSec = 0.0;
+    };
+}
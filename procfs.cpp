@@ -0,0 +1,143 @@
+// procfs.cpp shared /proc reading helpers
+#include "procfs.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>      // For open
+#include <unistd.h>     // For pread and close
+#endif
+
+namespace ProcFS {
+namespace {
+    std::string& root() {
+        static std::string prefix;
+        return prefix;
+    }
+
+#ifndef _WIN32
+    // One kept-open polled file. The descriptor is only replaced under its own lock,
+    // so a concurrent reader never preads from a closed (or reused) descriptor.
+    struct Source {
+        std::mutex mutex;
+        int fd = -1;
+        size_t hint = 4096;         // Read size that fitted last time, so one pread usually suffices
+    };
+
+    // Process-lifetime registry keyed by the root-applied path. Entries are never
+    // removed; a source that disappears just fails its reopen.
+    class Sources {
+    public:
+        static Sources& instance() {
+            static Sources sources;
+            return sources;
+        }
+
+        Source& get(const std::string& fullPath) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& entry = entries[fullPath];
+            if (!entry) {
+                entry = std::make_unique<Source>();
+            }
+            return *entry;
+        }
+
+    private:
+        std::mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<Source>> entries;
+    };
+
+    // Reads everything from offset 0; returns false on a read error
+    bool preadAll(int fd, size_t hint, std::string& buffer) {
+        buffer.resize(hint);
+        size_t used = 0;
+        while (true) {
+            ssize_t n = ::pread(fd, &buffer[used], buffer.size() - used, static_cast<off_t>(used));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                buffer.clear();
+                return false;
+            }
+            if (n == 0) {
+                break;
+            }
+            used += static_cast<size_t>(n);
+            if (used == buffer.size()) {
+                buffer.resize(buffer.size() * 2);
+            }
+        }
+        buffer.resize(used);
+        return true;
+    }
+#endif
+} // namespace
+
+    void setRoot(const std::string& prefix) {
+        root() = prefix;
+        while (!root().empty() && root().back() == '/') {
+            root().pop_back();
+        }
+    }
+
+    std::string path(const char* absolute) {
+        return root().empty() ? std::string(absolute) : root() + absolute;
+    }
+
+    bool readFile(const char* path, std::string& buffer) {
+        SIT_PROFILE_SCOPE(ProcRead);
+        std::ifstream file;
+        if (root().empty()) {
+            file.open(path, std::ios::binary);
+        } else {
+            file.open(root() + path, std::ios::binary);
+        }
+        if (!file) {
+            buffer.clear();
+            return false;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        SIT_PROFILE_COUNT(ProcReads, 1);
+        SIT_PROFILE_COUNT(ProcBytes, buffer.size());
+        return true;
+    }
+
+    bool readSource(const char* path, std::string& buffer) {
+#ifdef _WIN32
+        return readFile(path, buffer);
+#else
+        std::string fullPath = ProcFS::path(path);
+        Source& source = Sources::instance().get(fullPath);
+        std::lock_guard<std::mutex> lock(source.mutex);
+        SIT_PROFILE_SCOPE(ProcRead);
+        if (source.fd < 0) {
+            source.fd = ::open(fullPath.c_str(), O_RDONLY | O_CLOEXEC);
+            SIT_PROFILE_COUNT(Opens, 1);
+            if (source.fd < 0) {
+                buffer.clear();
+                return false;
+            }
+        }
+        if (!preadAll(source.fd, source.hint, buffer)) {
+            // Not seekable or gone stale (a cgroup removed under us): drop the descriptor
+            // and let the next call reopen it
+            ::close(source.fd);
+            source.fd = -1;
+            return readFile(path, buffer);
+        }
+        // Room for modest growth, so the next refresh still fits in one pread
+        source.hint = std::max(source.hint, buffer.size() + buffer.size() / 4 + 64);
+        SIT_PROFILE_COUNT(SourceReads, 1);
+        SIT_PROFILE_COUNT(ProcBytes, buffer.size());
+        return true;
+#endif
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ProcFS namespace with small helpers shared by the /proc collectors
+namespace ProcFS {
+
+    // Prefix applied to every /proc and /sys path read through these helpers.
+    // Empty (the default) reads the live system; benchmarks point it at recorded fixtures.
+    void setRoot(const std::string& root);
+
+    // The absolute /proc or /sys path under the configured root
+    std::string path(const char* absolute);
+
+    // Reads a whole file into buffer, reusing its capacity. Returns false if it cannot be opened.
+    bool readFile(const char* path, std::string& buffer);
+
+    // Reads a file that is polled every tick (/proc/stat, /proc/meminfo, cgroup control
+    // files). The descriptor is opened on first use and kept for the life of the process;
+    // each call refreshes the contents with pread from offset 0, so a steady sampling loop
+    // issues one pread per source instead of open, read and close. Falls back to readFile
+    // if the descriptor stops working. Safe to call from concurrent collectors.
+    bool readSource(const char* path, std::string& buffer);
+
+    // Skips blanks and parses the next unsigned integer field, advancing the cursor past it
+    inline uint64_t parseU64(const char*& p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        uint64_t value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + static_cast<uint64_t>(*p - '0');
+            ++p;
+        }
+        return value;
+    }
+
+    // Skips blanks and returns the next whitespace-delimited token, advancing the cursor past it.
+    // The view points into the parsed buffer.
+    inline std::string_view parseTokenView(const char*& p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        const char* start = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\n') {
+            ++p;
+        }
+        return std::string_view(start, static_cast<size_t>(p - start));
+    }
+
+    inline std::string parseToken(const char*& p, const char* end) {
+        return std::string(parseTokenView(p, end));
+    }
+
+    // Returns the end of the line starting at p (the newline or end)
+    inline const char* lineEnd(const char* p, const char* end) {
+        while (p < end && *p != '\n') {
+            ++p;
+        }
+        return p;
+    }
+
+    // Counter delta that tolerates resets and wraps by reporting zero
+    inline uint64_t delta(uint64_t now, uint64_t before) {
+        return now >= before ? now - before : 0;
+    }
+
+    // Maps the named rows of a polled table (/proc/diskstats, /proc/net/dev) to slots in
+    // per-entry arrays. Each pass compares the row names with the cached ones in place, so
+    // a steady table allocates nothing; slots are only rebuilt when rows come, go or move.
+    // Entry needs a std::string name; known names keep their entry and counters.
+    template <typename Entry, typename Counters>
+    class RowIndex {
+    public:
+        // Starts a pass over a freshly read table
+        void begin() {
+            rows.clear();
+            changed = false;
+        }
+
+        // Records the next row: its name and the rest of the line after it
+        void add(std::string_view name, const char* fields, const char* end) {
+            size_t row = rows.size();
+            if (row >= names.size() || names[row] != name) {
+                if (!changed) {
+                    names.resize(row);
+                    changed = true;
+                }
+                names.emplace_back(name);
+            }
+            rows.push_back({ fields, end });
+        }
+
+        // Ends the pass, remapping the rows if they changed. A name seen for the first
+        // time only gets a slot when track(name) is true.
+        template <typename Track>
+        void finish(Track&& track) {
+            if (rows.size() != names.size()) {
+                names.resize(rows.size());
+                changed = true;
+            }
+            if (!changed && slots.size() == names.size()) {
+                return;
+            }
+            std::vector<Entry> nextEntries;
+            std::vector<Counters> nextCounters;
+            std::unordered_map<std::string, int> nextSlots;
+            slots.assign(names.size(), -1);
+            for (size_t i = 0; i < names.size(); ++i) {
+                const std::string& name = names[i];
+                auto known = slotByName.find(name);
+                if (known == slotByName.end() && !track(name)) {
+                    continue;
+                }
+                int slot = static_cast<int>(nextEntries.size());
+                if (known != slotByName.end()) {
+                    nextEntries.push_back(current[static_cast<size_t>(known->second)]);
+                    nextCounters.push_back(previous[static_cast<size_t>(known->second)]);
+                } else {
+                    Entry entry;
+                    entry.name = name;
+                    nextEntries.push_back(entry);
+                    nextCounters.push_back(Counters{});
+                }
+                nextSlots[name] = slot;
+                slots[i] = slot;
+            }
+            current = std::move(nextEntries);
+            previous = std::move(nextCounters);
+            slotByName = std::move(nextSlots);
+        }
+
+        size_t rowCount() const { return rows.size(); }
+        const char* fields(size_t row) const { return rows[row].first; }
+        const char* end(size_t row) const { return rows[row].second; }
+
+        // Slot of a row, or -1 when it is not tracked
+        int slot(size_t row) const { return slots[row]; }
+
+        std::vector<Entry>& entries() { return current; }
+        const std::vector<Entry>& entries() const { return current; }
+        std::vector<Counters>& counters() { return previous; }
+
+    private:
+        std::vector<std::string> names;                     // Row names of the last pass, in order
+        std::vector<std::pair<const char*, const char*>> rows;     // This pass; points into the caller's buffer
+        std::vector<int> slots;
+        std::unordered_map<std::string, int> slotByName;
+        std::vector<Entry> current;
+        std::vector<Counters> previous;
+        bool changed = false;
+    };
+}
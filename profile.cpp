@@ -0,0 +1,193 @@
+// profile.cpp self-profiling implementation
+#include "profile.h"
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Profile {
+namespace detail {
+    std::atomic<bool> active{ false };
+}
+
+namespace {
+    struct PhaseInfo {
+        const char* name;
+        bool traced;        // Fine-grained phases stay out of the trace to keep it small
+    };
+
+    constexpr std::array<PhaseInfo, static_cast<size_t>(Phase::Count)> kPhases = { {
+        { "integrity.walk", false },
+        { "integrity.stat", false },
+        { "integrity.hash_file", true },
+        { "integrity.hash_read", false },
+        { "integrity.sha256", false },
+        { "integrity.sample_file", true },
+        { "integrity.manifest_load", true },
+        { "integrity.manifest_write", true },
+        { "proc.read", true },
+        { "collect.host", true },
+        { "collect.cpu", true },
+        { "collect.memory", true },
+        { "collect.io", true },
+        { "collect.cgroup", true },
+        { "collect.mounts", true },
+        { "collect.sensors", true },
+    } };
+
+    constexpr std::array<const char*, static_cast<size_t>(Counter::Count)> kCounters = {
+        "files", "bytes hashed", "dir entries", "opens", "reads", "stats", "proc reads", "source reads", "proc bytes"
+    };
+
+    // Bounds trace memory for very large trees; later events are counted but dropped
+    constexpr size_t kMaxTraceEvents = 1000000;
+
+    struct Event {
+        Phase phase;
+        uint32_t thread;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Phase::Count)> calls{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Phase::Count)> totalNs{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count)> counters{};
+    std::atomic<bool> tracing{ false };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<uint32_t> nextThread{ 1 };
+    uint64_t enabledAt = 0;
+    std::mutex traceMutex;
+    std::vector<Event> events;
+
+    uint32_t threadNumber() {
+        thread_local uint32_t number = nextThread.fetch_add(1, std::memory_order_relaxed);
+        return number;
+    }
+
+    void writeJsonString(std::ostream& out, const char* text) {
+        out << '"';
+        for (const char* p = text; *p; ++p) {
+            if (*p == '"' || *p == '\\') {
+                out << '\\';
+            }
+            out << *p;
+        }
+        out << '"';
+    }
+} // namespace
+
+    uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void enable(bool withTrace) {
+        enabledAt = nowNs();
+        tracing.store(withTrace, std::memory_order_relaxed);
+        if (withTrace) {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            events.reserve(4096);
+        }
+        detail::active.store(true, std::memory_order_relaxed);
+    }
+
+    void record(Phase phase, uint64_t startNs, uint64_t durationNs) {
+        size_t index = static_cast<size_t>(phase);
+        calls[index].fetch_add(1, std::memory_order_relaxed);
+        totalNs[index].fetch_add(durationNs, std::memory_order_relaxed);
+        if (!kPhases[index].traced || !tracing.load(std::memory_order_relaxed)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(traceMutex);
+        if (events.size() >= kMaxTraceEvents) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events.push_back({ phase, threadNumber(), startNs, durationNs });
+    }
+
+    void add(Counter counter, uint64_t amount) {
+        counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void report(std::ostream& out) {
+        double wallMs = (nowNs() - enabledAt) / 1e6;
+        double wallSec = wallMs / 1000.0;
+
+        std::ios oldState(nullptr);
+        oldState.copyfmt(out);
+        out << std::fixed << std::setprecision(2);
+        out << "---------- Profile ----------" << std::endl;
+        out << std::left << std::setw(28) << "Phase" << std::right << std::setw(10) << "Calls"
+            << std::setw(12) << "Total ms" << std::setw(12) << "Avg us" << std::setw(9) << "% wall" << std::endl;
+        for (size_t i = 0; i < kPhases.size(); ++i) {
+            uint64_t count = calls[i].load(std::memory_order_relaxed);
+            if (count == 0) {
+                continue;
+            }
+            double ms = totalNs[i].load(std::memory_order_relaxed) / 1e6;
+            out << std::left << std::setw(28) << kPhases[i].name << std::right << std::setw(10) << count
+                << std::setw(12) << ms << std::setw(12) << ms * 1000.0 / count
+                << std::setw(9) << (wallMs > 0.0 ? ms / wallMs * 100.0 : 0.0) << std::endl;
+        }
+
+        auto counter = [](Counter which) {
+            return counters[static_cast<size_t>(which)].load(std::memory_order_relaxed);
+        };
+        out << "Wall time: " << wallMs << " ms" << std::endl;
+        for (size_t i = 0; i < kCounters.size(); ++i) {
+            uint64_t value = counters[i].load(std::memory_order_relaxed);
+            if (value > 0) {
+                out << std::left << std::setw(14) << kCounters[i] << std::right << std::setw(14) << value << std::endl;
+            }
+        }
+        if (wallSec > 0.0) {
+            if (counter(Counter::Files) > 0) {
+                out << "Files/s: " << counter(Counter::Files) / wallSec << std::endl;
+            }
+            if (counter(Counter::BytesHashed) > 0) {
+                out << "Hashed MB/s: " << counter(Counter::BytesHashed) / wallSec / (1024.0 * 1024.0) << std::endl;
+            }
+        }
+        // Opens, reads and stats we issue ourselves; library internals are not seen
+        uint64_t syscalls = counter(Counter::Opens) + counter(Counter::Reads) + counter(Counter::Stats)
+            + counter(Counter::ProcReads) * 3 + counter(Counter::SourceReads);
+        out << "Syscalls (approx): " << syscalls << std::endl;
+        out.copyfmt(oldState);
+    }
+
+    bool writeTrace(const std::string& path, std::string* error) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            if (error) {
+                *error = "Unable to write trace file: " + path;
+            }
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(traceMutex);
+        out << "{\"traceEvents\":[";
+        out << std::fixed << std::setprecision(3);
+        bool first = true;
+        for (const auto& event : events) {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(out, kPhases[static_cast<size_t>(event.phase)].name);
+            out << ",\"cat\":\"sit\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                << ",\"ts\":" << (event.startNs - enabledAt) / 1000.0
+                << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+            first = false;
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":"
+            << dropped.load(std::memory_order_relaxed) << "}}\n";
+        if (!out) {
+            if (error) {
+                *error = "Error while writing trace file: " + path;
+            }
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Instrumentation is compiled in by default; build with -DSIT_PROFILE=0 to
+// remove every scope and counter from the hot paths entirely. Compiled in but
+// not enabled at run time, a scope costs one relaxed load and a branch.
+#ifndef SIT_PROFILE
+#define SIT_PROFILE 1
+#endif
+
+// Profile namespace encapsulating per-phase timers, counters and the Chrome
+// trace writer behind --profile and --trace
+namespace Profile {
+    enum class Phase {
+        IntegrityWalk,      // Directory iteration
+        IntegrityStat,      // Size and mtime lookups
+        HashFile,           // Whole-file hashing, open to digest
+        HashRead,           // Read calls inside hashing
+        HashCompute,        // SHA-256 compression inside hashing
+        SampleFile,         // Sampled fingerprint, open to digest
+        ManifestLoad,
+        ManifestWrite,
+        ProcRead,
+        CollectHost,
+        CollectCpu,
+        CollectMemory,
+        CollectIo,
+        CollectCgroup,
+        CollectMounts,
+        CollectSensors,
+        Count
+    };
+
+    enum class Counter {
+        Files,
+        BytesHashed,
+        DirEntries,
+        Opens,
+        Reads,
+        Stats,
+        ProcReads,
+        SourceReads,        // Refreshes of a kept-open source: one pread each
+        ProcBytes,
+        Count
+    };
+
+    namespace detail {
+        extern std::atomic<bool> active;
+    }
+
+    inline bool enabled() {
+        return detail::active.load(std::memory_order_relaxed);
+    }
+
+    // Starts collecting; with tracing, coarse phases are also kept as trace events
+    void enable(bool tracing);
+
+    uint64_t nowNs();
+    void record(Phase phase, uint64_t startNs, uint64_t durationNs);
+    void add(Counter counter, uint64_t amount);
+
+    // Phase breakdown, throughput and approximate syscall counts since enable()
+    void report(std::ostream& out);
+
+    bool writeTrace(const std::string& path, std::string* error);
+
+    class Scope {
+    public:
+        explicit Scope(Phase phase) : phase(phase), active(enabled()), start(active ? nowNs() : 0) {}
+        ~Scope() {
+            if (active) {
+                record(phase, start, nowNs() - start);
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Phase phase;
+        bool active;
+        uint64_t start;
+    };
+}
+
+#if SIT_PROFILE
+#define SIT_PROFILE_CONCAT_INNER(a, b) a##b
+#define SIT_PROFILE_CONCAT(a, b) SIT_PROFILE_CONCAT_INNER(a, b)
+#define SIT_PROFILE_SCOPE(phase) ::Profile::Scope SIT_PROFILE_CONCAT(sitProfileScope, __LINE__)(::Profile::Phase::phase)
+#define SIT_PROFILE_COUNT(counter, amount) \
+    do { \
+        if (::Profile::enabled()) { \
+            ::Profile::add(::Profile::Counter::counter, static_cast<uint64_t>(amount)); \
+        } \
+    } while (0)
+#else
+#define SIT_PROFILE_SCOPE(phase) ((void)0)
+#define SIT_PROFILE_COUNT(counter, amount) ((void)0)
+#endif
@@ -0,0 +1,451 @@
+#include "scan.h"
+
+#include <algorithm>       // For std::max
+#include <cmath>           // For std::ceil and std::fabs
+#include <iomanip>         // For std::fixed and std::setprecision
+#include "sensors.h"
+
+namespace Scan {
+namespace {
+    struct ProblemInfo {
+        const char* key;
+        const char* tip;
+    };
+
+    // Indexed by Problem
+    constexpr ProblemInfo kProblems[] = {
+        { "high_cpu",                    "Close heavy apps or check background processes." },
+        { "elevated_cpu",                "Check for apps using unusual CPU." },
+        { "severe_cpu_contention",       "More threads are runnable than CPUs can serve; reduce concurrency or add CPUs." },
+        { "cpu_contention",              "Look for bursty thread pools, CPU quota throttling or processes pinned to few CPUs." },
+        { "contended_cpu",               "Check CPU affinity, IRQ pinning and isolcpus settings; other CPUs have spare time." },
+        { "frequent_context_switches",   "Threads are handing off work in tiny pieces; check lock contention and spinning thread pools." },
+        { "long_run_queue",              "Work is queueing for CPU time; see which processes are runnable with top or ps -eo stat." },
+        { "high_ram",                    "Close apps or upgrade memory if needed." },
+        { "elevated_ram",                "Close unused apps and browser tabs." },
+        { "hardware_corrupted_memory",   "Check EDAC/mcelog output and schedule the failing DIMM for replacement." },
+        { "large_unreclaimable_slab",    "Check /proc/slabinfo or slabtop for a growing cache; this often points at a kernel or driver leak." },
+        { "dirty_writeback",             "Writers will soon be throttled; check the write throughput of the backing disks." },
+        { "memory_overcommitted",        "Allocations rely on overcommit; a burst of real use can wake the OOM killer." },
+        { "unused_huge_pages",           "Huge pages are unavailable to normal allocations; lower vm.nr_hugepages if nothing will use them." },
+        { "heavy_swapping",              "The working set does not fit in RAM; reduce memory use or add memory." },
+        { "active_swapping",             "Look for processes that outgrew their memory budget." },
+        { "frequent_major_faults",       "Page cache is too small for the working files; processes are waiting on disk." },
+        { "process_holds_swap",          "Its memory use has outgrown RAM; check it for leaks or limits." },
+        { "very_long_uptime",            "Reboot to clear leaks and apply updates." },
+        { "long_uptime",                 "Consider a reboot if issues appear." },
+        { "high_cpu_temperature",        "Check cooling, fans, and airflow." },
+        { "elevated_cpu_temperature",    "Clean dust and ensure good airflow." },
+        { "mount_not_responding",        "Check the server or device behind this mount." },
+        { "mount_almost_full",           "Free space or grow the filesystem." },
+        { "mount_filling_up",            "Plan cleanup before it fills." },
+        { "mount_out_of_inodes",         "Remove many small files or recreate the filesystem with more inodes." },
+        { "mount_inodes_high",           "Look for directories with large numbers of small files." },
+        { "saturated_disk",              "Find the processes doing heavy I/O or move load to another device." },
+        { "busy_disk",                   "Watch for I/O latency in applications on this device." },
+        { "interface_drops",             "Check ring buffer sizes, softirq load and link saturation." },
+        { "interface_errors",            "Check cabling, NIC firmware and duplex settings." },
+        { "tcp_retransmit_spike",        "Look for packet loss or congestion on the path." },
+        { "elevated_tcp_retransmits",    "Check for packet loss between this host and its peers." },
+        { "listen_queue_overflow",       "Increase the listen backlog or the accept rate of the server." },
+        { "container_throttled",         "Raise the cpu.max quota or reduce the workload's parallelism." },
+        { "container_throttling",        "Throttling adds latency even when average CPU looks low." },
+        { "container_throttled_since_start", "Review the cpu.max quota against peak demand." },
+        { "hot_nvme",                    "NVMe drives throttle when hot; check airflow over the drive." },
+        { "hot_dimm",                    "Check chassis airflow around the DIMMs." },
+        { "thermal_throttling",          "The CPU has slowed itself down to cool off; check cooling." },
+        { "unusually_high",              "Outside this host's normal range; compare with recent deploys, jobs or traffic changes." },
+        { "unusually_low",               "Outside this host's normal range; compare with recent deploys, jobs or traffic changes." },
+    };
+    static_assert(sizeof(kProblems) / sizeof(kProblems[0]) == static_cast<size_t>(Problem::Count),
+        "kProblems must list every Problem");
+
+    // Appends a finding; the values after the problem are the ones its message quotes
+    class Builder {
+    public:
+        explicit Builder(Result& result) : result(result) {
+            result.count = 0;
+            result.dropped = 0;
+        }
+
+        void add(Severity severity, Problem problem, const char* subject = nullptr, const char* device = nullptr,
+            double a = 0.0, double b = 0.0, double c = 0.0, double d = 0.0, double e = 0.0, double f = 0.0) {
+            if (result.count >= kMaxFindings) {
+                ++result.dropped;
+                return;
+            }
+            result.findings[result.count++] = Finding{ problem, severity, subject, device, { a, b, c, d, e, f } };
+        }
+
+        void warn(Problem problem, double a = 0.0, double b = 0.0, double c = 0.0) {
+            add(Severity::Warning, problem, nullptr, nullptr, a, b, c);
+        }
+
+        void critical(Problem problem, double a = 0.0, double b = 0.0, double c = 0.0) {
+            add(Severity::Critical, problem, nullptr, nullptr, a, b, c);
+        }
+
+    private:
+        Result& result;
+    };
+
+    int whole(double value) {
+        return static_cast<int>(value);
+    }
+
+    uint64_t megabytes(double bytes) {
+        return static_cast<uint64_t>(bytes) / (1024 * 1024);
+    }
+} // namespace
+
+    void scan(const Metrics::Snapshot& snapshot, Result& result) {
+        Builder add(result);
+        double cpu = snapshot.cpuUsageSmoothed;
+        double ram = snapshot.ramUsageSmoothed;
+        double tempC = snapshot.cpuTempC;
+
+        if (cpu >= 85.0) {
+            add.critical(Problem::HighCpu, cpu);
+        } else if (cpu >= 70.0) {
+            add.warn(Problem::ElevatedCpu, cpu);
+        }
+
+        // Waiting for a CPU is what users feel as latency, and it can be high while average
+        // utilisation looks moderate: bursts, a few hot CPUs, pinned threads or quota throttling
+        if (snapshot.ratesReady.sched && snapshot.sched.schedstatAvailable) {
+            const auto& sched = snapshot.sched;
+            if (sched.runQueueWaitPercent >= 50.0) {
+                add.critical(Problem::SevereCpuContention, sched.runQueueWaitPercent);
+            } else if (sched.runQueueWaitPercent >= 10.0) {
+                // The CPU usage is only quoted when it makes the contention surprising
+                add.warn(Problem::CpuContention, sched.runQueueWaitPercent, cpu < 70.0 ? cpu : -1.0);
+            } else if (sched.maxCpuWaitPercent >= 50.0 && sched.cpus > 1) {
+                add.warn(Problem::ContendedCpu, sched.maxCpuWaitPercent);
+            }
+        }
+        if (snapshot.ratesReady.sched) {
+            double switchesPerCpu = snapshot.sched.contextSwitchesPerSec / std::max(1, snapshot.threads);
+            if (switchesPerCpu >= 50000.0) {
+                add.warn(Problem::FrequentContextSwitches, switchesPerCpu);
+            }
+            if (snapshot.sched.tasks > 0 && snapshot.sched.runnable > static_cast<uint32_t>(2 * std::max(1, snapshot.threads))) {
+                add.warn(Problem::LongRunQueue, snapshot.sched.runnable, snapshot.threads);
+            }
+        }
+
+        if (ram >= 85.0) {
+            add.critical(Problem::HighRam, ram);
+        } else if (ram >= 75.0) {
+            add.warn(Problem::ElevatedRam, ram);
+        }
+
+        const auto& memory = snapshot.memory;
+        if (memory.available) {
+            auto percentOf = [&memory](uint64_t bytes) { return static_cast<double>(bytes) / memory.memTotal * 100.0; };
+            if (memory.hardwareCorrupted > 0) {
+                add.critical(Problem::HardwareCorruptedMemory, static_cast<double>(memory.hardwareCorrupted));
+            }
+            if (percentOf(memory.slabUnreclaimable) >= 20.0) {
+                add.warn(Problem::LargeUnreclaimableSlab, static_cast<double>(memory.slabUnreclaimable));
+            }
+            if (percentOf(memory.dirty + memory.writeback) >= 10.0) {
+                add.warn(Problem::DirtyWriteback, static_cast<double>(memory.dirty + memory.writeback));
+            }
+            if (memory.commitLimit > 0 && memory.committed > memory.commitLimit) {
+                add.warn(Problem::MemoryOvercommitted, static_cast<double>(memory.committed) / memory.commitLimit * 100.0);
+            }
+            uint64_t hugeFreeBytes = memory.hugePagesFree * memory.hugePageSize;
+            if (memory.hugePagesTotal > 0 && percentOf(hugeFreeBytes) >= 10.0) {
+                add.warn(Problem::UnusedHugePages, static_cast<double>(hugeFreeBytes));
+            }
+        }
+        if (snapshot.ratesReady.memory) {
+            const auto& activity = snapshot.memoryActivity;
+            double swapping = activity.swapInPagesPerSec + activity.swapOutPagesPerSec;
+            if (swapping >= 1000.0) {
+                add.critical(Problem::HeavySwapping, swapping);
+            } else if (swapping >= 100.0) {
+                add.warn(Problem::ActiveSwapping, swapping);
+            }
+            if (activity.majorFaultsPerSec >= 500.0) {
+                add.warn(Problem::FrequentMajorFaults, activity.majorFaultsPerSec);
+            }
+        }
+        for (int i = 0; i < snapshot.processCount; ++i) {
+            const Metrics::ProcessEntry& process = snapshot.processes[i];
+            if (process.detailed && memory.swapTotal > 0 && process.swap >= (memory.swapTotal - memory.swapFree) / 2
+                && process.swap >= 256ull * 1024 * 1024) {
+                add.add(Severity::Warning, Problem::ProcessHoldsSwap, process.name, nullptr,
+                    process.pid, static_cast<double>(process.swap));
+            }
+        }
+
+        int uptimeDays = static_cast<int>(snapshot.uptimeSeconds / (60 * 60 * 24));
+        if (uptimeDays >= 30) {
+            add.critical(Problem::VeryLongUptime, uptimeDays);
+        } else if (uptimeDays >= 7) {
+            add.warn(Problem::LongUptime, uptimeDays);
+        }
+
+        if (tempC >= 0.0) {
+            if (tempC >= 85.0) {
+                add.critical(Problem::HighCpuTemperature, tempC);
+            } else if (tempC >= 75.0) {
+                add.warn(Problem::ElevatedCpuTemperature, tempC);
+            }
+        }
+
+        for (int i = 0; i < snapshot.mountCount; ++i) {
+            const Metrics::MountEntry& mount = snapshot.mounts[i];
+            if (mount.timedOut) {
+                add.add(Severity::Critical, Problem::MountNotResponding, mount.mountPoint, mount.device);
+                continue;
+            }
+            if (mount.failed) {
+                continue;
+            }
+            if (mount.usagePercent >= 90.0) {
+                add.add(Severity::Critical, Problem::MountAlmostFull, mount.mountPoint, nullptr, mount.usagePercent);
+            } else if (mount.usagePercent >= 80.0) {
+                add.add(Severity::Warning, Problem::MountFillingUp, mount.mountPoint, nullptr, mount.usagePercent);
+            }
+            if (mount.inodeUsagePercent >= 90.0) {
+                add.add(Severity::Critical, Problem::MountOutOfInodes, mount.mountPoint, nullptr, mount.inodeUsagePercent);
+            } else if (mount.inodeUsagePercent >= 80.0) {
+                add.add(Severity::Warning, Problem::MountInodesHigh, mount.mountPoint, nullptr, mount.inodeUsagePercent);
+            }
+        }
+
+        if (snapshot.ratesReady.disk) {
+            for (int i = 0; i < snapshot.diskCount; ++i) {
+                const Metrics::DiskEntry& dev = snapshot.disks[i];
+                int await = static_cast<int>(std::max(dev.readLatencyMs, dev.writeLatencyMs));
+                if (dev.utilization >= 90.0) {
+                    add.add(Severity::Critical, Problem::SaturatedDisk, dev.name, nullptr, dev.utilization, await);
+                } else if (dev.utilization >= 70.0 || await >= 50) {
+                    add.add(Severity::Warning, Problem::BusyDisk, dev.name, nullptr, dev.utilization, await);
+                }
+            }
+        }
+
+        if (snapshot.ratesReady.net) {
+            for (int i = 0; i < snapshot.interfaceCount; ++i) {
+                const Metrics::InterfaceEntry& iface = snapshot.interfaces[i];
+                double drops = iface.rxDropsPerSec + iface.txDropsPerSec;
+                double errors = iface.rxErrorsPerSec + iface.txErrorsPerSec;
+                if (drops > 0.0) {
+                    add.add(Severity::Warning, Problem::InterfaceDrops, iface.name, nullptr, drops);
+                }
+                if (errors > 0.0) {
+                    add.add(Severity::Warning, Problem::InterfaceErrors, iface.name, nullptr, errors);
+                }
+            }
+            const auto& tcp = snapshot.tcp;
+            if (tcp.retransPerSec >= 10.0 && tcp.retransPercent >= 5.0) {
+                add.critical(Problem::TcpRetransmitSpike, tcp.retransPercent);
+            } else if (tcp.retransPerSec >= 1.0 && tcp.retransPercent >= 1.0) {
+                add.warn(Problem::ElevatedTcpRetransmits, tcp.retransPercent);
+            }
+            if (tcp.listenOverflowsPerSec > 0.0) {
+                add.warn(Problem::ListenQueueOverflow, tcp.listenOverflowsPerSec);
+            }
+        }
+
+        if (snapshot.cgroupAvailable && snapshot.ratesReady.cgroup && snapshot.cgroupCpuLimit.limited) {
+            const auto& rates = snapshot.cgroupRates;
+            double lifetime = rates.totalPeriods
+                ? static_cast<double>(rates.totalThrottled) / rates.totalPeriods * 100.0
+                : 0.0;
+            if (rates.throttledPercent >= 25.0) {
+                add.critical(Problem::ContainerThrottled, rates.throttledPercent);
+            } else if (rates.throttledPercent > 0.0) {
+                add.warn(Problem::ContainerThrottling, rates.throttledPercent);
+            } else if (lifetime >= 5.0) {
+                add.warn(Problem::ContainerThrottledSinceStart, lifetime);
+            }
+        }
+
+        for (int i = 0; i < snapshot.sensorCount; ++i) {
+            const Metrics::SensorEntry& sensor = snapshot.sensors[i];
+            auto kind = static_cast<Sensors::Kind>(sensor.kind);
+            if (kind == Sensors::Kind::Nvme && sensor.celsius >= 70.0) {
+                add.add(sensor.celsius >= 80.0 ? Severity::Critical : Severity::Warning, Problem::HotNvme,
+                    sensor.name, nullptr, sensor.celsius);
+            } else if (kind == Sensors::Kind::Dimm && sensor.celsius >= 85.0) {
+                add.add(Severity::Warning, Problem::HotDimm, sensor.name, nullptr, sensor.celsius);
+            }
+        }
+        // The counters only ever rise, so only events since the previous sample mean it is happening now
+        if (snapshot.throttleAvailable && snapshot.ratesReady.throttle
+            && (snapshot.coreThrottlePerSec > 0.0 || snapshot.packageThrottlePerSec > 0.0)) {
+            add.warn(Problem::ThermalThrottling, snapshot.coreThrottlePerSec, snapshot.packageThrottlePerSec);
+        }
+
+        for (int i = 0; i < snapshot.anomalyCount; ++i) {
+            const Metrics::AnomalyEntry& anomaly = snapshot.anomalies[i];
+            add.add(std::fabs(anomaly.z) >= 6.0 ? Severity::Critical : Severity::Warning,
+                anomaly.z > 0 ? Problem::UnusuallyHigh : Problem::UnusuallyLow, anomaly.series, nullptr,
+                anomaly.value, anomaly.baseline, anomaly.stddev, anomaly.p50, anomaly.p95, anomaly.p99);
+        }
+    }
+
+    const char* severityName(Severity severity) {
+        return severity == Severity::Critical ? "CRITICAL" : "WARNING";
+    }
+
+    const char* problemKey(Problem problem) {
+        return kProblems[static_cast<int>(problem)].key;
+    }
+
+    const char* tip(Problem problem) {
+        return kProblems[static_cast<int>(problem)].tip;
+    }
+
+    void writeMessage(std::ostream& out, const Finding& finding) {
+        const double* v = finding.values;
+        const char* subject = finding.subject ? finding.subject : "";
+        switch (finding.problem) {
+        case Problem::HighCpu:
+            out << "High CPU usage (" << whole(v[0]) << "%)";
+            break;
+        case Problem::ElevatedCpu:
+            out << "Elevated CPU usage (" << whole(v[0]) << "%)";
+            break;
+        case Problem::SevereCpuContention:
+            out << "Severe CPU contention (run-queue wait " << whole(v[0]) << "% per CPU, 100% = one task always waiting)";
+            break;
+        case Problem::CpuContention:
+            out << "CPU contention (run-queue wait " << whole(v[0]) << "% per CPU";
+            if (v[1] >= 0.0) {
+                out << " while CPU usage is only " << whole(v[1]) << "%";
+            }
+            out << ")";
+            break;
+        case Problem::ContendedCpu:
+            out << "One CPU is contended (" << whole(v[0]) << "% run-queue wait on the worst CPU)";
+            break;
+        case Problem::FrequentContextSwitches:
+            out << "Very frequent context switches (" << whole(v[0]) << "/s per CPU)";
+            break;
+        case Problem::LongRunQueue:
+            out << "Run queue longer than the CPUs (" << whole(v[0]) << " runnable on " << whole(v[1]) << " CPUs)";
+            break;
+        case Problem::HighRam:
+            out << "High RAM usage (" << whole(v[0]) << "%)";
+            break;
+        case Problem::ElevatedRam:
+            out << "Elevated RAM usage (" << whole(v[0]) << "%)";
+            break;
+        case Problem::HardwareCorruptedMemory:
+            out << "Memory pages poisoned by hardware errors (" << megabytes(v[0]) << " MB)";
+            break;
+        case Problem::LargeUnreclaimableSlab:
+            out << "Large unreclaimable kernel slab (" << megabytes(v[0]) << " MB)";
+            break;
+        case Problem::DirtyWriteback:
+            out << "Much dirty page cache waiting for writeback (" << megabytes(v[0]) << " MB)";
+            break;
+        case Problem::MemoryOvercommitted:
+            out << "Memory overcommitted (" << whole(v[0]) << "% of commit limit)";
+            break;
+        case Problem::UnusedHugePages:
+            out << "Reserved huge pages unused (" << megabytes(v[0]) << " MB)";
+            break;
+        case Problem::HeavySwapping:
+            out << "Heavy swapping (" << whole(v[0]) << " pages/s)";
+            break;
+        case Problem::ActiveSwapping:
+            out << "Active swapping (" << whole(v[0]) << " pages/s)";
+            break;
+        case Problem::FrequentMajorFaults:
+            out << "Frequent major page faults (" << whole(v[0]) << "/s)";
+            break;
+        case Problem::ProcessHoldsSwap:
+            out << "Process " << whole(v[0]) << " " << subject << " holds most of the used swap ("
+                << megabytes(v[1]) << " MB)";
+            break;
+        case Problem::VeryLongUptime:
+        case Problem::LongUptime:
+            out << "Long uptime (" << whole(v[0]) << " days)";
+            break;
+        case Problem::HighCpuTemperature:
+            out << "High CPU temperature (" << whole(v[0]) << " C)";
+            break;
+        case Problem::ElevatedCpuTemperature:
+            out << "Elevated CPU temperature (" << whole(v[0]) << " C)";
+            break;
+        case Problem::MountNotResponding:
+            out << "Mount " << subject << " not responding";
+            if (finding.device) {
+                out << " (device " << finding.device << ")";
+            }
+            break;
+        case Problem::MountAlmostFull:
+            out << "Mount " << subject << " almost full (" << whole(v[0]) << "%)";
+            break;
+        case Problem::MountFillingUp:
+            out << "Mount " << subject << " filling up (" << whole(v[0]) << "%)";
+            break;
+        case Problem::MountOutOfInodes:
+            out << "Mount " << subject << " running out of inodes (" << whole(v[0]) << "%)";
+            break;
+        case Problem::MountInodesHigh:
+            out << "Mount " << subject << " inode usage high (" << whole(v[0]) << "%)";
+            break;
+        case Problem::SaturatedDisk:
+            out << "Saturated disk (" << subject << " " << whole(v[0]) << "% busy, await " << whole(v[1]) << " ms)";
+            break;
+        case Problem::BusyDisk:
+            out << "Busy disk (" << subject << " " << whole(v[0]) << "% busy, await " << whole(v[1]) << " ms)";
+            break;
+        case Problem::InterfaceDrops:
+            out << "Interface " << subject << " dropping packets (" << whole(std::ceil(v[0])) << "/s)";
+            break;
+        case Problem::InterfaceErrors:
+            out << "Interface " << subject << " reporting errors (" << whole(std::ceil(v[0])) << "/s)";
+            break;
+        case Problem::TcpRetransmitSpike:
+            out << "TCP retransmit spike (" << whole(v[0]) << "% of segments)";
+            break;
+        case Problem::ElevatedTcpRetransmits:
+            out << "Elevated TCP retransmits (" << whole(v[0]) << "% of segments)";
+            break;
+        case Problem::ListenQueueOverflow:
+            out << "TCP listen queue overflowing";
+            break;
+        case Problem::ContainerThrottled:
+            out << "Container CPU throttled (" << whole(v[0]) << "% of periods)";
+            break;
+        case Problem::ContainerThrottling:
+            out << "Container CPU throttling (" << whole(v[0]) << "% of periods)";
+            break;
+        case Problem::ContainerThrottledSinceStart:
+            out << "Container CPU throttled in " << whole(v[0]) << "% of periods since start";
+            break;
+        case Problem::HotNvme:
+            out << "Hot NVMe drive (" << subject << " " << whole(v[0]) << " C)";
+            break;
+        case Problem::HotDimm:
+            out << "Hot memory module (" << subject << " " << whole(v[0]) << " C)";
+            break;
+        case Problem::ThermalThrottling:
+            out << "CPU thermal throttling (" << whole(std::ceil(v[0])) << " core, "
+                << whole(std::ceil(v[1])) << " package events/s)";
+            break;
+        case Problem::UnusuallyHigh:
+        case Problem::UnusuallyLow: {
+            std::ios_base::fmtflags flags = out.flags();
+            std::streamsize precision = out.precision();
+            out << (finding.problem == Problem::UnusuallyHigh ? "Unusually high " : "Unusually low ")
+                << std::fixed << std::setprecision(1) << subject << " at " << v[0]
+                << ", baseline " << v[1] << " +/- " << v[2]
+                << ", p50/p95/p99 " << v[3] << "/" << v[4] << "/" << v[5];
+            out.flags(flags);
+            out.precision(precision);
+            break;
+        }
+        case Problem::Count:
+            break;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include "snapshot.h"
+
+// Scan namespace encapsulating the rule-based problem scan of a snapshot. Findings
+// are codes and numbers; text is only produced when a finding is written out, so a
+// scan allocates nothing and can run on every publisher or export cycle.
+namespace Scan {
+
+    enum class Severity : uint8_t {
+        Warning,
+        Critical
+    };
+
+    // One code per rule; each has a fixed message template and tip
+    enum class Problem : uint8_t {
+        HighCpu,
+        ElevatedCpu,
+        SevereCpuContention,
+        CpuContention,
+        ContendedCpu,
+        FrequentContextSwitches,
+        LongRunQueue,
+        HighRam,
+        ElevatedRam,
+        HardwareCorruptedMemory,
+        LargeUnreclaimableSlab,
+        DirtyWriteback,
+        MemoryOvercommitted,
+        UnusedHugePages,
+        HeavySwapping,
+        ActiveSwapping,
+        FrequentMajorFaults,
+        ProcessHoldsSwap,
+        VeryLongUptime,
+        LongUptime,
+        HighCpuTemperature,
+        ElevatedCpuTemperature,
+        MountNotResponding,
+        MountAlmostFull,
+        MountFillingUp,
+        MountOutOfInodes,
+        MountInodesHigh,
+        SaturatedDisk,
+        BusyDisk,
+        InterfaceDrops,
+        InterfaceErrors,
+        TcpRetransmitSpike,
+        ElevatedTcpRetransmits,
+        ListenQueueOverflow,
+        ContainerThrottled,
+        ContainerThrottling,
+        ContainerThrottledSinceStart,
+        HotNvme,
+        HotDimm,
+        ThermalThrottling,
+        UnusuallyHigh,
+        UnusuallyLow,
+        Count
+    };
+
+    // Enough for every rule to fire on every table entry of a full snapshot
+    constexpr int kMaxFindings = 256;
+    constexpr int kMaxValues = 6;
+
+    // One fired rule. subject and device point into the scanned snapshot (a mount
+    // point, disk, interface, sensor, process or series name), so a Finding must not
+    // outlive it. values are the numbers the message quotes, in template order.
+    struct Finding {
+        Problem problem;
+        Severity severity;
+        const char* subject;
+        const char* device;
+        double values[kMaxValues];
+    };
+
+    struct Result {
+        Finding findings[kMaxFindings];
+        int count = 0;
+        int dropped = 0;            // Findings beyond kMaxFindings
+    };
+
+    // Runs every rule against the snapshot. Smoothed CPU and RAM usage are used when a
+    // long-running collector has history, so one short spike is not an alert.
+    void scan(const Metrics::Snapshot& snapshot, Result& result);
+
+    // "WARNING" or "CRITICAL"
+    const char* severityName(Severity severity);
+
+    // Short identifier for machine-readable output, e.g. "mount_almost_full"
+    const char* problemKey(Problem problem);
+
+    // Suggested next step for a problem
+    const char* tip(Problem problem);
+
+    // Writes the human-readable message of a finding, e.g. "Mount /var almost full (93%)"
+    void writeMessage(std::ostream& out, const Finding& finding);
+}
@@ -0,0 +1,115 @@
+// schedStats.cpp scheduler contention collector implementation
+#include "schedStats.h"
+#include "procfs.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SchedStats {
+    bool Sampler::sample() {
+#ifdef _WIN32
+        return false;
+#else
+        if (!ProcFS::readSource("/proc/stat", buffer)) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double seconds = samples > 0 ? std::chrono::duration<double>(now - lastSample).count() : 0.0;
+
+        uint64_t contextSwitches = 0;
+        uint64_t interrupts = 0;
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            const char* value = p;
+            if (std::strncmp(p, "ctxt ", 5) == 0) {
+                value += 5;
+                contextSwitches = ProcFS::parseU64(value, eol);
+            } else if (std::strncmp(p, "intr ", 5) == 0) {
+                value += 5;
+                interrupts = ProcFS::parseU64(value, eol);     // The total; per-line counts follow
+            } else if (std::strncmp(p, "procs_blocked ", 14) == 0) {
+                value += 14;
+                current.blocked = static_cast<uint32_t>(ProcFS::parseU64(value, eol));
+            }
+            p = eol + 1;
+        }
+        if (seconds > 0.0) {
+            current.contextSwitchesPerSec = static_cast<double>(ProcFS::delta(contextSwitches, previousContextSwitches)) / seconds;
+            current.interruptsPerSec = static_cast<double>(ProcFS::delta(interrupts, previousInterrupts)) / seconds;
+        }
+        previousContextSwitches = contextSwitches;
+        previousInterrupts = interrupts;
+
+        // Fourth field is "runnable/total"
+        if (ProcFS::readSource("/proc/loadavg", buffer)) {
+            p = buffer.data();
+            end = p + buffer.size();
+            for (int field = 0; field < 3; ++field) {
+                ProcFS::parseToken(p, end);
+            }
+            current.runnable = static_cast<uint32_t>(ProcFS::parseU64(p, end));
+            if (p < end && *p == '/') {
+                ++p;
+                current.tasks = static_cast<uint32_t>(ProcFS::parseU64(p, end));
+            }
+        }
+
+        sampleSchedstat(seconds);
+        lastSample = now;
+        ++samples;
+        return true;
+#endif
+    }
+
+    void Sampler::sampleSchedstat(double seconds) {
+        if (!ProcFS::readSource("/proc/schedstat", buffer)) {
+            current.schedstatAvailable = false;
+            return;
+        }
+        // "cpuN" lines carry nine counters; the last three are time spent running,
+        // time spent runnable but waiting (both ns) and timeslices run. Domain lines
+        // and the version/timestamp header are skipped.
+        std::vector<CpuCounters>& cpus = latestCpus;
+        cpus.clear();
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        while (p < end) {
+            const char* eol = ProcFS::lineEnd(p, end);
+            if (eol - p > 3 && std::strncmp(p, "cpu", 3) == 0 && p[3] >= '0' && p[3] <= '9') {
+                const char* field = p;
+                ProcFS::parseToken(field, eol);
+                uint64_t counters[9] = {};
+                int parsed = 0;
+                while (parsed < 9 && field < eol) {
+                    counters[parsed++] = ProcFS::parseU64(field, eol);
+                }
+                if (parsed == 9) {
+                    cpus.push_back(CpuCounters{ counters[7], counters[8] });
+                }
+            }
+            p = eol + 1;
+        }
+        current.schedstatAvailable = !cpus.empty();
+        current.cpus = static_cast<int32_t>(cpus.size());
+
+        // CPUs coming online or going offline change the list; rates resume next sample
+        if (seconds > 0.0 && cpus.size() == previousCpus.size() && !cpus.empty()) {
+            uint64_t totalWait = 0;
+            uint64_t totalSlices = 0;
+            double worst = 0.0;
+            for (size_t i = 0; i < cpus.size(); ++i) {
+                uint64_t wait = ProcFS::delta(cpus[i].waitNs, previousCpus[i].waitNs);
+                totalWait += wait;
+                totalSlices += ProcFS::delta(cpus[i].timeslices, previousCpus[i].timeslices);
+                worst = std::max(worst, static_cast<double>(wait) / (seconds * 1e9) * 100.0);
+            }
+            current.runQueueWaitPercent = static_cast<double>(totalWait) / (seconds * 1e9 * cpus.size()) * 100.0;
+            current.maxCpuWaitPercent = worst;
+            current.timeslicesPerSec = static_cast<double>(totalSlices) / seconds;
+            current.waitPerSliceMs = totalSlices > 0 ? static_cast<double>(totalWait) / totalSlices / 1e6 : 0.0;
+        }
+        previousCpus.swap(latestCpus);
+    }
+}
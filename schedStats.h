@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// SchedStats namespace encapsulating CPU contention: how long runnable tasks wait for
+// a CPU (/proc/schedstat), how many are runnable (/proc/loadavg) and how often
+// the scheduler and interrupts switch work (/proc/stat)
+namespace SchedStats {
+
+    // Rates between two samples, plus the current task counts
+    struct Rates {
+        bool schedstatAvailable = false;    // Needs CONFIG_SCHEDSTATS; the wait fields stay zero without it
+        int32_t cpus = 0;
+        // Summed time tasks spent runnable but waiting, per CPU second, in percent: the mean
+        // number of waiting tasks per CPU x100. 100 % is one task always waiting on every
+        // CPU; several queued tasks take it past 100 %.
+        double runQueueWaitPercent = 0.0;
+        double maxCpuWaitPercent = 0.0;     // The same for the most contended CPU
+        double waitPerSliceMs = 0.0;        // Mean wait before a task got its timeslice
+        double timeslicesPerSec = 0.0;
+        double contextSwitchesPerSec = 0.0;
+        double interruptsPerSec = 0.0;
+        uint32_t runnable = 0;              // Running or queued right now
+        uint32_t tasks = 0;                 // All threads on the system
+        uint32_t blocked = 0;               // In uninterruptible sleep, usually on I/O
+    };
+
+    // Reads /proc/schedstat, /proc/stat and /proc/loadavg (one read each per sample)
+    // and reports the rates against the previous sample
+    class Sampler {
+    public:
+        // Returns false if /proc/stat is unavailable
+        bool sample();
+
+        // True once two samples have been taken and the rates are meaningful
+        bool ready() const { return samples >= 2; }
+
+        const Rates& rates() const { return current; }
+
+    private:
+        // Cumulative per-CPU counters, in nanoseconds and timeslices
+        struct CpuCounters {
+            uint64_t waitNs = 0;
+            uint64_t timeslices = 0;
+        };
+
+        Rates current;
+        std::vector<CpuCounters> previousCpus;
+        std::vector<CpuCounters> latestCpus;      // Reused each sample, then swapped with previousCpus
+        uint64_t previousContextSwitches = 0;
+        uint64_t previousInterrupts = 0;
+        std::string buffer;
+        std::chrono::steady_clock::time_point lastSample;
+        int samples = 0;
+
+        void sampleSchedstat(double seconds);
+    };
+}
@@ -0,0 +1,101 @@
+// scheduler.cpp timer wheel implementation
+#include "scheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace Scheduler {
+    TimerWheel::TimerWheel(int tickMs, int slotCount)
+        : tickLength(std::chrono::milliseconds(std::max(1, tickMs))),
+          start(Clock::now()),
+          slots(static_cast<size_t>(std::max(1, slotCount))) {
+    }
+
+    void TimerWheel::add(const std::string& name, int periodMs, int budgetMs, std::function<void()> task) {
+        Task entry;
+        entry.run = std::move(task);
+        auto tickMs = std::chrono::duration_cast<std::chrono::milliseconds>(tickLength).count();
+        // Periods round up to whole ticks; anything shorter than a tick runs every tick
+        entry.periodTicks = periodMs > 0 ? std::max<uint64_t>(1, (periodMs + tickMs - 1) / tickMs) : 0;
+        entry.deadline = current + 1;
+        entry.stats.name = name;
+        entry.stats.periodMs = std::max(0, periodMs);
+        entry.stats.budgetMs = std::max(0, budgetMs);
+        tasks.push_back(std::move(entry));
+        schedule(tasks.size() - 1);
+    }
+
+    void TimerWheel::schedule(size_t index) {
+        slots[tasks[index].deadline % slots.size()].push_back(index);
+    }
+
+    int TimerWheel::runSlot(uint64_t tickNumber) {
+        // Tasks further than one revolution away share the slot and stay put
+        std::vector<size_t>& slot = slots[tickNumber % slots.size()];
+        due.clear();
+        for (size_t i = 0; i < slot.size();) {
+            if (tasks[slot[i]].deadline <= tickNumber) {
+                due.push_back(slot[i]);
+                slot[i] = slot.back();
+                slot.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        // Registration order, so a run-once task added first always runs first
+        std::sort(due.begin(), due.end());
+
+        for (size_t index : due) {
+            Task& task = tasks[index];
+            auto began = Clock::now();
+            task.run();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - began).count();
+
+            TaskStats& stats = task.stats;
+            ++stats.runs;
+            stats.lastMs = ms;
+            stats.maxMs = std::max(stats.maxMs, ms);
+            stats.totalMs += ms;
+            if (stats.budgetMs > 0 && ms > stats.budgetMs) {
+                ++stats.overruns;
+            }
+            if (task.periodTicks == 0) {
+                continue;
+            }
+            task.deadline += task.periodTicks;
+            // If the loop is now a whole period behind, drop the missed deadlines
+            // instead of running the task back to back to catch up
+            uint64_t now = static_cast<uint64_t>((Clock::now() - start) / tickLength);
+            if (task.deadline <= now) {
+                uint64_t behind = (now - task.deadline) / task.periodTicks + 1;
+                stats.skipped += behind;
+                task.deadline += behind * task.periodTicks;
+            }
+            schedule(index);
+        }
+        return static_cast<int>(due.size());
+    }
+
+    int TimerWheel::tick() {
+        uint64_t target = current + 1;
+        std::this_thread::sleep_until(start + tickLength * target);
+        // A slow task may have pushed the clock past several ticks; visit each
+        // slot in turn so nothing due in between is missed
+        uint64_t now = static_cast<uint64_t>((Clock::now() - start) / tickLength);
+        int ran = 0;
+        while (current < std::max(target, now)) {
+            ++current;
+            ran += runSlot(current);
+        }
+        return ran;
+    }
+
+    std::vector<TaskStats> TimerWheel::stats() const {
+        std::vector<TaskStats> result;
+        result.reserve(tasks.size());
+        for (const auto& task : tasks) {
+            result.push_back(task.stats);
+        }
+        return result;
+    }
+}
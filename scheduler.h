@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Scheduler namespace encapsulating a single-threaded timer wheel that runs
+// collectors at their own periods and accounts for the time they take
+namespace Scheduler {
+    using Clock = std::chrono::steady_clock;
+
+    struct TaskStats {
+        std::string name;
+        int periodMs = 0;         // 0 for run-once tasks
+        int budgetMs = 0;
+        uint64_t runs = 0;
+        uint64_t overruns = 0;    // Runs that took longer than the budget
+        uint64_t skipped = 0;     // Deadlines dropped because the loop fell a full period behind
+        double lastMs = 0.0;
+        double maxMs = 0.0;
+        double totalMs = 0.0;
+    };
+
+    // Hashed timer wheel. Deadlines are absolute tick numbers advanced by the
+    // task period from the previous deadline, never from when a run finished,
+    // so the time a collector takes does not shift its schedule.
+    class TimerWheel {
+    public:
+        explicit TimerWheel(int tickMs = 50, int slotCount = 64);
+
+        // Registers a task whose first run is on the next tick. A period of 0 runs it once.
+        void add(const std::string& name, int periodMs, int budgetMs, std::function<void()> task);
+
+        // Waits for the next tick and runs every task due on it. Catches up on
+        // ticks missed while a slow task ran. Returns the number of tasks run.
+        int tick();
+
+        std::vector<TaskStats> stats() const;
+
+    private:
+        struct Task {
+            std::function<void()> run;
+            uint64_t periodTicks = 0;
+            uint64_t deadline = 0;
+            TaskStats stats;
+        };
+
+        Clock::duration tickLength;
+        Clock::time_point start;
+        uint64_t current = 0;
+        std::vector<Task> tasks;
+        std::vector<std::vector<size_t>> slots;
+        std::vector<size_t> due;
+
+        void schedule(size_t index);
+        int runSlot(uint64_t tickNumber);
+    };
+}
@@ -0,0 +1,283 @@
+// sensors.cpp thermal sensor discovery and refresh implementation
+#include "sensors.h"
+#include "procfs.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <filesystem>     // For walking /sys/class/thermal and /sys/class/hwmon
+#include <fstream>        // For reading sensor names and labels
+#include <iterator>       // For std::istreambuf_iterator
+#include <set>            // For keeping one throttle counter per core and package
+#include <fcntl.h>       // For open
+#include <unistd.h>     // For pread and close
+#endif
+
+namespace Sensors {
+namespace {
+#ifndef _WIN32
+    // Paths come from walking directories under the ProcFS root, so they are read as they are
+    std::string readText(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+            text.pop_back();
+        }
+        return text;
+    }
+
+    bool startsWith(const std::string& text, const char* prefix) {
+        return text.rfind(prefix, 0) == 0;
+    }
+
+    // Reads a whole small sysfs attribute from the start with one pread
+    bool preadValue(int fd, long& value) {
+        char buffer[32];
+        ssize_t count = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        if (count <= 0) {
+            return false;
+        }
+        buffer[count] = '\0';
+        char* end = nullptr;
+        value = std::strtol(buffer, &end, 10);
+        return end != buffer;
+    }
+
+    Kind classifyZone(const std::string& type) {
+        if (type == "x86_pkg_temp" || startsWith(type, "cpu") || startsWith(type, "soc")) {
+            return Kind::CpuPackage;
+        }
+        if (startsWith(type, "acpitz")) {
+            return Kind::Acpi;
+        }
+        if (startsWith(type, "nvme")) {
+            return Kind::Nvme;
+        }
+        return Kind::Other;
+    }
+
+    Kind classifyHwmon(const std::string& chip, const std::string& label) {
+        if (chip == "coretemp") {
+            return startsWith(label, "Core") ? Kind::CpuCore : Kind::CpuPackage;
+        }
+        if (chip == "k10temp" || chip == "zenpower") {
+            return startsWith(label, "Tccd") ? Kind::CpuCore : Kind::CpuPackage;
+        }
+        if (chip == "cpu_thermal" || chip == "cpu-thermal") {
+            return Kind::CpuPackage;
+        }
+        if (chip == "nvme") {
+            return Kind::Nvme;
+        }
+        if (chip == "jc42" || chip == "spd5118" || startsWith(chip, "ee1004")) {
+            return Kind::Dimm;
+        }
+        if (chip == "acpitz") {
+            return Kind::Acpi;
+        }
+        return Kind::Other;
+    }
+#endif
+} // namespace
+
+    const char* kindName(Kind kind) {
+        switch (kind) {
+            case Kind::CpuPackage: return "CPU package";
+            case Kind::CpuCore:    return "CPU core";
+            case Kind::Nvme:       return "NVMe";
+            case Kind::Dimm:       return "DIMM";
+            case Kind::Acpi:       return "ACPI";
+            default:               return "Other";
+        }
+    }
+
+    Registry& Registry::instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    Registry::Registry() {
+        discoverThermalZones();
+        discoverHwmon();
+        discoverThrottle();
+    }
+
+    Registry::~Registry() {
+#ifndef _WIN32
+        for (int fd : sensorFds) {
+            close(fd);
+        }
+        for (int fd : coreThrottleFds) {
+            close(fd);
+        }
+        for (int fd : packageThrottleFds) {
+            close(fd);
+        }
+#endif
+    }
+
+    void Registry::discoverThermalZones() {
+#ifndef _WIN32
+        std::error_code ec;
+        std::vector<std::filesystem::path> zones;
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/sys/class/thermal"), ec)) {
+            if (startsWith(entry.path().filename().string(), "thermal_zone")) {
+                zones.push_back(entry.path());
+            }
+        }
+        std::sort(zones.begin(), zones.end());
+        for (const auto& zone : zones) {
+            int fd = open((zone / "temp").c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            std::string type = readText(zone / "type");
+            Sensor sensor;
+            sensor.name = zone.filename().string() + "/" + (type.empty() ? "unknown" : type);
+            sensor.kind = classifyZone(type);
+            sensors.push_back(sensor);
+            sensorFds.push_back(fd);
+        }
+#endif
+    }
+
+    void Registry::discoverHwmon() {
+#ifndef _WIN32
+        std::error_code ec;
+        std::vector<std::filesystem::path> chips;
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/sys/class/hwmon"), ec)) {
+            chips.push_back(entry.path());
+        }
+        std::sort(chips.begin(), chips.end());
+        for (const auto& chipDir : chips) {
+            std::string chip = readText(chipDir / "name");
+            std::vector<std::filesystem::path> inputs;
+            for (const auto& entry : std::filesystem::directory_iterator(chipDir, ec)) {
+                std::string file = entry.path().filename().string();
+                if (startsWith(file, "temp") && file.size() > 6 && file.compare(file.size() - 6, 6, "_input") == 0) {
+                    inputs.push_back(entry.path());
+                }
+            }
+            std::sort(inputs.begin(), inputs.end());
+            for (const auto& input : inputs) {
+                int fd = open(input.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    continue;
+                }
+                std::string base = input.filename().string();
+                base = base.substr(0, base.size() - 6);
+                std::string label = readText(chipDir / (base + "_label"));
+                Sensor sensor;
+                sensor.name = (chip.empty() ? chipDir.filename().string() : chip) + "/" + (label.empty() ? base : label);
+                sensor.kind = classifyHwmon(chip, label);
+                sensors.push_back(sensor);
+                sensorFds.push_back(fd);
+            }
+        }
+#endif
+    }
+
+    void Registry::discoverThrottle() {
+#ifndef _WIN32
+        // Core counters are shared by SMT siblings and package counters by every CPU
+        // in the package, so only the first CPU of each core and package is kept
+        std::set<std::pair<long, long>> cores;
+        std::set<long> packages;
+        std::error_code ec;
+        std::vector<std::filesystem::path> cpus;
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/sys/devices/system/cpu"), ec)) {
+            std::string name = entry.path().filename().string();
+            if (startsWith(name, "cpu") && name.size() >= 4 && name[3] >= '0' && name[3] <= '9') {
+                cpus.push_back(entry.path());
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        for (const auto& cpu : cpus) {
+            // Without topology every CPU counts as its own core and package
+            long fallback = std::strtol(cpu.filename().string().c_str() + 3, nullptr, 10);
+            std::string package = readText(cpu / "topology" / "physical_package_id");
+            std::string core = readText(cpu / "topology" / "core_id");
+            long packageId = package.empty() ? fallback : std::strtol(package.c_str(), nullptr, 10);
+            long coreId = core.empty() ? fallback : std::strtol(core.c_str(), nullptr, 10);
+
+            auto dir = cpu / "thermal_throttle";
+            if (cores.insert({ packageId, coreId }).second) {
+                int coreFd = open((dir / "core_throttle_count").c_str(), O_RDONLY | O_CLOEXEC);
+                if (coreFd >= 0) {
+                    coreThrottleFds.push_back(coreFd);
+                }
+            }
+            if (packages.insert(packageId).second) {
+                int packageFd = open((dir / "package_throttle_count").c_str(), O_RDONLY | O_CLOEXEC);
+                if (packageFd >= 0) {
+                    packageThrottleFds.push_back(packageFd);
+                }
+            }
+        }
+#endif
+    }
+
+    std::vector<Sensor> Registry::refresh() {
+        std::lock_guard<std::mutex> guard(lock);
+#ifndef _WIN32
+        for (size_t i = 0; i < sensors.size(); ++i) {
+            long milliC = 0;
+            sensors[i].celsius = preadValue(sensorFds[i], milliC) ? milliC / 1000.0 : -1.0;
+        }
+#endif
+        return sensors;
+    }
+
+    Throttle Registry::throttle() {
+        std::lock_guard<std::mutex> guard(lock);
+        Throttle counts;
+#ifndef _WIN32
+        long value = 0;
+        for (int fd : coreThrottleFds) {
+            if (preadValue(fd, value) && value > 0) {
+                counts.coreEvents += static_cast<uint64_t>(value);
+            }
+        }
+        for (int fd : packageThrottleFds) {
+            if (preadValue(fd, value) && value > 0) {
+                counts.packageEvents += static_cast<uint64_t>(value);
+            }
+        }
+        counts.available = !coreThrottleFds.empty() || !packageThrottleFds.empty();
+#endif
+        return counts;
+    }
+
+    Throttle ThrottleSampler::sample() {
+        Throttle counts = Registry::instance().throttle();
+        auto now = std::chrono::steady_clock::now();
+        if (counts.available && samples > 0) {
+            double seconds = std::chrono::duration<double>(now - lastSample).count();
+            if (seconds > 0.0) {
+                current.corePerSec = ProcFS::delta(counts.coreEvents, previous.coreEvents) / seconds;
+                current.packagePerSec = ProcFS::delta(counts.packageEvents, previous.packageEvents) / seconds;
+            }
+        }
+        if (counts.available) {
+            previous = counts;
+            lastSample = now;
+            ++samples;
+        }
+        return counts;
+    }
+
+    double cpuTemperature(const std::vector<Sensor>& readings) {
+        double hottest = -1.0;
+        double zone0 = -1.0;
+        for (const auto& sensor : readings) {
+            if (sensor.kind == Kind::CpuPackage || sensor.kind == Kind::CpuCore) {
+                hottest = std::max(hottest, sensor.celsius);
+            } else if (sensor.name.rfind("thermal_zone0/", 0) == 0) {
+                zone0 = sensor.celsius;
+            }
+        }
+        // Prefer sensors classified as CPU package or core; zone0 is often an ACPI zone
+        return hottest >= 0.0 ? hottest : zone0;
+    }
+}
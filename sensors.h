@@ -0,0 +1,97 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Sensors namespace encapsulating thermal zone and hwmon temperature sensors
+namespace Sensors {
+
+    enum class Kind {
+        CpuPackage,
+        CpuCore,
+        Nvme,
+        Dimm,
+        Acpi,
+        Other
+    };
+
+    // Returns a short display name for a sensor kind
+    const char* kindName(Kind kind);
+
+    struct Sensor {
+        std::string name;       // Source and label, e.g. "coretemp/Package id 0"
+        Kind kind = Kind::Other;
+        double celsius = -1.0;  // Last reading, -1.0 if it could not be read
+    };
+
+    // Thermal throttle events since boot, summed once per physical core and once per package
+    struct Throttle {
+        bool available = false;
+        uint64_t coreEvents = 0;
+        uint64_t packageEvents = 0;
+    };
+
+    // Throttle events per second between two samples
+    struct ThrottleRates {
+        double corePerSec = 0.0;
+        double packagePerSec = 0.0;
+    };
+
+    // Samples the registry's throttle counters and reports the rates against the
+    // previous sample, so a counter that stopped rising long ago reads as zero
+    class ThrottleSampler {
+    public:
+        // Returns the counters read by this sample
+        Throttle sample();
+
+        // True once two samples have been taken and the rates are meaningful
+        bool ready() const { return samples >= 2; }
+
+        const ThrottleRates& rates() const { return current; }
+
+    private:
+        ThrottleRates current;
+        Throttle previous;
+        std::chrono::steady_clock::time_point lastSample;
+        int samples = 0;
+    };
+
+    // CPU temperature from one set of readings: the hottest CPU package or core,
+    // else thermal_zone0, else -1.0
+    double cpuTemperature(const std::vector<Sensor>& readings);
+
+    // Discovers thermal_zone*, hwmon* and thermal_throttle files under the ProcFS
+    // root once, keeps their descriptors open and refreshes readings with pread on
+    // the cached fds.
+    class Registry {
+    public:
+        // Process-wide registry; discovery runs on first use
+        static Registry& instance();
+
+        // Discovers the sensors under the current ProcFS root; collectors use instance()
+        Registry();
+        ~Registry();
+
+        // Re-reads every sensor and returns a copy of the readings
+        std::vector<Sensor> refresh();
+
+        // Re-reads the throttle counters
+        Throttle throttle();
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+    private:
+        void discoverThermalZones();
+        void discoverHwmon();
+        void discoverThrottle();
+
+        std::mutex lock;
+        std::vector<Sensor> sensors;
+        std::vector<int> sensorFds;
+        std::vector<int> coreThrottleFds;
+        std::vector<int> packageThrottleFds;
+    };
+}
@@ -0,0 +1,241 @@
+// sharedMetrics.cpp shared-memory snapshot segment with a seqlock
+#include "sharedMetrics.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>        // For O_* constants
+#include <sys/file.h>    // For flock
+#include <sys/mman.h>    // For shm_open and mmap
+#include <sys/stat.h>    // For fstat
+#include <unistd.h>     // For ftruncate and close
+#endif
+
+namespace SharedMetrics {
+    constexpr uint32_t kMagic = 0x4D544953;     // "SITM"
+    constexpr int kReadAttempts = 64;
+    constexpr int kYieldAttempts = 16;          // Then sleep, in case the publisher was preempted mid-write
+
+    // Waits before retrying a torn read, giving the publisher a chance to finish its write
+    static void backOff(int attempt) {
+        if (attempt < kYieldAttempts) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    // Segment layout. The sequence is odd while a write is in progress; a reader
+    // accepts a copy only if it saw the same even sequence before and after it.
+    struct Segment {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t snapshotSize;
+        uint32_t reserved;
+        std::atomic<uint64_t> sequence;
+        Metrics::Snapshot snapshot;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Seqlock counter must be lock free");
+
+#ifndef _WIN32
+    constexpr int kOpenAttempts = 3;
+
+    // True if name still refers to the segment open on fd
+    static bool isLinked(const std::string& name, int fd) {
+        int current = shm_open(name.c_str(), O_RDONLY, 0);
+        if (current < 0) {
+            return false;
+        }
+        struct stat held;
+        struct stat linked;
+        bool same = fstat(fd, &held) == 0 && fstat(current, &linked) == 0
+            && held.st_dev == linked.st_dev && held.st_ino == linked.st_ino;
+        close(current);
+        return same;
+    }
+#endif
+
+    Publisher::~Publisher() {
+#ifndef _WIN32
+        if (segment) {
+            munmap(segment, sizeof(Segment));
+            // Unlinked while still locked, so a publisher starting now creates a fresh segment
+            shm_unlink(segmentName.c_str());
+        }
+        if (lockFd >= 0) {
+            close(lockFd);
+        }
+#endif
+    }
+
+    bool Publisher::open(const std::string& name, std::string* error) {
+#ifdef _WIN32
+        (void)name;
+        if (error) {
+            *error = "Shared memory publishing is only supported on POSIX systems.";
+        }
+        return false;
+#else
+        int fd = -1;
+        for (int attempt = 0; fd < 0 && attempt < kOpenAttempts; ++attempt) {
+            fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+            if (fd < 0) {
+                if (error) {
+                    *error = "Unable to create shared memory segment " + name + ": " + std::strerror(errno);
+                }
+                return false;
+            }
+            // Held until the descriptor is closed, so a crashed publisher releases it
+            if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+                int lockError = errno;
+                close(fd);
+                if (error) {
+                    *error = lockError == EWOULDBLOCK
+                        ? "Metrics are already published at " + name + " by another process."
+                        : "Unable to lock shared memory segment " + name + ": " + std::strerror(lockError);
+                }
+                return false;
+            }
+            // A publisher that was exiting may have unlinked the segment before releasing it
+            if (!isLinked(name, fd)) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        if (fd < 0) {
+            if (error) {
+                *error = "Shared memory segment " + name + " kept being replaced while opening it.";
+            }
+            return false;
+        }
+        if (ftruncate(fd, sizeof(Segment)) != 0) {
+            if (error) {
+                *error = "Unable to size shared memory segment: " + std::string(std::strerror(errno));
+            }
+            close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            if (error) {
+                *error = "Unable to map shared memory segment: " + std::string(std::strerror(errno));
+            }
+            close(fd);
+            return false;
+        }
+        segment = static_cast<Segment*>(mapped);
+        lockFd = fd;
+        segmentName = name;
+        // Readers reject the segment until the header is complete and a snapshot is published
+        segment->magic = 0;
+        segment->version = kLayoutVersion;
+        segment->snapshotSize = sizeof(Metrics::Snapshot);
+        segment->reserved = 0;
+        segment->sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = kMagic;
+        return true;
+#endif
+    }
+
+    void Publisher::publish(const Metrics::Snapshot& snapshot) {
+        if (!segment) {
+            return;
+        }
+        uint64_t sequence = segment->sequence.load(std::memory_order_relaxed);
+        segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&segment->snapshot, &snapshot, sizeof(Metrics::Snapshot));
+        segment->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    Reader::~Reader() {
+#ifndef _WIN32
+        if (segment) {
+            munmap(const_cast<Segment*>(segment), sizeof(Segment));
+        }
+#endif
+    }
+
+    bool Reader::open(const std::string& name, std::string* error) {
+#ifdef _WIN32
+        (void)name;
+        if (error) {
+            *error = "Shared memory snapshots are only supported on POSIX systems.";
+        }
+        return false;
+#else
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            if (error) {
+                *error = "No published metrics at " + name + ". Start 'sysinfo publish' first.";
+            }
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Segment)) {
+            close(fd);
+            if (error) {
+                *error = "Shared memory segment " + name + " has an incompatible size.";
+            }
+            return false;
+        }
+        void* mapped = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            if (error) {
+                *error = "Unable to map shared memory segment: " + std::string(std::strerror(errno));
+            }
+            return false;
+        }
+        segment = static_cast<const Segment*>(mapped);
+        if (segment->magic != kMagic || segment->version != kLayoutVersion
+            || segment->snapshotSize != sizeof(Metrics::Snapshot)) {
+            munmap(mapped, sizeof(Segment));
+            segment = nullptr;
+            if (error) {
+                *error = "Shared memory segment " + name + " was written by an incompatible version.";
+            }
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    bool Reader::read(Metrics::Snapshot& snapshot, std::string* error) const {
+        if (!segment) {
+            if (error) {
+                *error = "Shared memory segment is not open.";
+            }
+            return false;
+        }
+        for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+            uint64_t before = segment->sequence.load(std::memory_order_acquire);
+            if (before == 0) {
+                if (error) {
+                    *error = "The publisher has not written a snapshot yet.";
+                }
+                return false;
+            }
+            if (before & 1) {
+                backOff(attempt);
+                continue;
+            }
+            std::memcpy(&snapshot, &segment->snapshot, sizeof(Metrics::Snapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment->sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+            backOff(attempt);
+        }
+        if (error) {
+            *error = "Shared memory snapshot kept changing while being read.";
+        }
+        return false;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "snapshot.h"
+
+// SharedMetrics namespace encapsulating the POSIX shared-memory segment that a
+// publisher writes the latest Snapshot into and any number of readers copy from
+namespace SharedMetrics {
+    inline constexpr const char kDefaultName[] = "/sit_metrics";
+
+    // Bumped whenever the segment header or the Snapshot layout changes
+    inline constexpr uint32_t kLayoutVersion = 7;
+
+    struct Segment;
+
+    // Single writer. open() takes an exclusive lock on the segment for the
+    // publisher's lifetime, so a second publisher on the same name fails instead
+    // of racing the first; a segment left behind by a publisher that died holds no
+    // lock and is taken over. The segment is unlinked when the publisher is destroyed.
+    class Publisher {
+    public:
+        Publisher() = default;
+        ~Publisher();
+
+        bool open(const std::string& name, std::string* error);
+
+        // Copies the snapshot into the segment under the seqlock
+        void publish(const Metrics::Snapshot& snapshot);
+
+        Publisher(const Publisher&) = delete;
+        Publisher& operator=(const Publisher&) = delete;
+
+    private:
+        Segment* segment = nullptr;
+        int lockFd = -1;            // Segment descriptor holding the flock
+        std::string segmentName;
+    };
+
+    // Maps the segment read-only once; every read after that is a plain
+    // memory copy validated by the sequence counter, with no syscalls or locks.
+    class Reader {
+    public:
+        Reader() = default;
+        ~Reader();
+
+        bool open(const std::string& name, std::string* error);
+
+        // Copies a consistent snapshot. A copy that races a write yields, then
+        // sleeps briefly, before retrying; gives up instead of blocking if the
+        // writer keeps the segment busy, or if nothing has been published yet.
+        bool read(Metrics::Snapshot& snapshot, std::string* error) const;
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+    private:
+        const Segment* segment = nullptr;
+    };
+}
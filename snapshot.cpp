@@ -0,0 +1,608 @@
+// snapshot.cpp snapshot collection implementation
+#include "snapshot.h"
+#include "sensors.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <thread>
+
+namespace Metrics {
+namespace {
+    // A collection further apart than this is not a useful rate window; take a fresh one
+    constexpr std::chrono::seconds kMaxRateWindow(10);
+
+    // How long collect() waits for each section, on top of the priming window
+    constexpr std::array<std::chrono::milliseconds, kSectionCount> kSectionBudgets = { {
+        std::chrono::milliseconds(1000),    // Host: static facts are cached, disk size needs statvfs
+        std::chrono::milliseconds(500),     // Cpu
+        std::chrono::milliseconds(1500),    // Memory: smaps_rollup walks every mapping of the top processes
+        std::chrono::milliseconds(1000),    // Io: root usage needs statvfs
+        std::chrono::milliseconds(500),     // Cgroup
+        std::chrono::milliseconds(2500),    // Mounts: getMounts gives up on each mount after 2 s itself
+        std::chrono::milliseconds(1000),    // Sensors
+    } };
+
+    constexpr std::array<const char*, kSectionCount> kSectionNames = {
+        "host", "cpu", "memory", "io", "cgroup", "mounts", "sensors"
+    };
+
+    uint64_t unixMillis() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    template <typename T, size_t N>
+    void copyArray(const T (&from)[N], T (&to)[N]) {
+        std::copy(std::begin(from), std::end(from), std::begin(to));
+    }
+
+    // Copies the fields one section writes
+    void copySection(Section section, const Snapshot& from, Snapshot& to) {
+        switch (section) {
+        case Section::Host:
+            copyArray(from.hostName, to.hostName);
+            copyArray(from.osName, to.osName);
+            copyArray(from.cpuModel, to.cpuModel);
+            copyArray(from.cpuFeatures, to.cpuFeatures);
+            copyArray(from.userName, to.userName);
+            to.sockets = from.sockets;
+            to.cores = from.cores;
+            to.threads = from.threads;
+            to.numaNodes = from.numaNodes;
+            to.cpuFlagCount = from.cpuFlagCount;
+            to.l1dCacheBytes = from.l1dCacheBytes;
+            to.l1iCacheBytes = from.l1iCacheBytes;
+            to.l2CacheBytes = from.l2CacheBytes;
+            to.l3CacheBytes = from.l3CacheBytes;
+            to.totalRamBytes = from.totalRamBytes;
+            to.diskTotalGB = from.diskTotalGB;
+            break;
+        case Section::Cpu:
+            to.ratesReady.cpu = from.ratesReady.cpu;
+            to.ratesReady.sched = from.ratesReady.sched;
+            to.ratesReady.cgroup = from.ratesReady.cgroup;
+            to.cgroupCpuLimit = from.cgroupCpuLimit;
+            to.cgroupRates = from.cgroupRates;
+            to.uptimeSeconds = from.uptimeSeconds;
+            to.cpuUsage = from.cpuUsage;
+            to.load1 = from.load1;
+            to.load5 = from.load5;
+            to.load15 = from.load15;
+            to.loadAvailable = from.loadAvailable;
+            to.cpuPressure = from.cpuPressure;
+            to.sched = from.sched;
+            break;
+        case Section::Memory:
+            to.ratesReady.memory = from.ratesReady.memory;
+            to.ramUsage = from.ramUsage;
+            to.cgroupMemory = from.cgroupMemory;
+            to.memoryPressure = from.memoryPressure;
+            to.swap = from.swap;
+            to.memory = from.memory;
+            to.memoryActivity = from.memoryActivity;
+            to.processCount = from.processCount;
+            copyArray(from.processes, to.processes);
+            break;
+        case Section::Io:
+            to.ratesReady.disk = from.ratesReady.disk;
+            to.ratesReady.net = from.ratesReady.net;
+            to.diskUsage = from.diskUsage;
+            to.ioPressure = from.ioPressure;
+            to.diskCount = from.diskCount;
+            copyArray(from.disks, to.disks);
+            to.interfaceCount = from.interfaceCount;
+            copyArray(from.interfaces, to.interfaces);
+            to.tcp = from.tcp;
+            break;
+        case Section::Cgroup:
+            to.cgroupAvailable = from.cgroupAvailable;
+            copyArray(from.cgroupPath, to.cgroupPath);
+            to.cgroupMemoryPressure = from.cgroupMemoryPressure;
+            break;
+        case Section::Mounts:
+            to.mountCount = from.mountCount;
+            copyArray(from.mounts, to.mounts);
+            break;
+        case Section::Sensors:
+            to.sensorCount = from.sensorCount;
+            copyArray(from.sensors, to.sensors);
+            to.throttleAvailable = from.throttleAvailable;
+            to.coreThrottleEvents = from.coreThrottleEvents;
+            to.packageThrottleEvents = from.packageThrottleEvents;
+            to.ratesReady.throttle = from.ratesReady.throttle;
+            to.coreThrottlePerSec = from.coreThrottlePerSec;
+            to.packageThrottlePerSec = from.packageThrottlePerSec;
+            to.cpuTempC = from.cpuTempC;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void fillHostFacts(Snapshot& snapshot) {
+        const SystemInfo::HostFacts& facts = SystemInfo::getHostFacts();
+        copyString(snapshot.hostName, SystemInfo::getHostName());
+        copyString(snapshot.osName, facts.osName);
+        copyString(snapshot.cpuModel, facts.cpuModel);
+        copyString(snapshot.userName, SystemInfo::getUserName());
+        std::string features;
+        for (const char* flag : { "sse4_2", "avx", "avx2", "avx512f", "aes", "sha_ni", "asimd", "sve" }) {
+            if (facts.hasFlag(flag)) {
+                features += features.empty() ? flag : std::string(" ") + flag;
+            }
+        }
+        copyString(snapshot.cpuFeatures, features);
+        snapshot.sockets = facts.sockets;
+        snapshot.cores = facts.cores;
+        snapshot.threads = facts.threads;
+        snapshot.numaNodes = facts.numaNodes;
+        snapshot.cpuFlagCount = static_cast<int32_t>(facts.cpuFlags.size());
+        snapshot.l1dCacheBytes = facts.l1dCacheBytes;
+        snapshot.l1iCacheBytes = facts.l1iCacheBytes;
+        snapshot.l2CacheBytes = facts.l2CacheBytes;
+        snapshot.l3CacheBytes = facts.l3CacheBytes;
+        snapshot.totalRamBytes = facts.totalRamBytes;
+    }
+
+    void fillDevices(Snapshot& snapshot, const DiskStats::Sampler& disk, const NetStats::Sampler& net) {
+        snapshot.diskCount = 0;
+        for (const auto& dev : disk.devices()) {
+            if (snapshot.diskCount >= kMaxDisks) {
+                break;
+            }
+            DiskEntry& entry = snapshot.disks[snapshot.diskCount++];
+            copyString(entry.name, dev.name);
+            entry.readIops = dev.readIops;
+            entry.writeIops = dev.writeIops;
+            entry.readBytesPerSec = dev.readBytesPerSec;
+            entry.writeBytesPerSec = dev.writeBytesPerSec;
+            entry.readLatencyMs = dev.readLatencyMs;
+            entry.writeLatencyMs = dev.writeLatencyMs;
+            entry.utilization = dev.utilization;
+        }
+        snapshot.interfaceCount = 0;
+        for (const auto& iface : net.interfaces()) {
+            if (snapshot.interfaceCount >= kMaxInterfaces) {
+                break;
+            }
+            if (NetStats::isLoopback(iface.name)) {
+                continue;
+            }
+            InterfaceEntry& entry = snapshot.interfaces[snapshot.interfaceCount++];
+            copyString(entry.name, iface.name);
+            entry.rxBytesPerSec = iface.rxBytesPerSec;
+            entry.txBytesPerSec = iface.txBytesPerSec;
+            entry.rxPacketsPerSec = iface.rxPacketsPerSec;
+            entry.txPacketsPerSec = iface.txPacketsPerSec;
+            entry.rxDropsPerSec = iface.rxDropsPerSec;
+            entry.txDropsPerSec = iface.txDropsPerSec;
+            entry.rxErrorsPerSec = iface.rxErrorsPerSec;
+            entry.txErrorsPerSec = iface.txErrorsPerSec;
+        }
+        snapshot.tcp = net.tcp();
+    }
+
+    void fillMounts(Snapshot& snapshot) {
+        snapshot.mountCount = 0;
+        for (const auto& mount : SystemInfo::getMounts()) {
+            if (snapshot.mountCount >= kMaxMounts) {
+                break;
+            }
+            MountEntry& entry = snapshot.mounts[snapshot.mountCount++];
+            copyString(entry.mountPoint, mount.mountPoint);
+            copyString(entry.device, mount.device);
+            copyString(entry.fsType, mount.fsType);
+            entry.totalBytes = mount.totalBytes;
+            entry.availableBytes = mount.availableBytes;
+            entry.usagePercent = mount.usagePercent;
+            entry.inodeUsagePercent = mount.inodeUsagePercent;
+            entry.timedOut = mount.timedOut ? 1 : 0;
+            entry.failed = mount.failed ? 1 : 0;
+        }
+    }
+
+    void fillSensors(Snapshot& snapshot, Sensors::ThrottleSampler& throttleSampler) {
+        Sensors::Registry& registry = Sensors::Registry::instance();
+        snapshot.sensorCount = 0;
+        std::vector<Sensors::Sensor> readings = registry.refresh();
+        for (const auto& sensor : readings) {
+            if (snapshot.sensorCount >= kMaxSensors) {
+                break;
+            }
+            SensorEntry& entry = snapshot.sensors[snapshot.sensorCount++];
+            copyString(entry.name, sensor.name);
+            entry.kind = static_cast<int32_t>(sensor.kind);
+            entry.celsius = sensor.celsius;
+        }
+        Sensors::Throttle throttle = throttleSampler.sample();
+        snapshot.throttleAvailable = throttle.available ? 1 : 0;
+        snapshot.coreThrottleEvents = throttle.coreEvents;
+        snapshot.packageThrottleEvents = throttle.packageEvents;
+        snapshot.ratesReady.throttle = throttleSampler.ready() ? 1 : 0;
+        snapshot.coreThrottlePerSec = throttleSampler.rates().corePerSec;
+        snapshot.packageThrottlePerSec = throttleSampler.rates().packagePerSec;
+        snapshot.cpuTempC = Sensors::cpuTemperature(readings);     // From the same refresh
+    }
+} // namespace
+
+    const char* sectionName(Section section) {
+        int index = static_cast<int>(section);
+        return index >= 0 && index < kSectionCount ? kSectionNames[index] : "unknown";
+    }
+
+    struct Collector::State {
+        int windowMs;
+        int topProcessCount = 0;
+        // cpu.stat and io.stat are sampled on the Cpu section's thread, where the CPU
+        // sampler also takes its quota usage from them
+        Cgroup::Sampler cgroup;
+        SystemInfo::CpuSampler cpu{ &cgroup };
+        DiskStats::Sampler disk;
+        NetStats::Sampler net;
+        Memory::Sampler memory;
+        SchedStats::Sampler sched;
+        Sensors::ThrottleSampler throttle;
+        std::mutex detectorMutex;       // Sections observe from their own threads
+        Stats::Detector detector;
+        std::array<std::unique_ptr<Snapshot>, kSectionCount> staging;  // Each written only by its section's task
+
+        explicit State(int windowMs) : windowMs(windowMs) {
+            for (auto& section : staging) {
+                section = std::make_unique<Snapshot>();
+            }
+        }
+
+        void observe(const char* name, double value, double minDeviation);
+        void run(Section section, Snapshot& snapshot, bool prime);
+        void collectHost(Snapshot& snapshot);
+        void collectCpu(Snapshot& snapshot);
+        void collectMemory(Snapshot& snapshot);
+        void collectIo(Snapshot& snapshot);
+        void collectCgroup(Snapshot& snapshot);
+        void collectMounts(Snapshot& snapshot);
+        void collectSensors(Snapshot& snapshot);
+        void stamp(Snapshot& snapshot);
+    };
+
+    Collector::Collector(int windowMs)
+        : state(std::make_shared<State>(windowMs)), last(std::make_unique<Snapshot>()), executor(kSectionCount) {
+        for (int i = 0; i < kSectionCount; ++i) {
+            slots[i].budget = kSectionBudgets[i];
+        }
+    }
+
+    void Collector::State::observe(const char* name, double value, double minDeviation) {
+        std::lock_guard<std::mutex> lock(detectorMutex);
+        detector.observe(name, value, minDeviation);
+    }
+
+    // Runs on an executor thread. Priming happens here rather than up front so the
+    // rate windows of all sections overlap and a stuck section's samplers are never
+    // touched from two threads.
+    void Collector::State::run(Section section, Snapshot& snapshot, bool prime) {
+        auto window = std::chrono::milliseconds(windowMs);
+        switch (section) {
+        case Section::Host:
+            collectHost(snapshot);
+            break;
+        case Section::Cpu:
+            if (prime) {
+                cgroup.sample();
+                cpu.sample();
+                sched.sample();
+                std::this_thread::sleep_for(window);
+            }
+            collectCpu(snapshot);
+            break;
+        case Section::Memory:
+            if (prime) {
+                memory.sample();
+                std::this_thread::sleep_for(window);
+            }
+            collectMemory(snapshot);
+            break;
+        case Section::Io:
+            if (prime) {
+                disk.sample();
+                net.sample();
+                std::this_thread::sleep_for(window);
+            }
+            collectIo(snapshot);
+            break;
+        case Section::Cgroup:
+            collectCgroup(snapshot);
+            break;
+        case Section::Mounts:
+            collectMounts(snapshot);
+            break;
+        case Section::Sensors:
+            if (prime) {
+                throttle.sample();
+                std::this_thread::sleep_for(window);
+            }
+            collectSensors(snapshot);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void Collector::collect(Snapshot& snapshot) {
+        auto started = std::chrono::steady_clock::now();
+        bool prime = !primed || started - lastCollect > kMaxRateWindow;
+        auto primeWindow = prime ? std::chrono::milliseconds(state->windowMs) : std::chrono::milliseconds(0);
+
+        std::array<bool, kSectionCount> launched{};
+        for (int i = 0; i < kSectionCount; ++i) {
+            Slot& slot = slots[i];
+            if (slot.running.valid()) {
+                // A run that missed an earlier deadline; start again only once it has returned
+                if (slot.running.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    continue;
+                }
+                slot.running.get();
+            }
+            Section section = static_cast<Section>(i);
+            Snapshot* staging = state->staging[i].get();
+            slot.running = executor.submit([shared = state, section, staging, prime] {
+                shared->run(section, *staging, prime);
+            });
+            launched[i] = true;
+        }
+
+        snapshot = *last;
+        for (int i = 0; i < kSectionCount; ++i) {
+            Slot& slot = slots[i];
+            SectionState freshness = SectionState::Stale;
+            if (launched[i]) {
+                freshness = SectionState::TimedOut;
+                if (slot.running.wait_until(started + primeWindow + slot.budget) == std::future_status::ready) {
+                    slot.running.get();
+                    copySection(static_cast<Section>(i), *state->staging[i], snapshot);
+                    slot.collectedMs = unixMillis();
+                    freshness = SectionState::Fresh;
+                }
+            }
+            snapshot.sectionState[i] = static_cast<uint8_t>(freshness);
+            snapshot.sectionTimestampMs[i] = slot.collectedMs;
+        }
+        primed = true;
+        lastCollect = std::chrono::steady_clock::now();
+        stamp(snapshot);
+        *last = snapshot;
+    }
+
+    void Collector::setTopProcesses(int count) {
+        state->topProcessCount = std::clamp(count, 0, kMaxProcesses);
+    }
+
+    void Collector::collectHost(Snapshot& snapshot) {
+        state->collectHost(snapshot);
+    }
+
+    void Collector::collectCpu(Snapshot& snapshot) {
+        state->collectCpu(snapshot);
+    }
+
+    void Collector::collectMemory(Snapshot& snapshot) {
+        state->collectMemory(snapshot);
+    }
+
+    void Collector::collectIo(Snapshot& snapshot) {
+        state->collectIo(snapshot);
+    }
+
+    void Collector::collectCgroup(Snapshot& snapshot) {
+        state->collectCgroup(snapshot);
+    }
+
+    void Collector::collectMounts(Snapshot& snapshot) {
+        state->collectMounts(snapshot);
+    }
+
+    void Collector::collectSensors(Snapshot& snapshot) {
+        state->collectSensors(snapshot);
+    }
+
+    void Collector::stamp(Snapshot& snapshot) {
+        state->stamp(snapshot);
+    }
+
+    void Collector::State::collectHost(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectHost);
+        fillHostFacts(snapshot);
+        snapshot.diskTotalGB = SystemInfo::getDisk();
+    }
+
+    void Collector::State::collectCpu(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectCpu);
+        cgroup.sample();
+        cpu.sample();
+        snapshot.ratesReady.cpu = cpu.ready() ? 1 : 0;
+        snapshot.cpuUsage = cpu.usage();
+        snapshot.uptimeSeconds = SystemInfo::getUptime();
+        snapshot.loadAvailable = SystemInfo::getLoadAverage(snapshot.load1, snapshot.load5, snapshot.load15) ? 1 : 0;
+        snapshot.cpuPressure = Pressure::read("cpu");
+        sched.sample();
+        snapshot.sched = sched.rates();
+        snapshot.ratesReady.sched = sched.ready() ? 1 : 0;
+        snapshot.cgroupCpuLimit = cgroup.cpuLimit();
+        snapshot.cgroupRates = cgroup.rates();
+        snapshot.ratesReady.cgroup = cgroup.ready() ? 1 : 0;
+
+        if (cpu.ready()) {
+            observe("CPU usage %", snapshot.cpuUsage, 10.0);
+        }
+        if (snapshot.loadAvailable) {
+            observe("load per core", snapshot.load1 / std::max(1, SystemInfo::getHostFacts().threads), 0.5);
+        }
+        if (snapshot.cpuPressure.available) {
+            observe("CPU pressure %", snapshot.cpuPressure.someAvg10, 5.0);
+        }
+        if (sched.ready() && snapshot.sched.schedstatAvailable) {
+            observe("run-queue wait %", snapshot.sched.runQueueWaitPercent, 5.0);
+        }
+    }
+
+    void Collector::State::collectMemory(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectMemory);
+        memory.sample();
+        // One meminfo read (in the sampler) and one cgroup memory read per tick
+        snapshot.cgroupMemory = Cgroup::readMemory();
+        snapshot.ramUsage = SystemInfo::ramUsage(memory.info().memTotal, memory.info().memAvailable,
+            snapshot.cgroupMemory);
+        snapshot.memoryPressure = Pressure::read("memory");
+        snapshot.memory = memory.info();
+        snapshot.memoryActivity = memory.activity();
+        snapshot.ratesReady.memory = memory.ready() ? 1 : 0;
+        snapshot.swap.pagesInPerSec = snapshot.memoryActivity.swapInPagesPerSec;
+        snapshot.swap.pagesOutPerSec = snapshot.memoryActivity.swapOutPagesPerSec;
+
+        snapshot.processCount = 0;
+        for (const auto& process : Memory::topProcesses(static_cast<size_t>(topProcessCount))) {
+            ProcessEntry& entry = snapshot.processes[snapshot.processCount++];
+            entry.pid = process.pid;
+            copyString(entry.name, process.name);
+            entry.rss = process.rss;
+            entry.pss = process.pss;
+            entry.pssAnon = process.pssAnon;
+            entry.pssFile = process.pssFile;
+            entry.pssShmem = process.pssShmem;
+            entry.swap = process.swap;
+            entry.detailed = process.detailed ? 1 : 0;
+        }
+
+        observe("RAM usage %", snapshot.ramUsage, 10.0);
+        if (snapshot.memoryPressure.available) {
+            observe("memory pressure %", snapshot.memoryPressure.someAvg10, 5.0);
+        }
+        if (memory.ready()) {
+            observe("swap pages/s", snapshot.swap.pagesInPerSec + snapshot.swap.pagesOutPerSec, 50.0);
+            observe("major faults/s", snapshot.memoryActivity.majorFaultsPerSec, 50.0);
+        }
+    }
+
+    void Collector::State::collectIo(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectIo);
+        disk.sample();
+        net.sample();
+        snapshot.diskUsage = SystemInfo::getDiskUsage();
+        snapshot.ioPressure = Pressure::read("io");
+        fillDevices(snapshot, disk, net);
+        snapshot.ratesReady.disk = disk.ready() ? 1 : 0;
+        snapshot.ratesReady.net = net.ready() ? 1 : 0;
+
+        if (snapshot.ioPressure.available) {
+            observe("I/O pressure %", snapshot.ioPressure.someAvg10, 5.0);
+        }
+        char name[Stats::Detector::kNameLength];
+        if (disk.ready()) {
+            for (int i = 0; i < snapshot.diskCount; ++i) {
+                const DiskEntry& entry = snapshot.disks[i];
+                std::snprintf(name, sizeof(name), "%s busy %%", entry.name);
+                observe(name, entry.utilization, 15.0);
+                std::snprintf(name, sizeof(name), "%s await ms", entry.name);
+                observe(name, std::max(entry.readLatencyMs, entry.writeLatencyMs), 5.0);
+            }
+        }
+        if (net.ready()) {
+            for (int i = 0; i < snapshot.interfaceCount; ++i) {
+                const InterfaceEntry& entry = snapshot.interfaces[i];
+                std::snprintf(name, sizeof(name), "%s rx MB/s", entry.name);
+                observe(name, entry.rxBytesPerSec / (1024.0 * 1024.0), 1.0);
+                std::snprintf(name, sizeof(name), "%s tx MB/s", entry.name);
+                observe(name, entry.txBytesPerSec / (1024.0 * 1024.0), 1.0);
+            }
+            observe("TCP retransmits/s", snapshot.tcp.retransPerSec, 5.0);
+        }
+    }
+
+    void Collector::State::collectCgroup(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectCgroup);
+        snapshot.cgroupAvailable = Cgroup::available() ? 1 : 0;
+        if (!snapshot.cgroupAvailable) {
+            return;
+        }
+        copyString(snapshot.cgroupPath, Cgroup::path());
+        snapshot.cgroupMemoryPressure = Cgroup::readMemoryPressure();
+    }
+
+    void Collector::State::collectMounts(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectMounts);
+        fillMounts(snapshot);
+    }
+
+    void Collector::State::collectSensors(Snapshot& snapshot) {
+        SIT_PROFILE_SCOPE(CollectSensors);
+        fillSensors(snapshot, throttle);
+    }
+
+    void Collector::State::stamp(Snapshot& snapshot) {
+        snapshot.timestampMs = unixMillis();
+
+        std::lock_guard<std::mutex> lock(detectorMutex);
+        snapshot.cpuUsageSmoothed = detector.smoothed("CPU usage %", snapshot.cpuUsage);
+        snapshot.ramUsageSmoothed = detector.smoothed("RAM usage %", snapshot.ramUsage);
+        snapshot.baselineSamples = detector.baselineSamples();
+        Stats::Anomaly found[kMaxAnomalies];
+        snapshot.anomalyCount = detector.anomalies(found, kMaxAnomalies);
+        for (int i = 0; i < snapshot.anomalyCount; ++i) {
+            AnomalyEntry& entry = snapshot.anomalies[i];
+            copyString(entry.series, found[i].name);
+            entry.value = found[i].value;
+            entry.baseline = found[i].baseline;
+            entry.stddev = found[i].stddev;
+            entry.z = found[i].z;
+            entry.p50 = found[i].p50;
+            entry.p95 = found[i].p95;
+            entry.p99 = found[i].p99;
+        }
+    }
+
+    double worstDiskUsage(const Snapshot& snapshot) {
+        double worst = snapshot.diskUsage;
+        for (int i = 0; i < snapshot.mountCount; ++i) {
+            const MountEntry& mount = snapshot.mounts[i];
+            if (!mount.timedOut && !mount.failed) {
+                worst = std::max(worst, std::max(mount.usagePercent, mount.inodeUsagePercent));
+            }
+        }
+        return worst;
+    }
+
+    Health::Inputs healthInputs(const Snapshot& snapshot) {
+        Health::Inputs inputs;
+        inputs.set(Health::Metric::CpuUsage, snapshot.cpuUsage);
+        inputs.set(Health::Metric::RamUsage, snapshot.ramUsage);
+        // Disk health follows the fullest mount rather than just the root filesystem
+        inputs.set(Health::Metric::DiskUsage, worstDiskUsage(snapshot));
+        if (snapshot.ratesReady.disk && snapshot.diskCount > 0) {
+            double busiest = 0.0;
+            for (int i = 0; i < snapshot.diskCount; ++i) {
+                busiest = std::max(busiest, snapshot.disks[i].utilization);
+            }
+            inputs.set(Health::Metric::DiskIOUtilization, busiest);
+        }
+        if (snapshot.cpuPressure.available) {
+            inputs.set(Health::Metric::CpuPressure, snapshot.cpuPressure.someAvg10);
+        }
+        if (snapshot.memoryPressure.available) {
+            inputs.set(Health::Metric::MemoryPressure, snapshot.memoryPressure.someAvg10);
+        }
+        if (snapshot.ioPressure.available) {
+            inputs.set(Health::Metric::IoPressure, snapshot.ioPressure.someAvg10);
+        }
+        if (snapshot.loadAvailable) {
+            inputs.set(Health::Metric::LoadPerCore, snapshot.load1 / std::max(1, snapshot.threads));
+        }
+        if (snapshot.ratesReady.memory) {
+            inputs.set(Health::Metric::SwapActivity, snapshot.swap.pagesInPerSec + snapshot.swap.pagesOutPerSec);
+        }
+        if (snapshot.ratesReady.sched && snapshot.sched.schedstatAvailable) {
+            inputs.set(Health::Metric::RunQueueWait, snapshot.sched.runQueueWaitPercent);
+        }
+        return inputs;
+    }
+}
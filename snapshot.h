@@ -0,0 +1,281 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include "executor.h"
+#include "systemInfo.h"
+#include "diskStats.h"
+#include "netStats.h"
+#include "pressure.h"
+#include "memory.h"
+#include "schedStats.h"
+#include "cgroup.h"
+#include "health.h"
+#include "stats.h"
+
+// Metrics namespace encapsulating a complete, fixed-size sample of the system
+namespace Metrics {
+    constexpr int kMaxDisks = 16;
+    constexpr int kMaxInterfaces = 16;
+    constexpr int kMaxMounts = 32;
+    constexpr int kMaxSensors = 32;
+    constexpr int kMaxAnomalies = 16;
+    constexpr int kMaxProcesses = 8;
+
+    // Independently collected parts of a snapshot
+    enum class Section {
+        Host,
+        Cpu,
+        Memory,
+        Io,
+        Cgroup,
+        Mounts,
+        Sensors,
+        Count
+    };
+    constexpr int kSectionCount = static_cast<int>(Section::Count);
+
+    enum class SectionState : uint8_t {
+        Fresh,          // Collected for this snapshot
+        TimedOut,       // Missed its deadline; the values are from the last good collection
+        Stale           // An earlier collection is still stuck, so none was started
+    };
+
+    const char* sectionName(Section section);
+
+    struct DiskEntry {
+        char name[32];
+        double readIops;
+        double writeIops;
+        double readBytesPerSec;
+        double writeBytesPerSec;
+        double readLatencyMs;
+        double writeLatencyMs;
+        double utilization;
+    };
+
+    struct InterfaceEntry {
+        char name[32];
+        double rxBytesPerSec;
+        double txBytesPerSec;
+        double rxPacketsPerSec;
+        double txPacketsPerSec;
+        double rxDropsPerSec;
+        double txDropsPerSec;
+        double rxErrorsPerSec;
+        double txErrorsPerSec;
+    };
+
+    struct MountEntry {
+        char mountPoint[128];
+        char device[64];
+        char fsType[24];
+        uint64_t totalBytes;
+        uint64_t availableBytes;
+        double usagePercent;
+        double inodeUsagePercent;
+        uint8_t timedOut;
+        uint8_t failed;
+    };
+
+    struct SensorEntry {
+        char name[64];
+        int32_t kind;       // Sensors::Kind
+        double celsius;
+    };
+
+    struct ProcessEntry {
+        int32_t pid;
+        char name[32];
+        uint64_t rss;
+        uint64_t pss;
+        uint64_t pssAnon;
+        uint64_t pssFile;
+        uint64_t pssShmem;
+        uint64_t swap;
+        uint8_t detailed;   // Proportional fields are valid (smaps_rollup was readable)
+    };
+
+    struct AnomalyEntry {
+        char series[48];
+        double value;       // Smoothed current value
+        double baseline;
+        double stddev;
+        double z;
+        double p50;
+        double p95;
+        double p99;
+    };
+
+    // Which rates cover a real sampling window. Each sampler primes on its own, so a
+    // section that timed out or was just added can lag the others.
+    struct RatesReady {
+        uint8_t cpu = 0;        // cpuUsage
+        uint8_t sched = 0;      // sched rates
+        uint8_t memory = 0;     // memoryActivity and swap rates
+        uint8_t disk = 0;       // disks
+        uint8_t net = 0;        // interfaces and tcp
+        uint8_t cgroup = 0;     // cgroupRates
+        uint8_t throttle = 0;   // Thermal throttle rates
+
+        // Every host-wide rate; cgroup and throttle rates only exist on some hosts
+        bool all() const { return cpu && sched && memory && disk && net; }
+    };
+
+    // Everything the report commands print, in a trivially copyable layout so it
+    // can be memcpy'd into shared memory or written to disk as-is. Strings are
+    // truncated to their fixed buffers; variable-length tables are capped.
+    struct Snapshot {
+        uint64_t timestampMs = 0;     // Unix time of collection, in milliseconds
+        RatesReady ratesReady;
+
+        // Static host facts
+        char hostName[64] = {};
+        char osName[64] = {};
+        char cpuModel[96] = {};
+        char cpuFeatures[96] = {};    // Notable flags, space separated
+        char userName[32] = {};
+        int32_t sockets = 0;
+        int32_t cores = 0;
+        int32_t threads = 0;
+        int32_t numaNodes = 0;
+        int32_t cpuFlagCount = 0;
+        uint64_t l1dCacheBytes = 0;
+        uint64_t l1iCacheBytes = 0;
+        uint64_t l2CacheBytes = 0;
+        uint64_t l3CacheBytes = 0;
+        uint64_t totalRamBytes = 0;
+        uint64_t diskTotalGB = 0;
+
+        // Usage
+        int64_t uptimeSeconds = 0;
+        double cpuUsage = 0.0;
+        double ramUsage = 0.0;
+        double diskUsage = 0.0;
+        double cpuTempC = -1.0;
+        double load1 = 0.0;
+        double load5 = 0.0;
+        double load15 = 0.0;
+        uint8_t loadAvailable = 0;
+        SchedStats::Rates sched;             // Run-queue wait, task counts, context switch and interrupt rates
+
+        // Contention
+        Pressure::Stall cpuPressure;
+        Pressure::Stall memoryPressure;
+        Pressure::Stall ioPressure;
+        Pressure::Swap swap;
+
+        // Memory breakdown
+        Memory::Info memory;
+        Memory::Activity memoryActivity;
+        int32_t processCount = 0;       // Only collected when top processes are requested
+        ProcessEntry processes[kMaxProcesses] = {};
+
+        // Container accounting
+        uint8_t cgroupAvailable = 0;
+        char cgroupPath[128] = {};
+        Cgroup::Memory cgroupMemory;
+        Cgroup::CpuLimit cgroupCpuLimit;
+        Cgroup::Rates cgroupRates;
+        Pressure::Stall cgroupMemoryPressure;
+
+        // Devices
+        int32_t diskCount = 0;
+        DiskEntry disks[kMaxDisks] = {};
+        int32_t interfaceCount = 0;
+        InterfaceEntry interfaces[kMaxInterfaces] = {};
+        NetStats::Tcp tcp;
+        int32_t mountCount = 0;
+        MountEntry mounts[kMaxMounts] = {};
+        int32_t sensorCount = 0;
+        SensorEntry sensors[kMaxSensors] = {};
+        uint8_t throttleAvailable = 0;
+        uint64_t coreThrottleEvents = 0;
+        uint64_t packageThrottleEvents = 0;
+        double coreThrottlePerSec = 0.0;
+        double packageThrottlePerSec = 0.0;
+
+        // Deviations from this host's own baseline (long-running collectors only)
+        double cpuUsageSmoothed = 0.0;
+        double ramUsageSmoothed = 0.0;
+        uint64_t baselineSamples = 0;
+        int32_t anomalyCount = 0;
+        AnomalyEntry anomalies[kMaxAnomalies] = {};
+
+        // Freshness of each section (SectionState) and when its values were collected,
+        // as Unix milliseconds (0 = never). Set by Collector::collect only.
+        uint8_t sectionState[kSectionCount] = {};
+        uint64_t sectionTimestampMs[kSectionCount] = {};
+    };
+
+    static_assert(std::is_trivially_copyable<Snapshot>::value, "Snapshot must be trivially copyable");
+
+    // Copies text into a fixed buffer, truncating and always NUL-terminating
+    template <size_t N>
+    void copyString(char (&dest)[N], const std::string& text) {
+        size_t count = text.size() < N - 1 ? text.size() : N - 1;
+        text.copy(dest, count);
+        dest[count] = '\0';
+    }
+
+    // Keeps the rate samplers alive between collections. The first collection
+    // (or one after a long gap) measures over a short fresh window; later ones
+    // measure rates since the previous collection without sleeping.
+    class Collector {
+    public:
+        explicit Collector(int windowMs = 200);
+
+        // Fills every section of the snapshot, running the sections concurrently.
+        // A section that misses its deadline keeps its last good values and is
+        // marked in sectionState, so one hung filesystem cannot stall the caller.
+        void collect(Snapshot& snapshot);
+
+        // Individual sections, for callers that refresh them at different
+        // periods. Rate sections measure since their own previous call.
+        void collectHost(Snapshot& snapshot);
+        void collectCpu(Snapshot& snapshot);
+        void collectMemory(Snapshot& snapshot);
+        void collectIo(Snapshot& snapshot);
+        void collectCgroup(Snapshot& snapshot);
+        void collectMounts(Snapshot& snapshot);
+        void collectSensors(Snapshot& snapshot);
+
+        // Adds the given number of largest processes (up to kMaxProcesses) to the
+        // memory section. Off by default: ranking walks every process in /proc.
+        void setTopProcesses(int count);
+
+        // Sets the collection timestamp and copies the smoothed values and
+        // active anomalies from the baseline detector
+        void stamp(Snapshot& snapshot);
+
+    private:
+        // Samplers, detector and staging snapshots: everything a section task touches.
+        // Tasks share ownership, so one still stuck in a system call when the Collector
+        // is destroyed keeps writing into live memory and frees it when it returns.
+        struct State;
+
+        struct Slot {
+            std::chrono::milliseconds budget;       // Deadline after the collection starts
+            std::future<void> running;              // Valid while a run has not been collected
+            uint64_t collectedMs = 0;
+        };
+
+        bool primed = false;
+        std::chrono::steady_clock::time_point lastCollect;
+        std::shared_ptr<State> state;
+        std::array<Slot, kSectionCount> slots;
+        std::unique_ptr<Snapshot> last;
+        Async::Executor executor;
+    };
+
+    // Health engine inputs derived from a snapshot
+    Health::Inputs healthInputs(const Snapshot& snapshot);
+
+    // Fullest mount (blocks or inodes) or the root filesystem usage, whichever is higher
+    double worstDiskUsage(const Snapshot& snapshot);
+}
@@ -0,0 +1,178 @@
+// stats.cpp streaming statistics implementation
+#include "stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Stats {
+namespace {
+    constexpr double kGamma = (1.0 + Sketch::kRelativeAccuracy) / (1.0 - Sketch::kRelativeAccuracy);
+
+    // Roughly an hour of history at one sample per second
+    constexpr uint64_t kHorizon = 3600;
+    constexpr uint64_t kWarmupSamples = 30;
+    constexpr double kEnterZ = 3.0;
+    constexpr double kExitZ = 1.5;
+    constexpr int kEnterSamples = 3;
+    constexpr int kExitSamples = 5;
+    // Deviations smaller than this fraction of the baseline are never reported
+    constexpr double kRelativeFloor = 0.25;
+} // namespace
+
+    void Welford::add(double x) {
+        if (horizon == 0 || count < horizon) {
+            ++count;
+        } else {
+            // Capped: forget the same share of the spread that a new sample adds
+            m2 -= m2 / count;
+        }
+        double delta = x - average;
+        average += delta / count;
+        m2 += delta * (x - average);
+    }
+
+    double Welford::stddev() const {
+        return std::sqrt(std::max(0.0, variance()));
+    }
+
+    void Sketch::add(double x) {
+        if (horizon && count >= 2 * horizon) {
+            decay();
+        }
+        ++count;
+        if (!(x >= kMinValue)) {
+            ++zeros;
+            return;
+        }
+        static const double logGamma = std::log(kGamma);
+        int index = static_cast<int>(std::ceil(std::log(x / kMinValue) / logGamma));
+        ++buckets[std::min(std::max(index, 0), kBuckets - 1)];
+    }
+
+    void Sketch::decay() {
+        count = zeros / 2;
+        zeros /= 2;
+        for (auto& bucket : buckets) {
+            bucket /= 2;
+            count += bucket;
+        }
+    }
+
+    double Sketch::quantile(double q) const {
+        if (count == 0) {
+            return 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * (count - 1));
+        uint64_t seen = zeros;
+        if (rank < seen) {
+            return 0.0;
+        }
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += buckets[i];
+            if (rank < seen) {
+                // Midpoint of the bucket in relative terms
+                return kMinValue * 2.0 * std::pow(kGamma, i) / (kGamma + 1.0);
+            }
+        }
+        return kMinValue * std::pow(kGamma, kBuckets - 1);
+    }
+
+    Detector::Series::Series(const char* seriesName, double minDeviation)
+        : minDeviation(minDeviation), baseline(kHorizon), sketch(kHorizon) {
+        std::strncpy(name, seriesName, kNameLength - 1);
+        name[kNameLength - 1] = '\0';
+    }
+
+    Detector::Detector() {
+        // Reserved up front so adding a series never moves the others
+        series.reserve(kMaxSeries);
+    }
+
+    Detector::Series* Detector::find(const char* name) {
+        return const_cast<Series*>(static_cast<const Detector*>(this)->find(name));
+    }
+
+    const Detector::Series* Detector::find(const char* name) const {
+        for (const auto& entry : series) {
+            if (std::strncmp(entry.name, name, kNameLength - 1) == 0) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void Detector::observe(const char* name, double value, double minDeviation) {
+        Series* entry = find(name);
+        if (!entry) {
+            if (series.size() >= static_cast<size_t>(kMaxSeries)) {
+                return;
+            }
+            series.emplace_back(name, minDeviation);
+            entry = &series.back();
+        }
+
+        entry->smooth.add(value);
+        if (entry->baseline.samples() >= kWarmupSamples) {
+            double mean = entry->baseline.mean();
+            double deviation = entry->smooth.value() - mean;
+            double floor = std::max(entry->minDeviation, kRelativeFloor * std::fabs(mean));
+            entry->z = deviation / std::max(entry->baseline.stddev(), 1e-9);
+            bool significant = std::fabs(deviation) >= floor;
+            if (!entry->active) {
+                entry->streak = significant && std::fabs(entry->z) >= kEnterZ ? entry->streak + 1 : 0;
+                if (entry->streak >= kEnterSamples) {
+                    entry->active = true;
+                    entry->streak = 0;
+                }
+            } else {
+                entry->streak = !significant || std::fabs(entry->z) < kExitZ ? entry->streak + 1 : 0;
+                if (entry->streak >= kExitSamples) {
+                    entry->active = false;
+                    entry->streak = 0;
+                }
+            }
+        }
+        entry->baseline.add(value);
+        entry->sketch.add(value);
+    }
+
+    double Detector::smoothed(const char* name, double fallback) const {
+        const Series* entry = find(name);
+        return entry && entry->baseline.samples() >= kEnterSamples ? entry->smooth.value() : fallback;
+    }
+
+    uint64_t Detector::baselineSamples() const {
+        if (series.empty()) {
+            return 0;
+        }
+        uint64_t fewest = series.front().baseline.samples();
+        for (const auto& entry : series) {
+            fewest = std::min(fewest, entry.baseline.samples());
+        }
+        return fewest;
+    }
+
+    int Detector::anomalies(Anomaly* out, int capacity) const {
+        int written = 0;
+        for (const auto& entry : series) {
+            if (!entry.active) {
+                continue;
+            }
+            Anomaly anomaly{entry.name, entry.smooth.value(), entry.baseline.mean(), entry.baseline.stddev(),
+                entry.z, entry.sketch.quantile(0.50), entry.sketch.quantile(0.95), entry.sketch.quantile(0.99)};
+            // Insertion into the fixed output keeps the largest |z| first
+            int pos = written < capacity ? written++ : capacity;
+            while (pos > 0 && std::fabs(out[pos - 1].z) < std::fabs(anomaly.z)) {
+                if (pos < capacity) {
+                    out[pos] = out[pos - 1];
+                }
+                --pos;
+            }
+            if (pos < capacity) {
+                out[pos] = anomaly;
+            }
+        }
+        return written;
+    }
+}
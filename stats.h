@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Stats namespace encapsulating constant-memory streaming statistics and a
+// per-series baseline anomaly detector built on them
+namespace Stats {
+    // Exponentially weighted moving average; the first sample seeds it
+    class Ewma {
+    public:
+        explicit Ewma(double alpha = 0.2) : alpha(alpha) {}
+
+        void add(double x) {
+            current = seeded ? current + alpha * (x - current) : x;
+            seeded = true;
+        }
+        double value() const { return current; }
+
+    private:
+        double alpha;
+        double current = 0.0;
+        bool seeded = false;
+    };
+
+    // Welford's running mean and variance. With a horizon the sample count
+    // stops growing there, so older samples fade out and the baseline keeps
+    // following slow, legitimate changes in the host's workload.
+    class Welford {
+    public:
+        explicit Welford(uint64_t horizon = 0) : horizon(horizon) {}
+
+        void add(double x);
+        uint64_t samples() const { return count; }
+        double mean() const { return average; }
+        double variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+        double stddev() const;
+
+    private:
+        uint64_t horizon;
+        uint64_t count = 0;
+        double average = 0.0;
+        double m2 = 0.0;
+    };
+
+    // DDSketch with a fixed bucket array: quantiles within 2% relative error
+    // for values from 0.01 to 1e10, no allocation after construction. Values
+    // below the range count as zero; counts halve past the horizon so the
+    // distribution stays recent.
+    class Sketch {
+    public:
+        static constexpr double kRelativeAccuracy = 0.02;
+        static constexpr double kMinValue = 0.01;
+        static constexpr int kBuckets = 704;
+
+        explicit Sketch(uint64_t horizon = 0) : horizon(horizon) {}
+
+        void add(double x);
+        double quantile(double q) const;
+        uint64_t samples() const { return count; }
+
+    private:
+        uint64_t horizon;
+        uint64_t count = 0;
+        uint32_t zeros = 0;
+        std::array<uint32_t, kBuckets> buckets{};
+
+        void decay();
+    };
+
+    struct Anomaly {
+        const char* name;
+        double value;       // Smoothed current value
+        double baseline;    // Baseline mean
+        double stddev;
+        double z;
+        double p50;
+        double p95;
+        double p99;
+    };
+
+    // Tracks named series and flags the ones whose smoothed value has moved
+    // well away from their own baseline. Entering and leaving the anomalous
+    // state both need several consecutive samples, with a lower exit
+    // threshold, so a series near the edge does not flap.
+    class Detector {
+    public:
+        static constexpr int kMaxSeries = 256;
+        static constexpr int kNameLength = 48;
+
+        Detector();
+
+        // Feeds one sample. Series are created on first use and never freed;
+        // minDeviation is the smallest absolute change worth reporting.
+        void observe(const char* name, double value, double minDeviation);
+
+        // Smoothed value of a series, or fallback if it has too few samples
+        double smoothed(const char* name, double fallback) const;
+
+        // Samples behind the least-trained series
+        uint64_t baselineSamples() const;
+
+        // Writes active anomalies, most deviant first; returns how many were written
+        int anomalies(Anomaly* out, int capacity) const;
+
+    private:
+        struct Series {
+            char name[kNameLength];
+            double minDeviation;
+            Ewma smooth;
+            Welford baseline;
+            Sketch sketch;
+            double z = 0.0;
+            int streak = 0;
+            bool active = false;
+
+            Series(const char* name, double minDeviation);
+        };
+
+        std::vector<Series> series;
+
+        Series* find(const char* name);
+        const Series* find(const char* name) const;
+    };
+}
@@ -1,4 +1,6 @@
 #include "systemInfo.h"       // Header with function declarations
+#include "sensors.h"          // For the cached thermal sensor registry
+#include "procfs.h"           // For /proc paths under the configurable root
 
 #ifdef _WIN32
 #define UNICODE
@@ -14,14 +16,294 @@
 #include <thread>            // For std::this_thread::sleep_for
 #include <chrono>           // For std::chrono::milliseconds
 
+#include <memory>             // For std::shared_ptr
+#include <future>            // For std::promise used by the mount deadline
+#include <algorithm>        // For std::find and std::sort
+#include <set>             // For counting distinct sockets and cores
+
 #ifndef _WIN32
 #include <fstream>         // For file input/output (reading /proc and /etc files)
 #include <filesystem>     // For std::filesystem::space (replaces statvfs for disk info)
 #include <cstdlib>       // For getenv (replaces getlogin/getpwuid for username)
+#include <cstring>        // For strncmp when scanning /proc/meminfo
+#include <unordered_set>  // For pseudo filesystem and device de-duplication
+#include <unordered_map>  // For the in-flight mount queries
+#include <mutex>          // For guarding the in-flight mount queries
+#include <sys/statvfs.h> // For statvfs, which also reports inode counts
+#include <unistd.h>       // For gethostname
 #endif
 
 // Implementation of SystemInfo functions
 namespace SystemInfo {
+namespace {
+#ifndef _WIN32
+    // Per-thread scratch for the polled /proc sources, so a steady sampling loop
+    // refreshes into memory it already owns (collectors run on pool threads)
+    std::string& sourceBuffer() {
+        thread_local std::string buffer;
+        return buffer;
+    }
+
+    // Filesystems that have no backing storage to run out of
+    bool isPseudoFilesystem(const std::string& fsType) {
+        static const std::unordered_set<std::string> pseudo = {
+            "proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "ramfs", "cgroup", "cgroup2",
+            "securityfs", "pstore", "debugfs", "tracefs", "configfs", "fusectl", "mqueue",
+            "hugetlbfs", "bpf", "binfmt_misc", "autofs", "rpc_pipefs", "nsfs", "efivarfs",
+            "selinuxfs", "squashfs", "nfsd", "fuse.gvfsd-fuse", "fuse.portal"
+        };
+        return pseudo.count(fsType) > 0;
+    }
+
+    // Decodes the octal escapes (\040 for space etc.) used in mountinfo paths
+    std::string unescapeMountPath(const std::string& raw) {
+        std::string out;
+        out.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] == '\\' && i + 3 < raw.size()) {
+                int value = (raw[i + 1] - '0') * 64 + (raw[i + 2] - '0') * 8 + (raw[i + 3] - '0');
+                out.push_back(static_cast<char>(value));
+                i += 3;
+            } else {
+                out.push_back(raw[i]);
+            }
+        }
+        return out;
+    }
+
+    // Reads a small sysfs attribute, trimmed; empty if missing
+    std::string readAttribute(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        std::string value;
+        std::getline(file, value);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\r')) {
+            value.pop_back();
+        }
+        return value;
+    }
+
+    // Parses sysfs cache sizes such as "48K" or "2048K" into bytes
+    uint64_t parseCacheSize(const std::string& text) {
+        if (text.empty()) {
+            return 0;
+        }
+        uint64_t value = std::strtoull(text.c_str(), nullptr, 10);
+        switch (text.back()) {
+            case 'K': return value * 1024;
+            case 'M': return value * 1024 * 1024;
+            case 'G': return value * 1024 * 1024 * 1024;
+            default:  return value;
+        }
+    }
+
+    // Reads only the first processor block of /proc/cpuinfo; every block repeats
+    // the model and flags, and the file is hundreds of KB on large machines
+    std::string readFirstCpuInfoBlock() {
+        constexpr size_t kChunk = 4096;
+        constexpr size_t kLimit = 64 * 1024;
+        std::ifstream file(ProcFS::path("/proc/cpuinfo"), std::ios::binary);
+        std::string block;
+        char chunk[kChunk];
+        while (file && block.size() < kLimit) {
+            file.read(chunk, sizeof(chunk));
+            block.append(chunk, static_cast<size_t>(file.gcount()));
+            size_t blank = block.find("\n\n");
+            if (blank != std::string::npos) {
+                block.resize(blank + 1);
+                break;
+            }
+        }
+        return block;
+    }
+
+    void collectCpuInfo(HostFacts& facts) {
+        std::istringstream block(readFirstCpuInfoBlock());
+        std::string line;
+        while (std::getline(block, line)) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+            std::string value = colon + 2 <= line.size() ? line.substr(colon + 2) : std::string();
+            if (key == "model name" || (key == "Model" && facts.cpuModel.empty())) {
+                facts.cpuModel = value;
+            } else if (key == "vendor_id" || key == "CPU implementer") {
+                facts.cpuVendor = value;
+            } else if (key == "flags" || key == "Features") {
+                std::istringstream flags(value);
+                for (std::string flag; flags >> flag;) {
+                    facts.cpuFlags.push_back(flag);
+                }
+            }
+        }
+        std::sort(facts.cpuFlags.begin(), facts.cpuFlags.end());
+    }
+
+    void collectTopology(HostFacts& facts) {
+        std::error_code ec;
+        std::set<std::string> packages;
+        std::set<std::string> cores;
+        int threads = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/sys/devices/system/cpu"), ec)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() < 4 || name.compare(0, 3, "cpu") != 0 || name[3] < '0' || name[3] > '9') {
+                continue;
+            }
+            std::string package = readAttribute(entry.path() / "topology" / "physical_package_id");
+            std::string core = readAttribute(entry.path() / "topology" / "core_id");
+            if (package.empty() && core.empty()) {
+                continue;    // Offline CPUs have no topology directory
+            }
+            ++threads;
+            packages.insert(package);
+            cores.insert(package + ":" + core);
+        }
+        facts.threads = threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency());
+        facts.sockets = packages.empty() ? 1 : static_cast<int>(packages.size());
+        facts.cores = cores.empty() ? facts.threads : static_cast<int>(cores.size());
+
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/sys/devices/system/cpu/cpu0/cache"), ec)) {
+            if (entry.path().filename().string().compare(0, 5, "index") != 0) {
+                continue;
+            }
+            std::string level = readAttribute(entry.path() / "level");
+            std::string type = readAttribute(entry.path() / "type");
+            uint64_t size = parseCacheSize(readAttribute(entry.path() / "size"));
+            if (level == "1" && type == "Data") {
+                facts.l1dCacheBytes = size;
+            } else if (level == "1" && type == "Instruction") {
+                facts.l1iCacheBytes = size;
+            } else if (level == "2") {
+                facts.l2CacheBytes = size;
+            } else if (level == "3") {
+                facts.l3CacheBytes = size;
+            }
+        }
+
+        int nodes = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(ProcFS::path("/sys/devices/system/node"), ec)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 && name[4] >= '0' && name[4] <= '9') {
+                ++nodes;
+            }
+        }
+        facts.numaNodes = nodes > 0 ? nodes : 1;
+    }
+
+    std::string readOsName() {
+        std::ifstream file("/etc/os-release");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.find("PRETTY_NAME") != std::string::npos) {
+                size_t equal = line.find('=');
+                if (equal != std::string::npos) {
+                    std::string value = line.substr(equal + 1);
+                    if (!value.empty() && value[0] == '"') {
+                        value = value.substr(1, value.size() - 2);
+                    }
+                    return value;
+                }
+            }
+        }
+        return "Linux";
+    }
+
+    uint64_t readTotalRamBytes() {
+        std::ifstream file(ProcFS::path("/proc/meminfo"));
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, 9, "MemTotal:") == 0) {
+                std::istringstream iss(line);
+                std::string key;
+                uint64_t kb = 0;
+                iss >> key >> kb;
+                return kb * 1024;
+            }
+        }
+        return 0;
+    }
+#endif
+
+    HostFacts collectHostFacts() {
+        HostFacts facts;
+#ifdef _WIN32
+        facts.osName = getOSName();
+        facts.cpuModel = getCPUModel();
+        SYSTEM_INFO sysInfo;
+        GetSystemInfo(&sysInfo);
+        facts.threads = static_cast<int>(sysInfo.dwNumberOfProcessors);
+        facts.cores = facts.threads;
+        facts.sockets = 1;
+        facts.numaNodes = 1;
+        MEMORYSTATUSEX memInfo;
+        memInfo.dwLength = sizeof(MEMORYSTATUSEX);
+        if (GlobalMemoryStatusEx(&memInfo)) {
+            facts.totalRamBytes = memInfo.ullTotalPhys;
+        }
+#else
+        facts.osName = readOsName();
+        collectCpuInfo(facts);
+        if (facts.cpuModel.empty()) {
+            facts.cpuModel = "Unknown";
+        }
+        collectTopology(facts);
+        facts.totalRamBytes = readTotalRamBytes();
+#endif
+        return facts;
+    }
+
+#ifndef _WIN32
+    void statMount(MountUsage& mount) {
+        struct statvfs st;
+        if (statvfs(mount.mountPoint.c_str(), &st) != 0) {
+            mount.failed = true;
+            return;
+        }
+        uint64_t blockSize = st.f_frsize ? st.f_frsize : st.f_bsize;
+        mount.totalBytes = static_cast<uint64_t>(st.f_blocks) * blockSize;
+        mount.availableBytes = static_cast<uint64_t>(st.f_bavail) * blockSize;
+        uint64_t usedBytes = static_cast<uint64_t>(st.f_blocks - st.f_bfree) * blockSize;
+        // Same figure as df: used / (used + available to unprivileged users)
+        uint64_t usable = usedBytes + mount.availableBytes;
+        mount.usagePercent = usable ? (double)usedBytes / usable * 100.0 : 0.0;
+        mount.totalInodes = st.f_files;
+        mount.freeInodes = st.f_ffree;
+        mount.inodeUsagePercent = st.f_files
+            ? (double)(st.f_files - st.f_ffree) / st.f_files * 100.0
+            : 0.0;
+    }
+
+    // Returns the pending statvfs for a mount, starting one only when the last
+    // has answered, so a hung mount holds one stuck thread however often it is polled
+    std::shared_future<MountUsage> queryMount(const MountUsage& mount) {
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::shared_future<MountUsage>> inFlight;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& query = inFlight[mount.mountPoint];
+        if (query.valid() && query.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return query;
+        }
+        auto promise = std::make_shared<std::promise<MountUsage>>();
+        query = promise->get_future().share();
+        std::thread([promise](MountUsage request) {
+            statMount(request);
+            promise->set_value(request);
+        }, mount).detach();
+        return query;
+    }
+#endif
+} // namespace
+
+    bool HostFacts::hasFlag(const std::string& flag) const {
+        return std::binary_search(cpuFlags.begin(), cpuFlags.end(), flag);
+    }
+
+    // Returns the host facts, collected once; static initialisation is thread-safe
+    const HostFacts& getHostFacts() {
+        static const HostFacts facts = collectHostFacts();
+        return facts;
+    }
 
     // Returns the operating system name
     std::string getOSName() {
@@ -45,22 +327,7 @@ namespace SystemInfo {
         }
         return "Unknown";
 #else
-    // Linux implementation reading /etc/os-release
-        std::ifstream file("/etc/os-release");
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.find("PRETTY_NAME") != std::string::npos) {
-                size_t equal = line.find('=');
-                if (equal != std::string::npos) {
-                    std::string value = line.substr(equal + 1);
-                    if (!value.empty() && value[0] == '"') {
-                        value = value.substr(1, value.size() - 2);
-                    }
-                    return value;
-                }
-            }
-        }
-        return "Linux";
+        return getHostFacts().osName;
 #endif
     }
 
@@ -78,18 +345,7 @@ namespace SystemInfo {
         return std::string(brand);
 
 #else
-        // Linux implementation reading /proc/cpuinfo
-        std::ifstream file("/proc/cpuinfo");
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.find("model name") != std::string::npos) {
-                size_t colon = line.find(':');
-                if (colon != std::string::npos) {
-                    return line.substr(colon + 2);
-                }
-            }
-        }
-        return "Unknown";
+        return getHostFacts().cpuModel;
 #endif
     }
 
@@ -104,22 +360,14 @@ namespace SystemInfo {
         oss << std::fixed << std::setprecision(2) << ramGB << " GB";
         return oss.str();
 #else
-        // Linux implementation reading /proc/meminfo
-        std::ifstream file("/proc/meminfo");
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.find("MemTotal") != std::string::npos) {
-                std::istringstream iss(line);
-                std::string key, value, unit;
-                iss >> key >> value >> unit;
-                long mem_kb = std::stol(value);
-                double mem_gb = mem_kb / (1024.0 * 1024.0);
-                std::ostringstream oss;
-                oss << std::fixed << std::setprecision(2) << mem_gb << " GB";
-                return oss.str();
-            }
+        uint64_t totalBytes = getHostFacts().totalRamBytes;
+        if (totalBytes == 0) {
+            return "Unknown";
         }
-        return "Unknown";
+        double mem_gb = totalBytes / (1024.0 * 1024.0 * 1024.0);
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(2) << mem_gb << " GB";
+        return oss.str();
 #endif
     }
 
@@ -148,13 +396,33 @@ namespace SystemInfo {
         return static_cast<int>(GetTickCount64() / 1000);
 #else
         // Linux implementation reading /proc/uptime
-        std::ifstream file("/proc/uptime");
-        double uptime_seconds;
-        file >> uptime_seconds;
+        std::string& buffer = sourceBuffer();
+        if (!ProcFS::readSource("/proc/uptime", buffer)) {
+            return 0;
+        }
+        double uptime_seconds = std::strtod(buffer.c_str(), nullptr);
         return static_cast<int>(uptime_seconds);
 #endif
     }
 
+    // Returns the host name
+    std::string getHostName() {
+#ifdef _WIN32
+        char buffer[MAX_COMPUTERNAME_LENGTH + 1];
+        DWORD size = sizeof(buffer);
+        if (GetComputerNameA(buffer, &size)) {
+            return std::string(buffer);
+        }
+        return "Unknown";
+#else
+        char buffer[256] = {};
+        if (gethostname(buffer, sizeof(buffer) - 1) == 0) {
+            return std::string(buffer);
+        }
+        return "Unknown";
+#endif
+    }
+
     // Returns the current user name
     std::string getUserName() {
 #ifdef _WIN32
@@ -174,63 +442,105 @@ namespace SystemInfo {
 #endif
     }
 
-    // Returns the CPU usage percentage
-    double getCPUusage() {
+namespace {
+    // Reads cumulative idle and total CPU time since boot
+    bool readCpuTimes(uint64_t& idle, uint64_t& total) {
 #ifdef _WIN32
-        auto readCpuTimes = [](uint64_t& idle, uint64_t& total) -> bool {
-            FILETIME idleTime, kernelTime, userTime;
-            if (!GetSystemTimes(&idleTime, &kernelTime, &userTime)) {
-                return false;
+        FILETIME idleTime, kernelTime, userTime;
+        if (!GetSystemTimes(&idleTime, &kernelTime, &userTime)) {
+            return false;
+        }
+        ULARGE_INTEGER idleUi, kernelUi, userUi;
+        idleUi.LowPart   = idleTime.dwLowDateTime;
+        idleUi.HighPart  = idleTime.dwHighDateTime;
+        kernelUi.LowPart = kernelTime.dwLowDateTime;
+        kernelUi.HighPart= kernelTime.dwHighDateTime;
+        userUi.LowPart   = userTime.dwLowDateTime;
+        userUi.HighPart  = userTime.dwHighDateTime;
+        idle = idleUi.QuadPart;
+        total = kernelUi.QuadPart + userUi.QuadPart;
+        return true;
+#else
+        std::string& buffer = sourceBuffer();
+        if (!ProcFS::readSource("/proc/stat", buffer) || buffer.compare(0, 4, "cpu ") != 0) {
+            return false;
+        }
+        // The aggregate "cpu" line comes first
+        const char* p = buffer.data() + 4;
+        const char* end = ProcFS::lineEnd(p, buffer.data() + buffer.size());
+        uint64_t user = ProcFS::parseU64(p, end);
+        uint64_t nice = ProcFS::parseU64(p, end);
+        uint64_t system = ProcFS::parseU64(p, end);
+        uint64_t idleRaw = ProcFS::parseU64(p, end);
+        uint64_t iowait = ProcFS::parseU64(p, end);
+        uint64_t irq = ProcFS::parseU64(p, end);
+        uint64_t softirq = ProcFS::parseU64(p, end);
+        uint64_t steal = ProcFS::parseU64(p, end);
+        uint64_t guest = ProcFS::parseU64(p, end);
+        uint64_t guestNice = ProcFS::parseU64(p, end);
+        uint64_t idleAll = idleRaw + iowait;
+        total = user + nice + system + idleRaw + iowait + irq + softirq + steal + guest + guestNice;
+        idle = idleAll;
+        return true;
+#endif
+    }
+} // namespace
+
+    bool CpuSampler::sample() {
+        uint64_t idle = 0, total = 0;
+        if (!readCpuTimes(idle, total)) {
+            return false;
+        }
+        // Inside a cgroup with a CPU quota, usage is measured against the quota
+        const Cgroup::Sampler& cgroup = shared ? *shared : own;
+        bool quota = (shared || own.sample()) && cgroup.ready() && cgroup.cpuLimit().limited;
+        if (samples > 0) {
+            if (quota) {
+                double quotaUsage = cgroup.rates().cpuQuotaPercent;
+                current = quotaUsage > 100.0 ? 100.0 : quotaUsage;
+            } else {
+                uint64_t idleDiff = idle - previousIdle;
+                uint64_t totalDiff = total - previousTotal;
+                current = totalDiff ? (1.0 - (double)idleDiff / totalDiff) * 100.0 : 0.0;
             }
-            ULARGE_INTEGER idleUi, kernelUi, userUi;
-            idleUi.LowPart   = idleTime.dwLowDateTime;
-            idleUi.HighPart  = idleTime.dwHighDateTime;
-            kernelUi.LowPart = kernelTime.dwLowDateTime;
-            kernelUi.HighPart= kernelTime.dwHighDateTime;
-            userUi.LowPart   = userTime.dwLowDateTime;
-            userUi.HighPart  = userTime.dwHighDateTime;
-            idle = idleUi.QuadPart;
-            total = kernelUi.QuadPart + userUi.QuadPart;
-            return true;
-        };
+        }
+        previousIdle = idle;
+        previousTotal = total;
+        ++samples;
+        return true;
+    }
 
-        uint64_t idle1 = 0, total1 = 0, idle2 = 0, total2 = 0;
-        if (!readCpuTimes(idle1, total1)) return 0.0;
+    // Returns the CPU usage percentage over a 200 ms window
+    double getCPUusage() {
+        CpuSampler sampler;
+        if (!sampler.sample()) return 0.0;
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
-        if (!readCpuTimes(idle2, total2)) return 0.0;
+        if (!sampler.sample()) return 0.0;
+        return sampler.usage();
+    }
 
-        uint64_t idleDiff = idle2 - idle1;
-        uint64_t totalDiff = total2 - total1;
-        if (totalDiff == 0) return 0.0;
+    // Returns the number of logical CPUs
+    int getCPUCount() {
+        int count = getHostFacts().threads;
+        return count > 0 ? count : 1;
+    }
 
-        return (1.0 - (double)idleDiff / totalDiff) * 100.0;
+    // Fills the 1, 5 and 15 minute load averages; returns false if unavailable
+    bool getLoadAverage(double& load1, double& load5, double& load15) {
+#ifdef _WIN32
+        load1 = load5 = load15 = 0.0;
+        return false;
 #else
-        auto readCpuTimes = [](uint64_t& idle, uint64_t& total) -> bool {
-            std::ifstream file("/proc/stat");
-            std::string line;
-            if (!std::getline(file, line)) {
-                return false;
-            }
-            std::istringstream iss(line);
-            std::string cpu;
-            uint64_t user = 0, nice = 0, system = 0, idleRaw = 0, iowait = 0, irq = 0, softirq = 0;
-            uint64_t steal = 0, guest = 0, guestNice = 0;
-            iss >> cpu >> user >> nice >> system >> idleRaw >> iowait >> irq >> softirq >> steal >> guest >> guestNice;
-            uint64_t idleAll = idleRaw + iowait;
-            total = user + nice + system + idleRaw + iowait + irq + softirq + steal + guest + guestNice;
-            idle = idleAll;
+        std::string& buffer = sourceBuffer();
+        if (ProcFS::readSource("/proc/loadavg", buffer) && !buffer.empty()) {
+            char* cursor = nullptr;
+            load1 = std::strtod(buffer.c_str(), &cursor);
+            load5 = std::strtod(cursor, &cursor);
+            load15 = std::strtod(cursor, nullptr);
             return true;
-        };
-
-        uint64_t idle1 = 0, total1 = 0, idle2 = 0, total2 = 0;
-        if (!readCpuTimes(idle1, total1)) return 0.0;
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
-        if (!readCpuTimes(idle2, total2)) return 0.0;
-
-        uint64_t idleDiff = idle2 - idle1;
-        uint64_t totalDiff = total2 - total1;
-        if (totalDiff == 0) return 0.0;
-        return (1.0 - (double)idleDiff / totalDiff) * 100.0;
+        }
+        load1 = load5 = load15 = 0.0;
+        return false;
 #endif
     }
 
@@ -239,12 +549,7 @@ namespace SystemInfo {
 #ifdef _WIN32
         return -1.0;
 #else
-        std::ifstream file("/sys/class/thermal/thermal_zone0/temp");
-        long tempMilliC = 0;
-        if (file >> tempMilliC) {
-            return tempMilliC / 1000.0;
-        }
-        return -1.0;
+        return Sensors::cpuTemperature(Sensors::Registry::instance().refresh());
 #endif
     }
 
@@ -259,29 +564,42 @@ namespace SystemInfo {
         }
         return 0.0;
 #else
+        // Inside a cgroup with a memory limit, the working set is measured against the limit
+        Cgroup::Memory cgroupMemory = Cgroup::readMemory();
+        if (cgroupMemory.available && cgroupMemory.max > 0) {
+            return ramUsage(0, 0, cgroupMemory);
+        }
+
         // Linux implementation version reading /proc/meminfo
-        std::ifstream file("/proc/meminfo");
-        std::string line;
+        std::string& buffer = sourceBuffer();
         // Variables to hold total and available memory
         uint64_t total = 0, available = 0;
-        while (std::getline(file, line)) {
-            if (line.find("MemTotal:") != std::string::npos) {
-                std::istringstream iss(line);
-                std::string key, value, unit;
-                iss >> key >> value >> unit;
-                total = std::stoull(value);
-            } else if (line.find("MemAvailable:") != std::string::npos) {
-                std::istringstream iss(line);
-                std::string key, value, unit;
-                iss >> key >> value >> unit;
-                available = std::stoull(value);
+        if (ProcFS::readSource("/proc/meminfo", buffer)) {
+            const char* p = buffer.data();
+            const char* end = p + buffer.size();
+            while (p < end) {
+                const char* eol = ProcFS::lineEnd(p, end);
+                if (std::strncmp(p, "MemTotal:", 9) == 0) {
+                    const char* value = p + 9;
+                    total = ProcFS::parseU64(value, eol);
+                } else if (std::strncmp(p, "MemAvailable:", 13) == 0) {
+                    const char* value = p + 13;
+                    available = ProcFS::parseU64(value, eol);
+                }
+                p = eol + 1;
             }
         }
-        // Calculate and return RAM usage percentage
-        if (total == 0) return 0.0;
-        return (1.0 - (double)available / total) * 100.0;
+        return ramUsage(total, available, cgroupMemory);
 #endif
     }
+
+    double ramUsage(uint64_t memTotal, uint64_t memAvailable, const Cgroup::Memory& cgroupMemory) {
+        if (cgroupMemory.available && cgroupMemory.max > 0) {
+            return (double)cgroupMemory.workingSet / cgroupMemory.max * 100.0;
+        }
+        if (memTotal == 0) return 0.0;
+        return (1.0 - (double)memAvailable / memTotal) * 100.0;
+    }
   
     // Returns the disk usage percentage
     double getDiskUsage() {
@@ -307,4 +625,81 @@ namespace SystemInfo {
 #endif
     }
 
+
+    // Returns usage for every real mount, querying them concurrently under a deadline
+    std::vector<MountUsage> getMounts(int timeoutMs) {
+        std::vector<MountUsage> mounts;
+#ifdef _WIN32
+        (void)timeoutMs;
+        char drives[256];
+        DWORD length = GetLogicalDriveStringsA(sizeof(drives), drives);
+        for (const char* drive = drives; length > 0 && *drive; drive += strlen(drive) + 1) {
+            if (GetDriveTypeA(drive) != DRIVE_FIXED) {
+                continue;
+            }
+            MountUsage mount;
+            mount.mountPoint = drive;
+            ULARGE_INTEGER available, total, freeBytes;
+            if (GetDiskFreeSpaceExA(drive, &available, &total, &freeBytes) && total.QuadPart > 0) {
+                mount.totalBytes = total.QuadPart;
+                mount.availableBytes = available.QuadPart;
+                mount.usagePercent = (double)(total.QuadPart - freeBytes.QuadPart) / total.QuadPart * 100.0;
+            } else {
+                mount.failed = true;
+            }
+            mounts.push_back(mount);
+        }
+        return mounts;
+#else
+        std::ifstream file(ProcFS::path("/proc/self/mountinfo"));
+        std::string line;
+        std::unordered_set<std::string> seenDevices;
+        while (std::getline(file, line)) {
+            // Format: id parent major:minor root mountpoint options [optional...] - fstype source superoptions
+            std::istringstream iss(line);
+            std::string id, parent, devId, root, mountPoint, options, token;
+            iss >> id >> parent >> devId >> root >> mountPoint >> options;
+            while (iss >> token && token != "-") {
+            }
+            std::string fsType, source;
+            iss >> fsType >> source;
+            if (fsType.empty() || isPseudoFilesystem(fsType)) {
+                continue;
+            }
+            // Bind mounts expose the same filesystem several times; report it once
+            if (!seenDevices.insert(devId).second) {
+                continue;
+            }
+            MountUsage mount;
+            mount.mountPoint = unescapeMountPath(mountPoint);
+            mount.device = source;
+            mount.fsType = fsType;
+            mounts.push_back(mount);
+        }
+
+        // statvfs can block indefinitely on a dead network filesystem, so every
+        // mount is queried on a detached thread and abandoned at the deadline; a
+        // mount still stuck from an earlier call reports timed out again
+        std::vector<std::shared_future<MountUsage>> pending;
+        pending.reserve(mounts.size());
+        for (const auto& mount : mounts) {
+            pending.push_back(queryMount(mount));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (size_t i = 0; i < mounts.size(); ++i) {
+            if (pending[i].wait_until(deadline) == std::future_status::ready) {
+                mounts[i] = pending[i].get();
+            } else {
+                mounts[i].timedOut = true;
+            }
+        }
+        return mounts;
+#endif
+    }
+
+    // Returns the fuller of block and inode usage
+    double worstUsage(const MountUsage& mount) {
+        return mount.usagePercent > mount.inodeUsagePercent ? mount.usagePercent : mount.inodeUsagePercent;
+    }
+
 }
@@ -1,29 +1,115 @@
 #pragma once 
 #include <string>
 #include <cstdint>
+#include <vector>
+#include "cgroup.h"
 
 namespace SystemInfo {
+    // Static facts about the host that do not change while the process runs
+    struct HostFacts {
+        std::string osName;
+        std::string cpuModel;
+        std::string cpuVendor;
+        int sockets = 0;
+        int cores = 0;              // Physical cores across all sockets
+        int threads = 0;            // Logical CPUs
+        int numaNodes = 0;
+        uint64_t l1dCacheBytes = 0; // Per core
+        uint64_t l1iCacheBytes = 0; // Per core
+        uint64_t l2CacheBytes = 0;  // Per core (or per cluster)
+        uint64_t l3CacheBytes = 0;  // Per shared slice, usually per socket
+        uint64_t totalRamBytes = 0;
+        std::vector<std::string> cpuFlags;
+
+        bool hasFlag(const std::string& flag) const;
+    };
+
+    // Returns the host facts, collected on first use (thread-safe) and cached for the process lifetime
+    const HostFacts& getHostFacts();
+
     // Returns the operating system name
     std::string getOSName();
 
     //Returns the CPU model name , CPU usage percentage & CPU health score
+    // (usage is against the cgroup v2 cpu.max quota when one is set)
     std::string getCPUModel();
     double getCPUusage();
+
+    // Measures CPU usage between consecutive samples without sleeping; the first
+    // sample only primes the counters. Inside a cgroup with a cpu.max quota,
+    // usage is reported against the quota.
+    class CpuSampler {
+    public:
+        CpuSampler() = default;
+
+        // Takes the quota usage from a cgroup sampler the caller samples just before
+        // each sample(), so cpu.stat is read once per tick
+        explicit CpuSampler(const Cgroup::Sampler* shared) : shared(shared) {}
+
+        bool sample();
+        bool ready() const { return samples >= 2; }
+        double usage() const { return current; }
+
+    private:
+        uint64_t previousIdle = 0;
+        uint64_t previousTotal = 0;
+        double current = 0.0;
+        int samples = 0;
+        Cgroup::Sampler own;
+        const Cgroup::Sampler* shared = nullptr;
+    };
     
     // Returns CPU temperature in Celsius, or -1.0 if unavailable
     double getCpuTemperatureC();
 
+    // Returns the number of logical CPUs
+    int getCPUCount();
+
+    // Fills the 1, 5 and 15 minute load averages; returns false if unavailable
+    bool getLoadAverage(double& load1, double& load5, double& load15);
+
     // Returns the ram size in GB , RAM usage percentage & RAM health score
+    // (usage is against the cgroup v2 memory.max limit when one is set)
     std::string getRam();
     double getRamUsage();
 
+    // RAM usage from values already read: the cgroup working set against memory.max
+    // when one is set, else MemAvailable against MemTotal (both in the same unit)
+    double ramUsage(uint64_t memTotal, uint64_t memAvailable, const Cgroup::Memory& cgroupMemory);
+
     // Returns the total physical disk size in GB & disk health score
     uint64_t getDisk();
     double getDiskUsage();
 
+    // Capacity and inode usage of one mounted filesystem
+    struct MountUsage {
+        std::string mountPoint;
+        std::string device;
+        std::string fsType;
+        uint64_t totalBytes = 0;
+        uint64_t availableBytes = 0;
+        double usagePercent = 0.0;
+        uint64_t totalInodes = 0;
+        uint64_t freeInodes = 0;
+        double inodeUsagePercent = 0.0;
+        bool timedOut = false;    // statvfs did not answer before the deadline (e.g. a hung NFS server)
+        bool failed = false;
+    };
+
+    // Returns usage for every real (non-pseudo) mount. Mounts are queried
+    // concurrently and any that have not answered within timeoutMs are
+    // reported as timed out instead of stalling the caller.
+    std::vector<MountUsage> getMounts(int timeoutMs = 2000);
+
+    // Returns the fuller of block and inode usage, the figure that runs out first
+    double worstUsage(const MountUsage& mount);
+
     // Returns the uptime in seconds
     int getUptime();
 
     //Returns the current user name
     std::string getUserName();
+
+    // Returns the host name
+    std::string getHostName();
 } 
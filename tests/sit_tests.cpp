@@ -0,0 +1,951 @@
+// sit_tests.cpp unit tests for libsit: parsers, sensors, health rules, scan rules, hashing,
+// journal replay, multi-root checks, fleet aggregation, the shared-memory seqlock and the timer wheel.
+//
+// Build: cmake --build build/default --target sit_tests
+// Run:   ctest --preset default, or ./build/default/sit_tests [--filter text] [--fixtures dir]
+
+#include "fleet.h"
+#include "health.h"
+#include "integrity.h"
+#include "integrityDetail.h"
+#include "ioBudget.h"
+#include "memory.h"
+#include "netStats.h"
+#include "pressure.h"
+#include "procfs.h"
+#include "scan.h"
+#include "scheduler.h"
+#include "sensors.h"
+#include "snapshot.h"
+#include "systemInfo.h"
+#ifndef _WIN32
+#include "sharedMetrics.h"
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    namespace fs = std::filesystem;
+
+    struct Options {
+        std::string filter;
+        std::string fixtures = "bench/fixtures/linux-vm";
+    };
+
+    Options options;
+    fs::path scratch;
+    int failures = 0;
+
+    void check(bool ok, const char* expression, const char* file, int line) {
+        if (!ok) {
+            ++failures;
+            std::cerr << "  " << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+        }
+    }
+
+#define CHECK(expression) check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tolerance) check(std::fabs((a) - (b)) <= (tolerance), #a " ~ " #b, __FILE__, __LINE__)
+
+    void writeFile(const fs::path& path, const std::string& content) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string pseudoRandom(size_t size, uint64_t seed) {
+        std::string data(size, '\0');
+        uint64_t state = seed * 0x9e3779b97f4a7c15ULL + 1;
+        for (auto& byte : data) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            byte = static_cast<char>(state);
+        }
+        return data;
+    }
+
+    // A fresh directory per test, inside this run's scratch directory
+    fs::path testDirectory(const std::string& name) {
+        fs::path dir = scratch / name;
+        fs::create_directories(dir);
+        return dir;
+    }
+
+    // --- Parsers ---
+
+    void testManifestLine() {
+        using Integrity::detail::parseManifestLine;
+        std::string path;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::string hash;
+        std::string extras;
+        CHECK(parseManifestLine("dir/a b.txt\t42\t1718000000\tabcdef\tfp=0123\tlink=3", path, size, mtime, hash, &extras));
+        CHECK(path == "dir/a b.txt");
+        CHECK(size == 42);
+        CHECK(mtime == 1718000000);
+        CHECK(hash == "abcdef");
+        CHECK(extras == "fp=0123\tlink=3");
+
+        CHECK(parseManifestLine("plain\t0\t-5\tff", path, size, mtime, hash, &extras));
+        CHECK(mtime == -5);
+        CHECK(extras.empty());
+
+        CHECK(!parseManifestLine("missing-fields\t12", path, size, mtime, hash));
+        CHECK(!parseManifestLine("bad-size\tx12\t0\tff", path, size, mtime, hash));
+    }
+
+    void testManifestVersions() {
+        using Integrity::detail::ManifestEntry;
+        fs::path dir = testDirectory("manifest_versions");
+        const std::string hash = "00000000000000ff9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822c";
+        std::unordered_map<std::string, ManifestEntry> entries;
+        std::string error;
+
+        // Version 2 fingerprints were seeded from the leading 64 bits of the full hash
+        writeFile(dir / "v2", std::string(Integrity::detail::kManifestHeaderV2) + "\n"
+            "a\t100000\t1\t" + hash + "\tfp=abc\tlink=7\n");
+        CHECK(Integrity::detail::loadManifest(dir / "v2", entries, &error));
+        CHECK(entries["a"].fingerprint == "abc");
+        CHECK(entries["a"].linkGroup == 7);
+        CHECK(entries["a"].sampleSeed == 0xff);
+
+        entries.clear();
+        writeFile(dir / "v3", std::string(Integrity::detail::kManifestHeaderV3) + "\n"
+            "# comment\n\na\t100000\t1\t" + hash + "\tfp=abc\n");
+        CHECK(Integrity::detail::loadManifest(dir / "v3", entries, &error));
+        CHECK(entries.size() == 1);
+        CHECK(entries["a"].sampleSeed == 100000);
+
+        // Version 4 seeds each file from its path as well, so equal sizes sample differently
+        entries.clear();
+        writeFile(dir / "v4", std::string(Integrity::detail::kManifestHeader) + "\n"
+            "a\t100000\t1\t" + hash + "\tfp=abc\nb\t100000\t1\t" + hash + "\tfp=abc\n");
+        CHECK(Integrity::detail::loadManifest(dir / "v4", entries, &error));
+        CHECK(entries["a"].sampleSeed == Integrity::detail::fileSeed("a", 100000));
+        CHECK(entries["a"].sampleSeed != entries["b"].sampleSeed);
+
+        writeFile(dir / "unknown", "# SIT-INTEGRITY-9 MD5\n");
+        CHECK(!Integrity::detail::loadManifest(dir / "unknown", entries, &error));
+        CHECK(error == "Integrity manifest format not recognized.");
+
+        writeFile(dir / "broken", std::string(Integrity::detail::kManifestHeader) + "\nonly-a-path\n");
+        CHECK(!Integrity::detail::loadManifest(dir / "broken", entries, &error));
+        CHECK(error == "Integrity manifest parse error on line 2.");
+    }
+
+    void testParseRate() {
+        CHECK(IoBudget::parseRate("500") == 500);
+        CHECK(IoBudget::parseRate("20M") == 20ULL * 1024 * 1024);
+        CHECK(IoBudget::parseRate("1.5k") == 1536);
+        CHECK(IoBudget::parseRate("2GB") == 2ULL * 1024 * 1024 * 1024);
+        CHECK(IoBudget::parseRate("") == 0);
+        CHECK(IoBudget::parseRate("-1M") == 0);
+        CHECK(IoBudget::parseRate("10X") == 0);
+    }
+
+    void testHealthConfig() {
+        fs::path dir = testDirectory("health_config");
+        Health::Config config = Health::defaultConfig();
+        std::string error;
+        writeFile(dir / "ok.conf", "# tuned for a database host\n"
+            "cpu_usage.warn = 70\n cpu_usage.crit=95 \nmemory_pressure.weight = 4\ndisk_io.veto = 1\n");
+        CHECK(Health::loadConfig(dir / "ok.conf", config, &error));
+        for (const auto& rule : config.rules) {
+            if (rule.metric == Health::Metric::CpuUsage) {
+                CHECK(rule.warn == 70.0 && rule.crit == 95.0);
+            } else if (rule.metric == Health::Metric::MemoryPressure) {
+                CHECK(rule.weight == 4.0);
+            } else if (rule.metric == Health::Metric::DiskIOUtilization) {
+                CHECK(rule.veto);
+            }
+        }
+
+        writeFile(dir / "unknown.conf", "cpu_usage.warn = 70\nfan_speed.warn = 3\n");
+        CHECK(!Health::loadConfig(dir / "unknown.conf", config, &error));
+        CHECK(error == "Unknown health rule 'fan_speed' on line 2.");
+
+        writeFile(dir / "field.conf", "cpu_usage.colour = 3\n");
+        CHECK(!Health::loadConfig(dir / "field.conf", config, &error));
+        CHECK(error == "Unknown field 'colour' on line 1.");
+
+        writeFile(dir / "number.conf", "cpu_usage.warn = lots\n");
+        CHECK(!Health::loadConfig(dir / "number.conf", config, &error));
+        CHECK(error == "Invalid number on line 1.");
+    }
+
+#ifndef _WIN32
+    // The recorded fixtures are read through the same ProcFS root the benchmarks use
+    void testProcFixtures() {
+        if (!fs::exists(fs::path(options.fixtures) / "proc" / "stat")) {
+            std::cerr << "  skipped: no fixtures at " << options.fixtures << std::endl;
+            return;
+        }
+        ProcFS::setRoot(options.fixtures);
+
+        Pressure::Stall cpu = Pressure::read("cpu");
+        CHECK(cpu.available);
+        CHECK_NEAR(cpu.someAvg10, 1.39, 1e-9);
+        CHECK_NEAR(cpu.someAvg60, 1.82, 1e-9);
+        CHECK_NEAR(cpu.fullAvg10, 0.0, 1e-9);
+
+        double load1 = 0.0;
+        double load5 = 0.0;
+        double load15 = 0.0;
+        CHECK(SystemInfo::getLoadAverage(load1, load5, load15));
+        CHECK_NEAR(load1, 0.65, 1e-9);
+        CHECK_NEAR(load15, 0.29, 1e-9);
+
+        Memory::Sampler memory;
+        CHECK(memory.sample());
+        CHECK(memory.info().available);
+        CHECK(memory.info().memTotal == 6147400ULL * 1024);
+        CHECK(memory.info().memAvailable == 5668628ULL * 1024);
+
+        ProcFS::setRoot("");
+    }
+
+    // A recorded sysfs tree: two SMT siblings, a second core and a second package
+    void testSensorsRegistry() {
+        fs::path root = testDirectory("sensors");
+        auto zone = root / "sys/class/thermal/thermal_zone0";
+        fs::create_directories(zone);
+        writeFile(zone / "type", "acpitz\n");
+        writeFile(zone / "temp", "40000\n");
+        auto hwmon = root / "sys/class/hwmon/hwmon0";
+        fs::create_directories(hwmon);
+        writeFile(hwmon / "name", "coretemp\n");
+        writeFile(hwmon / "temp2_input", "61000\n");
+        writeFile(hwmon / "temp2_label", "Core 0\n");
+        fs::create_directories(root / "sys/devices/system/cpu/cpufreq");
+        struct Cpu {
+            const char* name;
+            const char* package;
+            const char* core;
+            const char* coreCount;
+            const char* packageCount;
+        };
+        for (const Cpu& cpu : { Cpu{ "cpu0", "0", "0", "7", "100" }, Cpu{ "cpu1", "0", "0", "7", "100" },
+                                Cpu{ "cpu2", "0", "1", "3", "100" }, Cpu{ "cpu3", "1", "0", "5", "20" } }) {
+            auto dir = root / "sys/devices/system/cpu" / cpu.name;
+            fs::create_directories(dir / "topology");
+            fs::create_directories(dir / "thermal_throttle");
+            writeFile(dir / "topology" / "physical_package_id", cpu.package);
+            writeFile(dir / "topology" / "core_id", cpu.core);
+            writeFile(dir / "thermal_throttle" / "core_throttle_count", cpu.coreCount);
+            writeFile(dir / "thermal_throttle" / "package_throttle_count", cpu.packageCount);
+        }
+
+        ProcFS::setRoot(root.string());
+        Sensors::Registry registry;
+        ProcFS::setRoot("");
+        std::vector<Sensors::Sensor> readings = registry.refresh();
+        CHECK(readings.size() == 2);
+        CHECK_NEAR(Sensors::cpuTemperature(readings), 61.0, 1e-9);
+        readings.pop_back();
+        CHECK_NEAR(Sensors::cpuTemperature(readings), 40.0, 1e-9);     // No CPU sensor; zone0 instead
+
+        Sensors::Throttle throttle = registry.throttle();
+        CHECK(throttle.available);
+        CHECK(throttle.coreEvents == 15);       // cpu1 shares cpu0's core counter
+        CHECK(throttle.packageEvents == 120);   // Summed over the two packages
+    }
+
+    // Interfaces that move between lines keep their counters; new ones start without rates
+    void testNetDevRows() {
+        fs::path root = testDirectory("netdev");
+        fs::create_directories(root / "proc/net");
+        const char* header =
+            "Inter-|   Receive                            |  Transmit\n"
+            " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+        writeFile(root / "proc/net/dev", std::string(header) +
+            "    lo: 100 1 0 0 0 0 0 0 100 1 0 0 0 0 0 0\n"
+            "  eth0: 1000 10 0 0 0 0 0 0 500 5 0 0 0 0 0 0\n");
+
+        ProcFS::setRoot(root.string());
+        NetStats::Sampler sampler;
+        CHECK(sampler.sample());
+        CHECK(sampler.interfaces().size() == 2);
+
+        writeFile(root / "proc/net/dev", std::string(header) +
+            "  eth0: 3000 20 0 0 0 0 0 0 500 5 0 0 0 0 0 0\n"
+            " wlan0: 900 9 0 0 0 0 0 0 900 9 0 0 0 0 0 0\n"
+            "    lo: 100 1 0 0 0 0 0 0 100 1 0 0 0 0 0 0\n");
+        CHECK(sampler.sample());
+        ProcFS::setRoot("");
+
+        const std::vector<NetStats::Interface>& interfaces = sampler.interfaces();
+        CHECK(interfaces.size() == 3);
+        CHECK(interfaces.size() == 3 && interfaces[0].name == "eth0" && interfaces[0].rxBytesPerSec > 0.0);
+        CHECK(interfaces.size() == 3 && interfaces[1].name == "wlan0" && interfaces[1].rxBytesPerSec == 0.0);
+        CHECK(interfaces.size() == 3 && interfaces[2].name == "lo" && interfaces[2].rxBytesPerSec == 0.0);
+    }
+#endif
+
+    // --- Health rules ---
+
+    Health::Inputs idleInputs() {
+        Health::Inputs inputs;
+        inputs.set(Health::Metric::CpuUsage, 20.0);
+        inputs.set(Health::Metric::RamUsage, 30.0);
+        inputs.set(Health::Metric::DiskUsage, 40.0);
+        inputs.set(Health::Metric::CpuPressure, 0.0);
+        inputs.set(Health::Metric::MemoryPressure, 0.0);
+        inputs.set(Health::Metric::IoPressure, 0.0);
+        inputs.set(Health::Metric::LoadPerCore, 0.3);
+        return inputs;
+    }
+
+    void testHealthIdle() {
+        Health::Report report = Health::evaluate(idleInputs());
+        CHECK(report.score == 100);
+        CHECK(report.status == Health::Status::Good);
+        CHECK(report.factorCount == 7);
+        CHECK(report.cappedBy == -1);
+
+        Health::Report empty = Health::evaluate(Health::Inputs());
+        CHECK(empty.score == 100);
+        CHECK(empty.factorCount == 0);
+    }
+
+    // One stalled resource must not be averaged away by idle ones
+    void testHealthVeto() {
+        Health::Inputs stalled = idleInputs();
+        stalled.set(Health::Metric::CpuUsage, 60.0);
+        stalled.set(Health::Metric::MemoryPressure, 100.0);
+        Health::Report report = Health::evaluate(stalled);
+        CHECK(report.status == Health::Status::Critical);
+        CHECK(report.score < 60);
+        CHECK(report.cappedBy >= 0);
+        CHECK(report.factors[report.cappedBy].metric == Health::Metric::MemoryPressure);
+
+        Health::Inputs contended = idleInputs();
+        contended.set(Health::Metric::CpuUsage, 100.0);
+        contended.set(Health::Metric::CpuPressure, 90.0);
+        contended.set(Health::Metric::LoadPerCore, 8.0);
+        contended.set(Health::Metric::RunQueueWait, 90.0);
+        CHECK(Health::evaluate(contended).status == Health::Status::Critical);
+
+        // A pressure just above warn makes the host Moderate, not Critical
+        Health::Inputs warm = idleInputs();
+        warm.set(Health::Metric::IoPressure, 15.0);
+        Health::Report moderate = Health::evaluate(warm);
+        CHECK(moderate.status == Health::Status::Moderate);
+
+        // Busy without contention is not an alert
+        Health::Inputs busy = idleInputs();
+        busy.set(Health::Metric::CpuUsage, 95.0);
+        CHECK(Health::evaluate(busy).status == Health::Status::Good);
+
+        // Utilisation rules do not veto unless configured to
+        Health::Config config = Health::defaultConfig();
+        for (auto& rule : config.rules) {
+            rule.veto = false;
+        }
+        CHECK(Health::evaluate(stalled, config).cappedBy == -1);
+    }
+
+    void testHealthBoundaries() {
+        using Health::Metric;
+        using Health::Status;
+        CHECK(Health::status(Metric::CpuUsage, 50.0) == Status::Good);
+        CHECK(Health::status(Metric::CpuUsage, 50.1) == Status::Moderate);
+        CHECK(Health::status(Metric::CpuUsage, 79.9) == Status::Moderate);
+        CHECK(Health::status(Metric::CpuUsage, 80.0) == Status::Critical);
+
+        // Score, status and reason agree at the warn value
+        Health::Inputs inputs;
+        inputs.set(Metric::CpuUsage, 50.0);
+        Health::Report report = Health::evaluate(inputs);
+        CHECK(report.factors[0].score == 100);
+        CHECK(report.factors[0].status == Status::Good);
+        std::ostringstream reason;
+        Health::writeReason(reason, report.factors[0]);
+        CHECK(reason.str() == "50.0% is within the normal range (warn at 50.0%)");
+
+        inputs.set(Metric::CpuUsage, 85.0);
+        report = Health::evaluate(inputs);
+        reason.str("");
+        Health::writeReason(reason, report.factors[0]);
+        CHECK(reason.str() == "85.0% is at or above the critical level of 80.0%");
+        CHECK(report.factors[0].status == Status::Critical);
+
+        // writeReason leaves the stream's formatting as it found it
+        std::ostringstream out;
+        Health::writeReason(out, report.factors[0]);
+        out << 1.0 / 3.0;
+        CHECK(out.str().substr(out.str().size() - 8) == "0.333333");
+
+        // Mounts that never answered say nothing about the disk
+        std::vector<SystemInfo::MountUsage> mounts(2);
+        mounts[0].timedOut = true;
+        mounts[1].failed = true;
+        CHECK(Health::Diskhp(mounts) == Status::Unknown);
+        mounts[1].failed = false;
+        mounts[1].usagePercent = 95.0;
+        CHECK(Health::Diskhp(mounts) == Status::Critical);
+    }
+
+    // --- Scan rules ---
+
+    void testScanMounts() {
+        auto snapshot = std::make_unique<Metrics::Snapshot>();
+        snapshot->mountCount = 3;
+        Metrics::copyString(snapshot->mounts[0].mountPoint, "/var");
+        snapshot->mounts[0].usagePercent = 93.0;
+        Metrics::copyString(snapshot->mounts[1].mountPoint, "/home");
+        snapshot->mounts[1].usagePercent = 85.0;
+        snapshot->mounts[1].inodeUsagePercent = 95.0;
+        Metrics::copyString(snapshot->mounts[2].mountPoint, "/mnt/nfs");
+        Metrics::copyString(snapshot->mounts[2].device, "server:/export");
+        snapshot->mounts[2].timedOut = 1;
+
+        auto result = std::make_unique<Scan::Result>();
+        Scan::scan(*snapshot, *result);
+        int almostFull = 0;
+        int fillingUp = 0;
+        int inodes = 0;
+        int hung = 0;
+        for (int i = 0; i < result->count; ++i) {
+            const Scan::Finding& finding = result->findings[i];
+            switch (finding.problem) {
+            case Scan::Problem::MountAlmostFull:
+                ++almostFull;
+                CHECK(finding.severity == Scan::Severity::Critical);
+                CHECK(std::strcmp(finding.subject, "/var") == 0);
+                break;
+            case Scan::Problem::MountFillingUp:
+                ++fillingUp;
+                CHECK(finding.severity == Scan::Severity::Warning);
+                break;
+            case Scan::Problem::MountOutOfInodes:
+                ++inodes;
+                break;
+            case Scan::Problem::MountNotResponding:
+                ++hung;
+                CHECK(std::strcmp(finding.device, "server:/export") == 0);
+                break;
+            default:
+                break;
+            }
+        }
+        CHECK(almostFull == 1 && fillingUp == 1 && inodes == 1 && hung == 1);
+
+        for (int i = 0; i < result->count; ++i) {
+            if (result->findings[i].problem == Scan::Problem::MountAlmostFull) {
+                std::ostringstream message;
+                Scan::writeMessage(message, result->findings[i]);
+                CHECK(message.str() == "Mount /var almost full (93%)");
+                CHECK(std::strcmp(Scan::problemKey(Scan::Problem::MountAlmostFull), "mount_almost_full") == 0);
+            }
+        }
+    }
+
+    void testScanThermalThrottling() {
+        auto snapshot = std::make_unique<Metrics::Snapshot>();
+        snapshot->throttleAvailable = 1;
+        snapshot->coreThrottleEvents = 5000;       // Throttled at some point since boot
+        snapshot->packageThrottleEvents = 300;
+        auto throttling = [&] {
+            auto result = std::make_unique<Scan::Result>();
+            Scan::scan(*snapshot, *result);
+            for (int i = 0; i < result->count; ++i) {
+                if (result->findings[i].problem == Scan::Problem::ThermalThrottling) {
+                    std::ostringstream message;
+                    Scan::writeMessage(message, result->findings[i]);
+                    return message.str();
+                }
+            }
+            return std::string();
+        };
+        CHECK(throttling().empty());                // No rate yet
+        snapshot->ratesReady.throttle = 1;
+        CHECK(throttling().empty());                // Counters have not moved since the last sample
+        snapshot->coreThrottlePerSec = 2.5;
+        CHECK(throttling() == "CPU thermal throttling (3 core, 0 package events/s)");
+    }
+
+    // Each rate section is gated by its own sampler, not by the CPU sampler's
+    void testScanRatesReady() {
+        auto snapshot = std::make_unique<Metrics::Snapshot>();
+        snapshot->threads = 4;
+        snapshot->sched.schedstatAvailable = true;
+        snapshot->sched.runQueueWaitPercent = 60.0;
+        snapshot->interfaceCount = 1;
+        Metrics::copyString(snapshot->interfaces[0].name, "eth0");
+        snapshot->interfaces[0].rxDropsPerSec = 5.0;
+        auto found = [&](Scan::Problem problem) {
+            auto result = std::make_unique<Scan::Result>();
+            Scan::scan(*snapshot, *result);
+            for (int i = 0; i < result->count; ++i) {
+                if (result->findings[i].problem == problem) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        CHECK(!found(Scan::Problem::SevereCpuContention));
+        snapshot->ratesReady.sched = 1;             // The CPU sampler has not primed yet
+        CHECK(found(Scan::Problem::SevereCpuContention));
+        snapshot->ratesReady.disk = 1;
+        CHECK(!found(Scan::Problem::InterfaceDrops));
+        snapshot->ratesReady.net = 1;
+        CHECK(found(Scan::Problem::InterfaceDrops));
+        CHECK(!snapshot->ratesReady.all());
+
+        // Wait is summed over tasks, so a long queue goes past 100%
+        snapshot->sched.runQueueWaitPercent = 250.0;
+        auto result = std::make_unique<Scan::Result>();
+        Scan::scan(*snapshot, *result);
+        std::string message;
+        for (int i = 0; i < result->count; ++i) {
+            if (result->findings[i].problem == Scan::Problem::SevereCpuContention) {
+                std::ostringstream out;
+                Scan::writeMessage(out, result->findings[i]);
+                message = out.str();
+            }
+        }
+        CHECK(message == "Severe CPU contention (run-queue wait 250% per CPU, 100% = one task always waiting)");
+    }
+
+    // --- Integrity ---
+
+    void testSha256() {
+        Integrity::detail::Sha256 hasher;
+        CHECK(hasher.finalHex() == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        hasher.update(reinterpret_cast<const uint8_t*>("abc"), 3);
+        CHECK(hasher.finalHex() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+        // Split updates across the 64 byte block boundary give the same digest
+        const std::string text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+        hasher.update(reinterpret_cast<const uint8_t*>(text.data()), 20);
+        hasher.update(reinterpret_cast<const uint8_t*>(text.data()) + 20, text.size() - 20);
+        CHECK(hasher.finalHex() == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    }
+
+    // The fingerprint taken during the full hash matches a later sampled read
+    void testFingerprint() {
+        fs::path dir = testDirectory("fingerprint");
+        const uint64_t size = 3 * 1000 * 1000 + 123;        // Short last block
+        writeFile(dir / "large", pseudoRandom(size, 1));
+        writeFile(dir / "small", pseudoRandom(1000, 2));
+
+        std::string fingerprint;
+        std::string error;
+        const uint64_t seed = Integrity::detail::fileSeed("large", size);
+        std::string hash = Integrity::detail::hashFileSha256(dir / "large", &error, nullptr, &fingerprint, size, seed);
+        CHECK(hash.size() == 64);
+        CHECK(hash == Integrity::detail::hashFileSha256(dir / "large", &error));
+        CHECK(!fingerprint.empty());
+        CHECK(fingerprint == Integrity::detail::sampleFingerprint(dir / "large", size, seed, &error));
+
+        std::vector<uint64_t> blocks = Integrity::detail::sampleBlocks(size, seed);
+        CHECK(blocks.front() == 0);
+        CHECK(blocks.back() == (size - 1) / Integrity::detail::kSampleBlockSize);
+        CHECK(blocks != Integrity::detail::sampleBlocks(size, Integrity::detail::fileSeed("large2", size)));
+
+        CHECK(!Integrity::detail::hashFileSha256(dir / "small", &error, nullptr, &fingerprint, 1000).empty());
+        CHECK(fingerprint.empty());
+
+        // A file that shrank since it was measured has no complete fingerprint
+        CHECK(Integrity::detail::hashFileSha256(dir / "large", &error, nullptr, &fingerprint, size + 100000, seed).empty());
+    }
+
+    void testCheckDetectsChanges() {
+        fs::path root = testDirectory("check");
+        fs::create_directories(root / "sub");
+        writeFile(root / "keep", "unchanged");
+        writeFile(root / "edit", "before");
+        writeFile(root / "sub" / "gone", "soon removed");
+        std::string error;
+        CHECK(Integrity::createManifest(root, &error));
+
+        writeFile(root / "edit", "after, and longer");
+        fs::remove(root / "sub" / "gone");
+        writeFile(root / "sub" / "fresh", "new file");
+
+        // A check that ran succeeds; what it found is in the result
+        Integrity::CheckResult result;
+        CHECK(Integrity::checkManifest(root, result, &error));
+        CHECK(result.total == 3);
+        CHECK(result.ok == 1);
+        CHECK(result.changed == 1);
+        CHECK(result.missing == 1);
+        CHECK(result.added == 1);
+        bool sawEdit = false;
+        for (const auto& issue : result.issues) {
+            if (result.path(issue) == "edit") {
+                sawEdit = true;
+                CHECK(issue.status == Integrity::Status::Changed);
+                CHECK(issue.reason == Integrity::Reason::SizeChanged);
+            }
+        }
+        CHECK(sawEdit);
+
+        CHECK(Integrity::updateManifest(root, &error));
+        CHECK(Integrity::checkManifest(root, result, &error));
+        CHECK(result.total == 3 && result.ok == 3);
+    }
+
+    // Entries up to the last checkpoint are replayed; anything after it is redone
+    void testJournalReplay() {
+        fs::path root = testDirectory("journal");
+        writeFile(root / "a", pseudoRandom(50000, 3));
+        writeFile(root / "b", pseudoRandom(50000, 4));
+        std::string error;
+        CHECK(Integrity::createManifest(root, &error));
+        std::unordered_map<std::string, Integrity::detail::ManifestEntry> real;
+        CHECK(Integrity::detail::loadManifest(root / Integrity::kManifestFileName, real, &error));
+        fs::remove(root / Integrity::kManifestFileName);
+
+        const std::string fake(64, 'a');
+        auto line = [&](const char* path) {
+            const auto& entry = real[path];
+            return std::string("F\t") + path + "\t" + std::to_string(entry.size) + "\t"
+                + std::to_string(entry.mtime) + "\t" + fake + "\t" + entry.fingerprint + "\n";
+        };
+        writeFile(root / Integrity::kJournalFileName,
+            "# SIT-INTEGRITY-JOURNAL-3 write\nK\n" + line("a") + "K\n" + line("b"));
+
+        Integrity::Options resume;
+        resume.resume = true;
+        CHECK(Integrity::createManifest(root, &error, resume));
+        std::unordered_map<std::string, Integrity::detail::ManifestEntry> written;
+        CHECK(Integrity::detail::loadManifest(root / Integrity::kManifestFileName, written, &error));
+        CHECK(written["a"].hash == fake);                   // Taken from the journal
+        CHECK(written["b"].hash == real["b"].hash);         // After the last checkpoint, so hashed again
+        CHECK(written["a"].fingerprint == real["a"].fingerprint);
+        CHECK(!fs::exists(root / Integrity::kJournalFileName));
+
+        // A journal whose file changed since it was recorded is not trusted for that file
+        fs::remove(root / Integrity::kManifestFileName);
+        writeFile(root / Integrity::kJournalFileName, "# SIT-INTEGRITY-JOURNAL-3 write\n"
+            "F\ta\t1\t" + std::to_string(real["a"].mtime) + "\t" + fake + "\t\nK\n");
+        CHECK(Integrity::createManifest(root, &error, resume));
+        written.clear();
+        CHECK(Integrity::detail::loadManifest(root / Integrity::kManifestFileName, written, &error));
+        CHECK(written["a"].hash == real["a"].hash);
+    }
+
+    // A run that stops after leaving a directory must still list every link inside it
+    void testJournalHardLinkResume() {
+        fs::path root = testDirectory("journal_hardlink");
+        // Two linked directories, as only the one the walk leaves first is journaled as done
+        for (const char* dir : { "a", "b" }) {
+            fs::create_directories(root / dir);
+            writeFile(root / dir / "x", pseudoRandom(20000, dir[0]));
+            fs::create_hard_link(root / dir / "x", root / dir / "y");
+        }
+
+        // A directory in the manifest's place fails the final write and leaves the journal behind
+        fs::create_directory(root / Integrity::kManifestFileName);
+        std::string error;
+        CHECK(!Integrity::updateManifest(root, &error));
+        CHECK(error == "Unable to write integrity manifest.");
+        CHECK(fs::exists(root / Integrity::kJournalFileName));
+        std::ofstream(root / Integrity::kJournalFileName, std::ios::binary | std::ios::app) << "K\n";
+        fs::remove(root / Integrity::kManifestFileName);
+
+        Integrity::Options resume;
+        resume.resume = true;
+        CHECK(Integrity::createManifest(root, &error, resume));
+        std::unordered_map<std::string, Integrity::detail::ManifestEntry> written;
+        CHECK(Integrity::detail::loadManifest(root / Integrity::kManifestFileName, written, &error));
+        CHECK(written.size() == 4);
+        for (const std::string dir : { "a", "b" }) {
+            CHECK(written.count(dir + "/y") == 1);
+            CHECK(written[dir + "/x"].hash == written[dir + "/y"].hash);
+            CHECK(written[dir + "/x"].linkGroup != 0);
+            CHECK(written[dir + "/x"].linkGroup == written[dir + "/y"].linkGroup);
+        }
+    }
+
+    void testJournalRejected() {
+        fs::path root = testDirectory("journal_rejected");
+        writeFile(root / "a", "content");
+        Integrity::Options resume;
+        resume.resume = true;
+        std::string error;
+        CHECK(!Integrity::createManifest(root, &error, resume));
+        CHECK(error == "No integrity journal to resume from.");
+
+        // Journals from older builds carry differently seeded fingerprints
+        writeFile(root / Integrity::kJournalFileName, "# SIT-INTEGRITY-JOURNAL-2 write\nK\n");
+        CHECK(!Integrity::createManifest(root, &error, resume));
+        CHECK(error == "Integrity journal belongs to a different run. Start again without --resume.");
+    }
+
+    // Several roots share one worker pool; each keeps its own outcome
+    void testCheckManifestsPool() {
+        std::vector<fs::path> roots;
+        std::string error;
+        for (int i = 0; i < 3; ++i) {
+            fs::path root = testDirectory("multi_root" + std::to_string(i));
+            for (int j = 0; j <= i * 4; ++j) {
+                writeFile(root / ("f" + std::to_string(j)), pseudoRandom(20000, static_cast<uint64_t>(i * 10 + j)));
+            }
+            CHECK(Integrity::createManifest(root, &error));
+            roots.push_back(root);
+        }
+        writeFile(roots[1] / "f2", pseudoRandom(30000, 99));
+        fs::remove(roots[2] / "f0");
+        roots.push_back(testDirectory("multi_root_unmanaged"));
+
+        Integrity::Options options;
+        options.threads = 3;
+        options.tier = Integrity::Tier::Full;
+        std::vector<Integrity::RootResult> results;
+        Integrity::CheckResult total;
+        CHECK(!Integrity::checkManifests(roots, results, total, &error, options));     // The last root has no manifest
+        CHECK(results.size() == 4);
+        if (results.size() != 4) {
+            return;
+        }
+        CHECK(results[0].ok && results[0].result.total == 1 && results[0].result.ok == 1);
+        CHECK(results[1].ok && results[1].result.total == 5 && results[1].result.changed == 1);
+        CHECK(results[2].ok && results[2].result.total == 9 && results[2].result.missing == 1);
+        CHECK(!results[3].ok && !results[3].error.empty());
+        CHECK(total.total == 15);
+        CHECK(total.ok == 13);
+        CHECK(total.changed == 1 && total.missing == 1);
+    }
+
+    // --- Fleet aggregation ---
+
+    // A directory of exports: one small file with a bad record and an integrity run, and
+    // one large enough to be split into chunks
+    void testFleetAggregate() {
+        fs::path dir = testDirectory("fleet");
+        auto snapshotLine = [](const std::string& host, double cpu) {
+            return "{\"format\":\"sit-snapshot\",\"version\":1,\"host\":\"" + host +
+                "\",\"timestamp_ms\":1,\"metrics\":{\"cpu_usage\":" + std::to_string(cpu) + "}}\n";
+        };
+        std::ostringstream small;
+        small << snapshotLine("alpha", 10.0) << snapshotLine("beta", 95.0) << "{\"format\":\"sit-other\"}\n";
+        Fleet::IntegritySummary run;
+        run.host = "alpha";
+        run.root = "/data";
+        run.tracked = 10;
+        run.ok = 7;
+        run.changed = 2;
+        run.missing = 1;
+        Fleet::writeJson(run, small);
+        writeFile(dir / "small.json", small.str());
+
+        std::string large;
+        size_t hosts = 0;
+        while (large.size() <= (3u << 20) / 2) {
+            large += snapshotLine("host" + std::to_string(hosts++), 50.0);
+        }
+        fs::create_directories(dir / "nested");
+        writeFile(dir / "nested" / "large.json", large);
+
+        Fleet::Options options;
+        options.threads = 2;
+        options.worst = 2;
+        Fleet::Report report;
+        std::string error;
+        CHECK(Fleet::aggregate(dir.string(), options, report, &error));
+        CHECK(report.inputs == 2);
+        CHECK(report.snapshots == hosts + 2);
+        CHECK(report.rejected == 1);
+        CHECK(report.integrityRuns == 1 && report.integrityRunsWithIssues == 1);
+        CHECK(report.changed == 2 && report.missing == 1);
+        CHECK(report.worstIntegrity.size() == 1 && report.worstIntegrity[0].host == "alpha:/data");
+
+        const Fleet::MetricSummary* cpu = nullptr;
+        for (const auto& summary : report.metrics) {
+            if (summary.metric == Fleet::Metric::CpuUsage) {
+                cpu = &summary;
+            }
+        }
+        CHECK(cpu != nullptr);
+        if (cpu) {
+            CHECK(cpu->hosts == hosts + 2);
+            CHECK_NEAR(cpu->min, 10.0, 1e-9);
+            CHECK_NEAR(cpu->max, 95.0, 1e-9);
+            CHECK(cpu->worst.size() == 2 && cpu->worst[0].host == "beta");
+        }
+    }
+
+    // --- Shared memory and scheduling ---
+
+#ifndef _WIN32
+    void testSeqlock() {
+        const std::string name = "/sit_tests_" + std::to_string(getpid());
+        std::string error;
+        SharedMetrics::Publisher publisher;
+        CHECK(publisher.open(name, &error));
+
+        SharedMetrics::Publisher second;
+        CHECK(!second.open(name, &error));
+        CHECK(error == "Metrics are already published at " + name + " by another process.");
+
+        SharedMetrics::Reader reader;
+        CHECK(reader.open(name, &error));
+        auto snapshot = std::make_unique<Metrics::Snapshot>();
+        CHECK(!reader.read(*snapshot, &error));     // Nothing published yet
+
+        auto published = std::make_unique<Metrics::Snapshot>();
+        published->cpuUsage = 42.5;
+        published->ramUsage = 42.5;
+        published->mountCount = 1;
+        Metrics::copyString(published->mounts[0].mountPoint, "/data");
+        publisher.publish(*published);
+        CHECK(reader.read(*snapshot, &error));
+        CHECK(snapshot->cpuUsage == 42.5);
+        CHECK(std::strcmp(snapshot->mounts[0].mountPoint, "/data") == 0);
+
+        // Readers never see a torn copy while the publisher keeps writing
+        std::thread writer([&] {
+            auto next = std::make_unique<Metrics::Snapshot>();
+            for (int i = 0; i < 20000; ++i) {
+                next->cpuUsage = i;
+                next->ramUsage = i;
+                publisher.publish(*next);
+            }
+        });
+        int torn = 0;
+        for (int i = 0; i < 2000; ++i) {
+            if (reader.read(*snapshot, &error) && snapshot->cpuUsage != snapshot->ramUsage) {
+                ++torn;
+            }
+        }
+        writer.join();
+        CHECK(torn == 0);
+    }
+#endif
+
+    void testTimerWheel() {
+        Scheduler::TimerWheel wheel(5, 8);
+        int once = 0;
+        int everyTwo = 0;
+        int slow = 0;
+        wheel.add("once", 0, 1, [&] { ++once; });
+        wheel.add("every_two", 10, 5, [&] { ++everyTwo; });
+        wheel.add("slow", 20, 1, [&] {
+            ++slow;
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        });
+        for (int i = 0; i < 24; ++i) {
+            wheel.tick();
+        }
+        CHECK(once == 1);
+        CHECK(everyTwo >= 12);
+        // Deadlines advance by the period, so the ratio holds even when ticks are caught up
+        CHECK(std::abs(everyTwo - 2 * slow) <= 2);
+
+        for (const auto& stats : wheel.stats()) {
+            if (stats.name == "slow") {
+                CHECK(stats.runs == static_cast<uint64_t>(slow));
+                CHECK(stats.overruns == stats.runs);
+                CHECK(stats.maxMs >= 3.0);
+            } else if (stats.name == "once") {
+                CHECK(stats.periodMs == 0);
+            }
+        }
+    }
+
+    struct Test {
+        const char* name;
+        void (*run)();
+    };
+
+    const Test kTests[] = {
+        { "parser/manifest_line", testManifestLine },
+        { "parser/manifest_versions", testManifestVersions },
+        { "parser/parse_rate", testParseRate },
+        { "parser/health_config", testHealthConfig },
+#ifndef _WIN32
+        { "parser/proc_fixtures", testProcFixtures },
+        { "parser/net_dev_rows", testNetDevRows },
+        { "sensors/registry", testSensorsRegistry },
+#endif
+        { "health/idle", testHealthIdle },
+        { "health/veto", testHealthVeto },
+        { "health/boundaries", testHealthBoundaries },
+        { "scan/mounts", testScanMounts },
+        { "scan/thermal_throttling", testScanThermalThrottling },
+        { "scan/rates_ready", testScanRatesReady },
+        { "integrity/sha256", testSha256 },
+        { "integrity/fingerprint", testFingerprint },
+        { "integrity/check_detects_changes", testCheckDetectsChanges },
+        { "integrity/journal_replay", testJournalReplay },
+        { "integrity/journal_hardlink_resume", testJournalHardLinkResume },
+        { "integrity/journal_rejected", testJournalRejected },
+        { "integrity/check_manifests_pool", testCheckManifestsPool },
+        { "fleet/aggregate", testFleetAggregate },
+#ifndef _WIN32
+        { "shm/seqlock", testSeqlock },
+#endif
+        { "scheduler/timer_wheel", testTimerWheel },
+    };
+
+    bool makeScratch() {
+        std::error_code ec;
+        uint64_t stamp = static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            fs::path candidate = fs::temp_directory_path() / ("sit_tests-" + std::to_string(stamp + attempt));
+            if (fs::create_directory(candidate, ec)) {
+                scratch = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void printUsage() {
+        std::cout << "Usage: sit_tests [options]\n"
+                  << "  --filter <text>      Run only tests whose name contains text\n"
+                  << "  --fixtures <dir>     Recorded /proc and /sys root (default bench/fixtures/linux-vm)\n";
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--fixtures" && i + 1 < argc) {
+            options.fixtures = argv[++i];
+        } else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (!makeScratch()) {
+        std::cerr << "Cannot create a scratch directory" << std::endl;
+        return 1;
+    }
+
+    int ran = 0;
+    int failed = 0;
+    for (const Test& test : kTests) {
+        if (!options.filter.empty() && std::string(test.name).find(options.filter) == std::string::npos) {
+            continue;
+        }
+        int before = failures;
+        test.run();
+        ++ran;
+        bool ok = failures == before;
+        failed += ok ? 0 : 1;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << test.name << std::endl;
+    }
+
+    std::error_code ec;
+    fs::remove_all(scratch, ec);
+    std::cout << ran - failed << "/" << ran << " tests passed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}